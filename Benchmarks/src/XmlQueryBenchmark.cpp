@@ -0,0 +1,361 @@
+/*
+ * XmlQueryBenchmark.cpp
+ *
+ * Answers the same path queries over the same XML corpus with the
+ * transducer pipeline at 1..N threads, both returning all matches and
+ * streaming them a window at a time, at N threads with every block
+ * tokenized in K = 1..8 interleaved chunks (xml_query::set_streams),
+ * and, when built with pugixml, with a DOM parse plus XPath and with a
+ * parse plus tree walk. Every method runs in its own child process so
+ * that the reported peak memory is its own. The time to the first
+ * result is when the first match is handed to the caller: once the
+ * whole run returns for the collecting pipeline, on the first callback
+ * for the streaming one, and once the first query with any match is
+ * evaluated or the walk reaches the first match for pugixml. The
+ * pipeline queries are compiled before the timed run, and a run that
+ * fails is reported as such instead of ending the benchmark. Elements
+ * matching several queries are counted once per query.
+ *
+ * Usage: XmlQueryBenchmark [options] [query...]
+ *   --file PATH       corpus to query (mapped into memory)
+ *   --generate MB     generate a synthetic corpus of about MB megabytes
+ *   --threads N       run the pipeline with 1, 2, 4 .. N threads
+ *   --window MB       stream the pipeline matches MB megabytes at a time
+ *   --check           exit with 1 if the best parallel run is slower than
+ *                     the single threaded run or a pugixml baseline
+ */
+
+#include <pipelines/xml_query.h>
+
+#ifdef HAVE_PUGIXML
+#include <pugixml.hpp>
+#endif
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock clock_type;
+
+double seconds_since(clock_type::time_point start) {
+	return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+struct corpus {
+	const char* data = nullptr;
+	std::size_t size = 0;
+	std::string generated;
+};
+
+void map_file(corpus& c, const std::string& filename) {
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd == -1) {
+		throw std::runtime_error("Cannot open " + filename);
+	}
+	struct stat st;
+	if (fstat(fd, &st) == -1 || st.st_size == 0) {
+		close(fd);
+		throw std::runtime_error("Cannot map " + filename);
+	}
+	void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED) {
+		throw std::runtime_error("Cannot map " + filename);
+	}
+	c.data = static_cast<const char*>(addr);
+	c.size = st.st_size;
+}
+
+void generate(corpus& c, std::size_t megabytes) {
+	std::string& doc = c.generated;
+	doc.reserve(megabytes << 20);
+	doc += "<?xml version=\"1.0\"?>\n<catalog>\n";
+	for (std::size_t i = 0; doc.size() < (megabytes << 20); ++i) {
+		doc += " <book id=\"" + std::to_string(i) + "\" lang='en'>\n";
+		doc += "  <title>Title " + std::to_string(i) + "</title>\n";
+		doc += "  <author>Author " + std::to_string(i % 97) + "</author>\n";
+		doc += "  <price>" + std::to_string(i % 50) + ".99</price>\n";
+		doc += "  <notes><note>first</note><!-- <note>hidden</note> --><note/></notes>\n";
+		doc += " </book>\n";
+	}
+	doc += "</catalog>\n";
+	c.data = doc.data();
+	c.size = doc.size();
+}
+
+struct measurement {
+	std::string method;
+	std::size_t threads = 1;
+	bool failed = false;
+	double seconds = 0;
+	double first_result = -1;
+	long peak_kb = 0;
+	std::size_t matches = 0;
+};
+
+// Runs fn in a child process, which reports back the time to its first
+// result, or -1 without one, and the number of matches, and adds the run
+// time and peak resident set size of the child
+measurement measure(const std::string& method, std::size_t threads,
+		const std::function<std::pair<double, std::size_t>(clock_type::time_point)>& fn) {
+	int fds[2];
+	if (pipe(fds) == -1) {
+		throw std::runtime_error("Cannot create a pipe");
+	}
+	// Output still buffered would be written again by the child
+	std::fflush(stdout);
+	pid_t pid = fork();
+	if (pid == -1) {
+		throw std::runtime_error("Cannot fork");
+	}
+	if (pid == 0) {
+		close(fds[0]);
+		auto start = clock_type::now();
+		std::pair<double, std::size_t> result;
+		try {
+			result = fn(start);
+		} catch (const std::exception& e) {
+			std::cerr << method << ": " << e.what() << std::endl;
+			_exit(1);
+		}
+		double total = seconds_since(start);
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		std::ostringstream stream;
+		stream << total << " " << result.first << " " << usage.ru_maxrss << " " << result.second;
+		std::string line = stream.str();
+		ssize_t written = write(fds[1], line.data(), line.size());
+		_exit(written == static_cast<ssize_t>(line.size()) ? 0 : 1);
+	}
+	close(fds[1]);
+	std::string line;
+	char buffer[256];
+	ssize_t n;
+	while ((n = read(fds[0], buffer, sizeof(buffer))) > 0) {
+		line.append(buffer, n);
+	}
+	close(fds[0]);
+	int status;
+	measurement m;
+	m.method = method;
+	m.threads = threads;
+	std::istringstream stream(line);
+	m.failed = waitpid(pid, &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0 ||
+		!(stream >> m.seconds >> m.first_result >> m.peak_kb >> m.matches);
+	return m;
+}
+
+void report(const measurement& m, std::size_t bytes) {
+	if (m.failed) {
+		std::printf("%-20s %7zu %10s\n", m.method.c_str(), m.threads, "failed");
+	} else {
+		char first[32] = "-";
+		if (m.first_result >= 0) std::snprintf(first, sizeof(first), "%.3f", m.first_result);
+		std::printf("%-20s %7zu %10.3f %10.1f %12s %12ld %10zu\n",
+			m.method.c_str(), m.threads, m.seconds, bytes / m.seconds / (1 << 20),
+			first, m.peak_kb, m.matches);
+	}
+	std::fflush(stdout);
+}
+
+#ifdef HAVE_PUGIXML
+// The same path syntax as path_query_compiler, evaluated on the names of
+// an element and its ancestors
+struct path_step {
+	bool descendant;
+	std::string name;
+};
+
+std::vector<path_step> parse_path(const std::string& path) {
+	std::vector<path_step> ret;
+	std::size_t pos = 0;
+	while (pos < path.size()) {
+		path_step s;
+		s.descendant = path.compare(pos, 2, "//") == 0;
+		pos += s.descendant ? 2 : 1;
+		std::size_t end = std::min(path.find('/', pos), path.size());
+		s.name = path.substr(pos, end - pos);
+		ret.push_back(s);
+		pos = end;
+	}
+	return ret;
+}
+
+bool path_matches(const std::vector<path_step>& steps, std::size_t step,
+		const std::vector<const char*>& names, std::size_t depth) {
+	if (step == steps.size()) return depth == names.size();
+	if (depth == names.size()) return false;
+	const path_step& s = steps[step];
+	for (std::size_t d = depth; d < names.size(); ++d) {
+		if ((s.name == "*" || s.name == names[d]) && path_matches(steps, step + 1, names, d + 1)) {
+			return true;
+		}
+		if (!s.descendant) break;
+	}
+	return false;
+}
+
+class path_walker : public pugi::xml_tree_walker {
+public:
+	path_walker(const std::vector<std::string>& paths, clock_type::time_point start):
+		m_start(start) {
+		for (const auto& p: paths) m_paths.push_back(parse_path(p));
+	}
+	bool for_each(pugi::xml_node& node) override {
+		if (node.type() != pugi::node_element) return true;
+		m_names.resize(depth() + 1);
+		m_names.back() = node.name();
+		for (const auto& p: m_paths) {
+			if (path_matches(p, 0, m_names, 0) && matches++ == 0) {
+				first_result = seconds_since(m_start);
+			}
+		}
+		return true;
+	}
+	std::size_t matches = 0;
+	double first_result = -1;
+private:
+	std::vector<std::vector<path_step>> m_paths;
+	std::vector<const char*> m_names;
+	clock_type::time_point m_start;
+};
+#endif
+
+}
+
+int main(int argc, char** argv)
+{
+	corpus c;
+	std::size_t max_threads = std::thread::hardware_concurrency();
+	std::size_t window = 1 << 20;
+	bool check = false;
+	std::vector<std::string> paths;
+	try {
+		for (int i = 1; i < argc; ++i) {
+			std::string arg = argv[i];
+			if (arg == "--file" && i + 1 < argc) {
+				map_file(c, argv[++i]);
+			} else if (arg == "--generate" && i + 1 < argc) {
+				generate(c, std::strtoul(argv[++i], nullptr, 10));
+			} else if (arg == "--threads" && i + 1 < argc) {
+				max_threads = std::strtoul(argv[++i], nullptr, 10);
+			} else if (arg == "--window" && i + 1 < argc) {
+				window = std::strtoul(argv[++i], nullptr, 10) << 20;
+			} else if (arg == "--check") {
+				check = true;
+			} else {
+				paths.push_back(arg);
+			}
+		}
+		if (c.data == nullptr) generate(c, 64);
+		if (paths.empty()) {
+			paths = { "/catalog/book/title", "//note", "/catalog/*/price" };
+		}
+		if (max_threads == 0) max_threads = 1;
+
+		std::printf("%-20s %7s %10s %10s %12s %12s %10s\n",
+			"method", "threads", "seconds", "MB/s", "first (s)", "peak (kB)", "matches");
+
+		pipelines::xml_query query(paths);
+		std::vector<measurement> pipeline;
+		for (std::size_t threads = 1; ; threads = std::min(threads * 2, max_threads)) {
+			pipeline.push_back(measure("transducers", threads, [&](clock_type::time_point start) {
+				std::size_t matches = query.run(c.data, c.size, threads).size();
+				// Matches are only returned once every block is merged
+				return std::make_pair(matches == 0 ? -1 : seconds_since(start), matches);
+			}));
+			report(pipeline.back(), c.size);
+			if (threads == max_threads) break;
+		}
+		for (std::size_t threads = 1; ; threads = std::min(threads * 2, max_threads)) {
+			report(measure("transducers-stream", threads, [&](clock_type::time_point start) {
+				double first_result = -1;
+				std::size_t matches = query.run(c.data, c.size, threads, window, [&](const symbols::match&) {
+					if (first_result < 0) first_result = seconds_since(start);
+				});
+				return std::make_pair(first_result, matches);
+			}), c.size);
+			if (threads == max_threads) break;
+		}
+		for (std::size_t streams = 1; streams <= 8; ++streams) {
+			query.set_streams(streams);
+			report(measure("interleaved K=" + std::to_string(streams), max_threads,
+					[&](clock_type::time_point start) {
+				std::size_t matches = query.run(c.data, c.size, max_threads).size();
+				return std::make_pair(matches == 0 ? -1 : seconds_since(start), matches);
+			}), c.size);
+		}
+		query.set_streams(1);
+
+		std::vector<measurement> baselines;
+#ifdef HAVE_PUGIXML
+		baselines.push_back(measure("pugixml-xpath", 1, [&](clock_type::time_point start) {
+			pugi::xml_document doc;
+			if (!doc.load_buffer(c.data, c.size)) throw std::runtime_error("Cannot parse the corpus");
+			std::size_t matches = 0;
+			double first_result = -1;
+			for (const auto& p: paths) {
+				matches += doc.select_nodes(p.c_str()).size();
+				if (matches > 0 && first_result < 0) first_result = seconds_since(start);
+			}
+			return std::make_pair(first_result, matches);
+		}));
+		report(baselines.back(), c.size);
+
+		baselines.push_back(measure("pugixml-walk", 1, [&](clock_type::time_point start) {
+			pugi::xml_document doc;
+			if (!doc.load_buffer(c.data, c.size, pugi::parse_minimal)) throw std::runtime_error("Cannot parse the corpus");
+			path_walker walker(paths, start);
+			doc.traverse(walker);
+			return std::make_pair(walker.first_result, walker.matches);
+		}));
+		report(baselines.back(), c.size);
+#else
+		std::printf("pugixml baselines skipped, pugixml was not found at configure time\n");
+#endif
+
+		if (check) {
+			for (const auto& m: pipeline) {
+				if (m.failed) {
+					std::printf("FAILED: the pipeline run with %zu threads failed\n", m.threads);
+					return 1;
+				}
+			}
+			const measurement* best = &pipeline.back();
+			for (const auto& m: pipeline) {
+				if (m.threads > 1 && m.seconds < best->seconds) best = &m;
+			}
+			bool ok = best->seconds <= pipeline.front().seconds;
+			for (const auto& b: baselines) {
+				ok = ok && (b.failed || best->seconds <= b.seconds);
+			}
+			if (!ok) {
+				std::printf("REGRESSION: the best pipeline run (%zu threads) is slower than a baseline\n",
+					best->threads);
+				return 1;
+			}
+		}
+	} catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,153 @@
+#ifndef DATA_STRUCTURES_CHUNK_LIST_H_
+#define DATA_STRUCTURES_CHUNK_LIST_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace data_structures {
+
+/** class chunk_list
+ *
+ * A sequence stored as a list of segments, so appending another list
+ * shares its segments instead of copying its elements. Shared segments
+ * are never written to again: push_back() starts a new segment when the
+ * last one is also held by another list. Lists shorter than copy_limit
+ * are copied into the last segment instead, to keep the segment count
+ * down when many small results are merged.
+ */
+template <typename T>
+class chunk_list {
+public:
+	typedef T value_type;
+	typedef std::vector<T> segment;
+
+	static const std::size_t copy_limit = 64;
+
+	class const_iterator {
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef T value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const T* pointer;
+		typedef const T& reference;
+
+		const_iterator() = default;
+
+		reference operator*() const { return (*(*m_segment))[m_index]; }
+		pointer operator->() const { return &**this; }
+
+		const_iterator& operator++() {
+			if (++m_index == (*m_segment)->size()) {
+				++m_segment;
+				m_index = 0;
+				skip_empty();
+			}
+			return *this;
+		}
+		const_iterator operator++(int) {
+			const_iterator ret = *this;
+			++*this;
+			return ret;
+		}
+
+		bool operator==(const const_iterator& other) const {
+			return m_segment == other.m_segment && m_index == other.m_index;
+		}
+		bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+	private:
+		friend class chunk_list;
+		typedef typename std::vector<std::shared_ptr<segment>>::const_iterator segment_iterator;
+
+		const_iterator(segment_iterator s, segment_iterator end):
+			m_segment(s),
+			m_end(end) {
+			skip_empty();
+		}
+
+		void skip_empty() {
+			while (m_segment != m_end && (*m_segment)->empty()) ++m_segment;
+		}
+
+		segment_iterator m_segment;
+		segment_iterator m_end;
+		std::size_t m_index = 0;
+	};
+	typedef const_iterator iterator;
+
+	void push_back(const T& value) {
+		writable().push_back(value);
+		++m_size;
+	}
+
+	void append(const chunk_list& other) {
+		if (other.m_size < copy_limit) {
+			segment& last = writable();
+			for (const auto& s: other.m_segments) {
+				last.insert(last.end(), s->begin(), s->end());
+			}
+		} else {
+			for (const auto& s: other.m_segments) {
+				if (!s->empty()) m_segments.push_back(s);
+			}
+		}
+		m_size += other.m_size;
+	}
+
+	std::size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+	std::size_t num_segments() const { return m_segments.size(); }
+
+	const_iterator begin() const { return const_iterator(m_segments.begin(), m_segments.end()); }
+	const_iterator end() const { return const_iterator(m_segments.end(), m_segments.end()); }
+
+	// Copies the elements into one vector
+	std::vector<T> flatten() const {
+		std::vector<T> ret;
+		ret.reserve(m_size);
+		for (const auto& s: m_segments) {
+			ret.insert(ret.end(), s->begin(), s->end());
+		}
+		return ret;
+	}
+
+	// Bytes of every segment this list refers to, including shared ones
+	std::size_t heap_usage() const {
+		std::size_t ret = m_segments.capacity() * sizeof(std::shared_ptr<segment>);
+		for (const auto& s: m_segments) {
+			ret += sizeof(segment) + s->capacity() * sizeof(T);
+		}
+		return ret;
+	}
+
+	bool operator==(const chunk_list& other) const {
+		return m_size == other.m_size && std::equal(begin(), end(), other.begin());
+	}
+
+private:
+	segment& writable() {
+		if (m_segments.empty() || m_segments.back().use_count() > 1) {
+			m_segments.push_back(std::make_shared<segment>());
+		}
+		return *m_segments.back();
+	}
+
+	std::vector<std::shared_ptr<segment>> m_segments;
+	std::size_t m_size = 0;
+};
+
+template <typename T>
+const std::size_t chunk_list<T>::copy_limit;
+
+// Picked up by util::memory_usage through argument dependent lookup
+template <typename T>
+std::size_t heap_usage(const chunk_list<T>& list) {
+	return list.heap_usage();
+}
+
+}
+
+#endif
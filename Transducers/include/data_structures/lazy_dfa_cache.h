@@ -0,0 +1,189 @@
+#ifndef DATA_STRUCTURES_LAZY_DFA_CACHE_H_
+#define DATA_STRUCTURES_LAZY_DFA_CACHE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include <representation/symbol_classes.h>
+#include <representation/transition_description.h>
+
+namespace data_structures {
+
+/** class lazy_dfa_cache
+ *
+ * Determinises an nfa_description on demand. Each DFA state is a set
+ * of NFA states and is only built the first time a transition reaches
+ * it, after which the edge is cached. Following a cached edge is a
+ * single atomic load, so many threads can share one cache and only
+ * take the lock on a miss.
+ *
+ * The cache holds at most max_states states. When it fills up it
+ * starts a new generation instead of evicting states one by one.
+ * Positions keep their generation alive, so a thread still inside an
+ * old generation carries on safely and moves to the current one on
+ * its next miss.
+ */
+class lazy_dfa_cache {
+public:
+	struct state {
+		std::vector<int> nfa_states;
+		std::vector<int> outputs;
+		std::unique_ptr<std::atomic<const state*>[]> next;
+	};
+
+	class generation {
+		std::deque<state> m_states;
+		std::map<std::vector<int>, const state*> m_index;
+		friend class lazy_dfa_cache;
+	public:
+		std::size_t size() const { return m_states.size(); }
+	};
+
+	struct position {
+		std::shared_ptr<generation> gen;
+		const state* current = nullptr;
+	};
+
+	explicit lazy_dfa_cache(const representation::nfa_description& nfa, std::size_t max_states = 4096):
+		m_max_states(std::max<std::size_t>(max_states, 2)),
+		m_classes(nfa.transitions) {
+		if (nfa.start_state < 0) {
+			throw std::invalid_argument("Lazy DFAs require non-negative state ids");
+		}
+		int max_state = nfa.start_state;
+		for (const auto& p: nfa.transitions) {
+			if (p.first.first < 0 || p.second < 0) {
+				throw std::invalid_argument("Lazy DFAs require non-negative state ids");
+			}
+			max_state = std::max({ max_state, p.first.first, p.second });
+		}
+		m_num_states = max_state + 1;
+
+		std::vector<std::vector<int>> targets(m_num_states * m_classes.size());
+		for (const auto& p: nfa.transitions) {
+			if (m_classes.is_representative(p.first.second)) {
+				targets[p.first.first * m_classes.size() + m_classes(p.first.second)].push_back(p.second);
+			}
+		}
+		m_target_offsets.push_back(0);
+		for (auto& t: targets) {
+			std::sort(t.begin(), t.end());
+			t.erase(std::unique(t.begin(), t.end()), t.end());
+			m_targets.insert(m_targets.end(), t.begin(), t.end());
+			m_target_offsets.push_back(m_targets.size());
+		}
+		for (const auto& p: nfa.output) {
+			m_outputs.emplace(p.first, p.second);
+		}
+
+		m_current = std::make_shared<generation>();
+		m_start_set.push_back(nfa.start_state);
+	}
+
+	position start() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		position p;
+		p.gen = m_current;
+		p.current = intern(*p.gen, m_start_set);
+		return p;
+	}
+
+	// Advances p over symbol and returns the state it is now in
+	const state* step(position& p, unsigned int symbol) {
+		unsigned int cls = m_classes(symbol);
+		const state* n = p.current->next[cls].load(std::memory_order_acquire);
+		if (n == nullptr) {
+			n = miss(p, cls);
+		}
+		p.current = n;
+		return n;
+	}
+
+	std::size_t num_classes() const { return m_classes.size(); }
+	std::size_t max_states() const { return m_max_states; }
+	std::size_t flushes() const {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_flushes;
+	}
+	std::size_t size() const {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_current->size();
+	}
+
+private:
+	const state* miss(position& p, unsigned int cls) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (p.gen != m_current) {
+			p.current = intern(*m_current, p.current->nfa_states);
+			p.gen = m_current;
+		}
+		const state* n = p.current->next[cls].load(std::memory_order_acquire);
+		if (n != nullptr) return n;
+
+		std::vector<int> target_set;
+		for (int s: p.current->nfa_states) {
+			std::size_t index = s * m_classes.size() + cls;
+			target_set.insert(target_set.end(), m_targets.begin() + m_target_offsets[index],
+				m_targets.begin() + m_target_offsets[index + 1]);
+		}
+		std::sort(target_set.begin(), target_set.end());
+		target_set.erase(std::unique(target_set.begin(), target_set.end()), target_set.end());
+
+		if (m_current->size() + 1 >= m_max_states &&
+				m_current->m_index.find(target_set) == m_current->m_index.end()) {
+			m_current = std::make_shared<generation>();
+			++m_flushes;
+			p.current = intern(*m_current, p.current->nfa_states);
+			p.gen = m_current;
+		}
+		n = intern(*m_current, target_set);
+		p.current->next[cls].store(n, std::memory_order_release);
+		return n;
+	}
+
+	const state* intern(generation& g, const std::vector<int>& nfa_states) {
+		auto find_iter = g.m_index.find(nfa_states);
+		if (find_iter != g.m_index.end()) return find_iter->second;
+
+		g.m_states.emplace_back();
+		state& s = g.m_states.back();
+		s.nfa_states = nfa_states;
+		for (int n: nfa_states) {
+			auto range = m_outputs.equal_range(n);
+			for (auto iter = range.first; iter != range.second; ++iter) {
+				s.outputs.push_back(iter->second);
+			}
+		}
+		std::sort(s.outputs.begin(), s.outputs.end());
+		s.outputs.erase(std::unique(s.outputs.begin(), s.outputs.end()), s.outputs.end());
+		s.next.reset(new std::atomic<const state*>[m_classes.size()]);
+		for (std::size_t i = 0; i < m_classes.size(); ++i) {
+			s.next[i].store(nullptr, std::memory_order_relaxed);
+		}
+		g.m_index.emplace(nfa_states, &s);
+		return &s;
+	}
+
+	std::size_t m_max_states;
+	representation::symbol_classes m_classes;
+	std::size_t m_num_states;
+	std::vector<std::size_t> m_target_offsets;
+	std::vector<int> m_targets;
+	std::multimap<int, int> m_outputs;
+	std::vector<int> m_start_set;
+
+	mutable std::mutex m_mutex;
+	std::shared_ptr<generation> m_current;
+	std::size_t m_flushes = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,213 @@
+#ifndef DATA_STRUCTURES_MATCH_COLUMNS_H_
+#define DATA_STRUCTURES_MATCH_COLUMNS_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <symbols/match.h>
+
+namespace data_structures {
+
+namespace detail {
+
+// Layout of a file written by match_columns::save(). Each column starts
+// on a 64 byte boundary, the alignment Arrow expects of its buffers.
+struct match_columns_header {
+	char magic[4];
+	uint32_t byte_order;
+	uint32_t version;
+	uint32_t reserved;
+	uint64_t count;
+	uint64_t rules;
+	uint64_t starts;
+	uint64_t ends;
+	uint64_t total_size;
+	uint64_t padding;
+
+	static const uint32_t format_version = 1;
+	static const uint32_t byte_order_mark = 0x01020304;
+
+	static std::size_t align(std::size_t s) { return (s + 63) & ~std::size_t(63); }
+
+	explicit match_columns_header(std::size_t n = 0) {
+		std::memset(this, 0, sizeof(*this));
+		std::memcpy(magic, "ATMC", 4);
+		byte_order = byte_order_mark;
+		version = format_version;
+		count = n;
+		rules = align(sizeof(*this));
+		starts = align(rules + n * sizeof(uint32_t));
+		ends = align(starts + n * sizeof(uint64_t));
+		total_size = align(ends + n * sizeof(uint64_t));
+	}
+};
+
+}
+
+/** class match_columns
+ *
+ * Matches stored as three columns, the rules as 32 bit values and the
+ * start and end offsets as 64 bit values, so a consumer taking columns
+ * can use them as they are. save() writes the columns through a shared
+ * mapping of the output file, and match_columns_file maps such a file
+ * back without reading it.
+ */
+class match_columns {
+public:
+	// Throws std::out_of_range for a rule wider than the 32 bit column
+	void push_back(const symbols::match& m) {
+		if (m.rule > std::numeric_limits<uint32_t>::max()) {
+			throw std::out_of_range("Match rule does not fit in the rule column");
+		}
+		m_rules.push_back(m.rule);
+		m_starts.push_back(m.start_offset);
+		m_ends.push_back(m.end_offset);
+	}
+
+	void append(const match_columns& other) {
+		m_rules.insert(m_rules.end(), other.m_rules.begin(), other.m_rules.end());
+		m_starts.insert(m_starts.end(), other.m_starts.begin(), other.m_starts.end());
+		m_ends.insert(m_ends.end(), other.m_ends.begin(), other.m_ends.end());
+	}
+
+	std::size_t size() const { return m_rules.size(); }
+	bool empty() const { return m_rules.empty(); }
+
+	symbols::match operator[](std::size_t i) const {
+		return symbols::match(m_rules[i], m_starts[i], m_ends[i]);
+	}
+
+	const std::vector<uint32_t>& rules() const { return m_rules; }
+	const std::vector<uint64_t>& starts() const { return m_starts; }
+	const std::vector<uint64_t>& ends() const { return m_ends; }
+
+	std::vector<symbols::match> matches() const {
+		std::vector<symbols::match> ret;
+		ret.reserve(size());
+		for (std::size_t i = 0; i < size(); ++i) ret.push_back((*this)[i]);
+		return ret;
+	}
+
+	// Bytes owned outside of the object itself
+	std::size_t heap_usage() const {
+		return m_rules.capacity() * sizeof(uint32_t) +
+			(m_starts.capacity() + m_ends.capacity()) * sizeof(uint64_t);
+	}
+
+	void save(const std::string& filename) const {
+		detail::match_columns_header h(size());
+		int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0) {
+			throw std::runtime_error("Unable to create match columns: " + filename);
+		}
+		if (::ftruncate(fd, h.total_size) != 0) {
+			::close(fd);
+			throw std::runtime_error("Unable to size match columns: " + filename);
+		}
+		void* addr = ::mmap(nullptr, h.total_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		::close(fd);
+		if (addr == MAP_FAILED) {
+			throw std::runtime_error("Unable to map match columns: " + filename);
+		}
+		char* data = static_cast<char*>(addr);
+		std::memcpy(data, &h, sizeof(h));
+		// The columns of an empty set may have no data() to copy from
+		if (!empty()) {
+			std::memcpy(data + h.rules, m_rules.data(), size() * sizeof(uint32_t));
+			std::memcpy(data + h.starts, m_starts.data(), size() * sizeof(uint64_t));
+			std::memcpy(data + h.ends, m_ends.data(), size() * sizeof(uint64_t));
+		}
+		::munmap(addr, h.total_size);
+	}
+
+	bool operator==(const match_columns& other) const {
+		return m_rules == other.m_rules && m_starts == other.m_starts && m_ends == other.m_ends;
+	}
+
+private:
+	std::vector<uint32_t> m_rules;
+	std::vector<uint64_t> m_starts;
+	std::vector<uint64_t> m_ends;
+};
+
+/** class match_columns_file
+ *
+ * Read only view of a file written by match_columns::save(). The file
+ * is mapped rather than read, and the columns point into the mapping,
+ * which copies share.
+ */
+class match_columns_file {
+public:
+	explicit match_columns_file(const std::string& filename) {
+		int fd = ::open(filename.c_str(), O_RDONLY);
+		if (fd < 0) {
+			throw std::runtime_error("Unable to open match columns: " + filename);
+		}
+		struct stat st;
+		if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(header))) {
+			::close(fd);
+			throw std::runtime_error("Match columns too small: " + filename);
+		}
+		std::size_t size = st.st_size;
+		void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (addr == MAP_FAILED) {
+			throw std::runtime_error("Unable to map match columns: " + filename);
+		}
+		m_data = std::shared_ptr<const char>(static_cast<const char*>(addr),
+			[size](const char* p) { ::munmap(const_cast<char*>(p), size); });
+
+		const header* h = reinterpret_cast<const header*>(m_data.get());
+		if (std::memcmp(h->magic, "ATMC", 4) != 0) {
+			throw std::runtime_error("Not a match columns file: " + filename);
+		}
+		if (h->byte_order != header::byte_order_mark || h->version != header::format_version) {
+			throw std::runtime_error("Unsupported match columns file: " + filename);
+		}
+		header expected(h->count);
+		if (h->total_size != expected.total_size || size < expected.total_size) {
+			throw std::runtime_error("Match columns file is truncated: " + filename);
+		}
+		m_size = h->count;
+		m_rules = reinterpret_cast<const uint32_t*>(m_data.get() + expected.rules);
+		m_starts = reinterpret_cast<const uint64_t*>(m_data.get() + expected.starts);
+		m_ends = reinterpret_cast<const uint64_t*>(m_data.get() + expected.ends);
+	}
+
+	std::size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+
+	symbols::match operator[](std::size_t i) const {
+		assert(i < m_size);
+		return symbols::match(m_rules[i], m_starts[i], m_ends[i]);
+	}
+
+	const uint32_t* rules() const { return m_rules; }
+	const uint64_t* starts() const { return m_starts; }
+	const uint64_t* ends() const { return m_ends; }
+
+private:
+	typedef detail::match_columns_header header;
+
+	std::shared_ptr<const char> m_data;
+	std::size_t m_size = 0;
+	const uint32_t* m_rules = nullptr;
+	const uint64_t* m_starts = nullptr;
+	const uint64_t* m_ends = nullptr;
+};
+
+}
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef DATA_STRUCTURES_MATCH_LIST_H_
+#define DATA_STRUCTURES_MATCH_LIST_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <symbols/match.h>
+
+namespace data_structures {
+
+/** class match_list
+ *
+ * A sequence of symbols::match stored in twelve bytes each rather than
+ * twenty four: a 32 bit rule and both offsets as signed 32 bit deltas
+ * from the base of their segment, with one delta value kept for npos.
+ * Matches arrive ordered by their end, so a start may lie well before
+ * earlier matches and deltas go both ways. A new segment is only
+ * started once a delta no longer fits, and appending another list
+ * rebases its first segment onto the last one of this list where
+ * possible, like offset_index. Matches spanning more than 2GB, or with
+ * a rule wider than 32 bits, are kept whole.
+ */
+class match_list {
+public:
+	typedef int32_t delta_type;
+
+	void push_back(const symbols::match& m) {
+		std::size_t anchor = m.end_offset != symbols::match::npos ? m.end_offset : m.start_offset;
+		if (anchor == symbols::match::npos) anchor = 0;
+		if (!fits(anchor, m)) {
+			if (m_segments.empty() || !m_segments.back().entries.empty()) {
+				m_segments.push_back(segment{ 0, {}, {} });
+			}
+			m_segments.back().wide.push_back(m);
+			++m_size;
+			return;
+		}
+		if (m_segments.empty() || !m_segments.back().wide.empty() || !fits(m_segments.back().base, m)) {
+			m_segments.push_back(segment{ anchor, {}, {} });
+		}
+		const std::size_t base = m_segments.back().base;
+		m_segments.back().entries.push_back(entry{ static_cast<uint32_t>(m.rule),
+			encode(base, m.start_offset), encode(base, m.end_offset) });
+		++m_size;
+	}
+
+	void append(const match_list& other) {
+		auto iter = other.m_segments.begin();
+		if (iter != other.m_segments.end() && !m_segments.empty() &&
+				iter->wide.empty() && m_segments.back().wide.empty()) {
+			auto& last = m_segments.back();
+			bool rebase = true;
+			for (const entry& e: iter->entries) {
+				rebase = rebase && fits(last.base, decode(iter->base, e));
+			}
+			if (rebase) {
+				for (const entry& e: iter->entries) {
+					symbols::match m = decode(iter->base, e);
+					last.entries.push_back(entry{ e.rule, encode(last.base, m.start_offset),
+						encode(last.base, m.end_offset) });
+				}
+				++iter;
+			}
+		}
+		m_segments.insert(m_segments.end(), iter, other.m_segments.end());
+		m_size += other.m_size;
+	}
+
+	std::size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+
+	symbols::match operator[](std::size_t i) const {
+		for (const auto& s: m_segments) {
+			if (i < s.entries.size()) return decode(s.base, s.entries[i]);
+			if (i < s.wide.size()) return s.wide[i];
+			i -= s.entries.size() + s.wide.size();
+		}
+		assert(false);
+		return symbols::match();
+	}
+
+	// Calls fn with every match in order
+	template <typename Fn>
+	void for_each(const Fn& fn) const {
+		for (const auto& s: m_segments) {
+			for (const entry& e: s.entries) fn(decode(s.base, e));
+			for (const symbols::match& m: s.wide) fn(m);
+		}
+	}
+
+	std::vector<symbols::match> matches() const {
+		std::vector<symbols::match> ret;
+		ret.reserve(m_size);
+		for_each([&](const symbols::match& m) { ret.push_back(m); });
+		return ret;
+	}
+
+	std::size_t num_segments() const { return m_segments.size(); }
+
+	// Bytes owned outside of the object itself
+	std::size_t heap_usage() const {
+		std::size_t ret = m_segments.capacity() * sizeof(segment);
+		for (const auto& s: m_segments) {
+			ret += s.entries.capacity() * sizeof(entry) + s.wide.capacity() * sizeof(symbols::match);
+		}
+		return ret;
+	}
+
+	bool operator==(const match_list& other) const {
+		return m_size == other.m_size && matches() == other.matches();
+	}
+
+private:
+	static const delta_type npos_delta = std::numeric_limits<delta_type>::min();
+
+	struct entry {
+		uint32_t rule;
+		delta_type start;
+		delta_type end;
+	};
+	// A segment holds either entries or, for the rare match longer than
+	// a delta can span, the match itself in wide
+	struct segment {
+		std::size_t base;
+		std::vector<entry> entries;
+		std::vector<symbols::match> wide;
+	};
+
+	static bool fits(std::size_t base, std::size_t offset) {
+		if (offset == symbols::match::npos) return true;
+		return offset >= base ?
+			offset - base <= static_cast<std::size_t>(std::numeric_limits<delta_type>::max()) :
+			base - offset < static_cast<std::size_t>(-static_cast<int64_t>(npos_delta));
+	}
+	static bool fits(std::size_t base, const symbols::match& m) {
+		return m.rule <= std::numeric_limits<uint32_t>::max() &&
+			fits(base, m.start_offset) && fits(base, m.end_offset);
+	}
+
+	static delta_type encode(std::size_t base, std::size_t offset) {
+		if (offset == symbols::match::npos) return npos_delta;
+		return static_cast<delta_type>(static_cast<int64_t>(offset - base));
+	}
+	static std::size_t decode(std::size_t base, delta_type delta) {
+		if (delta == npos_delta) return symbols::match::npos;
+		return base + static_cast<std::size_t>(static_cast<int64_t>(delta));
+	}
+	static symbols::match decode(std::size_t base, const entry& e) {
+		return symbols::match(e.rule, decode(base, e.start), decode(base, e.end));
+	}
+
+	std::vector<segment> m_segments;
+	std::size_t m_size = 0;
+};
+
+}
+
+#endif
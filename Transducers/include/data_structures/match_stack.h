@@ -0,0 +1,185 @@
+#ifndef DATA_STRUCTURES_MATCH_STACK_H_
+#define DATA_STRUCTURES_MATCH_STACK_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace data_structures {
+
+/** One side of an incomplete match: the start of a match still open, or
+ * the end of one whose start lies in an earlier block.
+ */
+struct open_match {
+	uint64_t offset;
+	uint32_t rule;
+	uint32_t is_end;
+
+	bool is_start() const { return is_end == 0; }
+};
+
+/** class match_stack
+ *
+ * The incomplete matches of a block, its unmatched ends followed by its
+ * unmatched starts, in one contiguous array of sixteen byte entries.
+ * Starts are pushed and popped at the back, and merging keeps a prefix
+ * of one stack and appends a suffix of the other in one copy.
+ *
+ * Arrays of up to max_pooled_capacity entries are taken from and
+ * returned to a small per thread pool, so the stacks a pushdown
+ * transducer copies and drops for every stack it follows in a block
+ * mostly reuse arrays rather than allocate them. As run_parallel starts
+ * every block on a fresh thread, a thread fills its pool from one shared
+ * by all threads when it first needs an array and hands its arrays back
+ * to it when it ends, so only those two steps take a lock. Larger arrays
+ * are freed as usual, and the pools hold at most pool_size and
+ * shared_pool_size small arrays.
+ */
+class match_stack {
+public:
+	typedef open_match value_type;
+	typedef const open_match* const_iterator;
+
+	static const std::size_t pool_size = 16;
+	static const std::size_t max_pooled_capacity = 1024;
+	static const std::size_t shared_pool_size = 256;
+
+	match_stack() = default;
+	match_stack(const match_stack& other) {
+		if (!other.empty()) {
+			acquire();
+			m_entries.assign(other.m_entries.begin(), other.m_entries.end());
+		}
+	}
+	match_stack(match_stack&& other) noexcept:
+		m_entries(std::move(other.m_entries)) {}
+	match_stack& operator=(const match_stack& other) {
+		if (this != &other) {
+			if (m_entries.capacity() == 0 && !other.empty()) acquire();
+			m_entries.assign(other.m_entries.begin(), other.m_entries.end());
+		}
+		return *this;
+	}
+	match_stack& operator=(match_stack&& other) noexcept {
+		release();
+		m_entries = std::move(other.m_entries);
+		return *this;
+	}
+	~match_stack() {
+		release();
+	}
+
+	void push_start(uint32_t rule, std::size_t offset) {
+		push(open_match{ offset, rule, 0 });
+	}
+	void push_end(uint32_t rule, std::size_t offset) {
+		push(open_match{ offset, rule, 1 });
+	}
+
+	const open_match& back() const {
+		assert(!empty());
+		return m_entries.back();
+	}
+	void pop_back() {
+		m_entries.pop_back();
+	}
+
+	const open_match& operator[](std::size_t i) const { return m_entries[i]; }
+	std::size_t size() const { return m_entries.size(); }
+	bool empty() const { return m_entries.empty(); }
+	const_iterator begin() const { return m_entries.data(); }
+	const_iterator end() const { return m_entries.data() + m_entries.size(); }
+
+	// Keeps the first keep entries and appends those of other from from on
+	void splice(std::size_t keep, const match_stack& other, std::size_t from) {
+		assert(keep <= size() && from <= other.size());
+		m_entries.resize(keep);
+		if (from < other.size()) {
+			if (m_entries.capacity() == 0) acquire();
+			m_entries.insert(m_entries.end(), other.m_entries.begin() + from, other.m_entries.end());
+		}
+	}
+
+	// Bytes owned outside of the object itself
+	std::size_t heap_usage() const {
+		return m_entries.capacity() * sizeof(open_match);
+	}
+
+private:
+	typedef std::vector<std::vector<open_match>> array_pool;
+
+	// The arrays left by threads which have ended
+	struct shared_pool {
+		std::mutex lock;
+		array_pool spare;
+	};
+
+	// The arrays of one thread, taken from the shared pool when the thread
+	// first uses it and handed back when the thread ends
+	struct thread_pool {
+		thread_pool() {
+			auto& shared = global_pool();
+			std::lock_guard<std::mutex> guard(shared.lock);
+			while (!shared.spare.empty() && spare.size() < pool_size) {
+				spare.push_back(std::move(shared.spare.back()));
+				shared.spare.pop_back();
+			}
+		}
+		~thread_pool() {
+			auto& shared = global_pool();
+			std::lock_guard<std::mutex> guard(shared.lock);
+			for (auto& a: spare) {
+				if (shared.spare.size() >= shared_pool_size) break;
+				shared.spare.push_back(std::move(a));
+			}
+		}
+		array_pool spare;
+	};
+
+	static shared_pool& global_pool() {
+		static shared_pool shared;
+		return shared;
+	}
+
+	static array_pool& pool() {
+		static thread_local thread_pool local;
+		return local.spare;
+	}
+
+	void push(const open_match& m) {
+		if (m_entries.capacity() == 0) acquire();
+		m_entries.push_back(m);
+	}
+
+	void acquire() {
+		auto& spare = pool();
+		if (!spare.empty()) {
+			m_entries.swap(spare.back());
+			spare.pop_back();
+		}
+	}
+
+	void release() {
+		if (m_entries.capacity() == 0) return;
+		auto& spare = pool();
+		if (spare.size() < pool_size && m_entries.capacity() <= max_pooled_capacity) {
+			m_entries.clear();
+			spare.push_back(std::move(m_entries));
+		}
+		m_entries = std::vector<open_match>();
+	}
+
+	std::vector<open_match> m_entries;
+};
+
+// Picked up by util::memory_usage through argument dependent lookup
+inline std::size_t heap_usage(const match_stack& s) {
+	return s.heap_usage();
+}
+
+}
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef DATA_STRUCTURES_OFFSET_INDEX_H_
+#define DATA_STRUCTURES_OFFSET_INDEX_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace data_structures {
+
+/** class offset_index
+ *
+ * A non decreasing sequence of byte offsets stored in four bytes each.
+ * Offsets are kept as deltas from the base of their segment and a new
+ * segment is only started once a delta no longer fits, so an index over
+ * less than 4GB is a single array. Appending another index rebases its
+ * first segment onto the last one of this index where possible.
+ */
+class offset_index {
+public:
+	typedef uint32_t delta_type;
+
+	void push_back(std::size_t offset) {
+		assert(m_segments.empty() || offset >= back());
+		if (m_segments.empty() || offset - m_segments.back().base > max_delta) {
+			m_segments.push_back(segment{ offset, {} });
+		}
+		m_segments.back().deltas.push_back(offset - m_segments.back().base);
+		++m_size;
+	}
+
+	void append(const offset_index& other) {
+		auto iter = other.m_segments.begin();
+		if (iter != other.m_segments.end() && !m_segments.empty()) {
+			assert(iter->deltas.empty() || iter->base + iter->deltas.front() >= back());
+			auto& last = m_segments.back();
+			std::size_t shift = iter->base - last.base;
+			if (shift + (iter->deltas.empty() ? 0 : iter->deltas.back()) <= max_delta) {
+				for (delta_type d: iter->deltas) {
+					last.deltas.push_back(shift + d);
+				}
+				++iter;
+			}
+		}
+		m_segments.insert(m_segments.end(), iter, other.m_segments.end());
+		m_size += other.m_size;
+	}
+
+	std::size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+
+	std::size_t operator[](std::size_t i) const {
+		for (const auto& s: m_segments) {
+			if (i < s.deltas.size()) return s.base + s.deltas[i];
+			i -= s.deltas.size();
+		}
+		assert(false);
+		return 0;
+	}
+
+	std::size_t back() const {
+		assert(!empty());
+		return m_segments.back().base + m_segments.back().deltas.back();
+	}
+
+	// Calls fn with every offset in order
+	template <typename Fn>
+	void for_each(const Fn& fn) const {
+		for (const auto& s: m_segments) {
+			for (delta_type d: s.deltas) fn(s.base + d);
+		}
+	}
+
+	std::vector<std::size_t> offsets() const {
+		std::vector<std::size_t> ret;
+		ret.reserve(m_size);
+		for_each([&](std::size_t o) { ret.push_back(o); });
+		return ret;
+	}
+
+	std::size_t num_segments() const { return m_segments.size(); }
+
+	// Bytes owned outside of the object itself
+	std::size_t heap_usage() const {
+		std::size_t ret = m_segments.capacity() * sizeof(segment);
+		for (const auto& s: m_segments) {
+			ret += s.deltas.capacity() * sizeof(delta_type);
+		}
+		return ret;
+	}
+
+	bool operator==(const offset_index& other) const {
+		return m_size == other.m_size && offsets() == other.offsets();
+	}
+
+private:
+	static const std::size_t max_delta = std::numeric_limits<delta_type>::max();
+
+	struct segment {
+		std::size_t base;
+		std::vector<delta_type> deltas;
+	};
+
+	std::vector<segment> m_segments;
+	std::size_t m_size = 0;
+};
+
+}
+
+#endif
@@ -3,12 +3,14 @@
 
 #include <algorithm>
 #include <cassert>
+#include <ostream>
 #include <vector>
 
 #include <boost/iterator/iterator_adaptor.hpp>
 #include <boost/iterator/iterator_facade.hpp>
 #include <boost/iterator/filter_iterator.hpp>
 
+#include <data_structures/state_map_statistics.h>
 #include <util/range.h>
 #include <utility>
 
@@ -287,7 +289,7 @@ public:
 			auto& ne = m_new_entries.back();
 			ne.m_finish_stack.erase(ne.m_finish_stack.begin() + layer->m_layer - 1,
 				ne.m_finish_stack.begin() + layer->m_layer);
-			ne.m_finish_stack[layer->m_layer] = new_state;
+			ne.m_finish_stack[layer->m_layer - 1] = new_state;
 			fn(ne.value());
 			e.updated = true;
 		};
@@ -351,6 +353,24 @@ public:
 		m_entries.clear();
 		m_new_entries.clear();
 	}
+
+	// Number of entries, only meaningful on a finalised map
+	std::size_t size() const { return m_entries.size(); }
+
+	state_map_statistics statistics() const {
+		state_map_statistics stats;
+		stats.entries = m_entries.size();
+		stats.bytes = sizeof(*this) +
+			(m_entries.capacity() + m_new_entries.capacity()) * sizeof(entry);
+		for (const auto& e: m_entries) {
+			stats.start_nodes += e.m_start_stack.size();
+			stats.finish_nodes += e.m_finish_stack.size();
+			stats.bytes += (e.m_start_stack.capacity() + e.m_finish_stack.capacity()) * sizeof(int);
+			stats.add_start_depth(e.m_start_stack.size());
+			stats.add_finish_depth(e.m_finish_stack.size());
+		}
+		return stats;
+	}
 private:
 	void mark_for_erase(entry_iterator begin, entry_iterator end) {
 		std::for_each(begin, end, [](entry& e) {
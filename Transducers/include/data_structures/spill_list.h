@@ -0,0 +1,244 @@
+#ifndef DATA_STRUCTURES_SPILL_LIST_H_
+#define DATA_STRUCTURES_SPILL_LIST_H_
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+namespace data_structures {
+
+/** An unlinked temporary file of fixed size records, which disappears
+ * once the last spill_list referring to it is gone. Records are only
+ * ever appended, under a lock so lists sharing the file may append from
+ * several threads, and are read with pread.
+ */
+class spill_file {
+public:
+	explicit spill_file(const std::string& directory) {
+		std::string name = directory + "/transducers-spill-XXXXXX";
+		m_fd = ::mkstemp(&name[0]);
+		if (m_fd < 0) {
+			throw std::runtime_error("Unable to create a spill file in " + directory);
+		}
+		::unlink(name.c_str());
+	}
+	~spill_file() {
+		::close(m_fd);
+	}
+	spill_file(const spill_file&) = delete;
+	spill_file& operator=(const spill_file&) = delete;
+
+	// Writes bytes at the end of the file and returns their offset. The
+	// size only grows once all of them are written.
+	std::size_t append(const void* data, std::size_t bytes) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		const char* p = static_cast<const char*>(data);
+		std::size_t offset = m_size;
+		while (bytes > 0) {
+			ssize_t written = ::pwrite(m_fd, p, bytes, offset);
+			if (written < 0 && errno == EINTR) continue;
+			if (written <= 0) throw std::runtime_error("Unable to write a spill file");
+			p += written;
+			bytes -= written;
+			offset += written;
+		}
+		std::swap(offset, m_size);
+		return offset;
+	}
+
+	void read(void* data, std::size_t bytes, std::size_t offset) const {
+		char* p = static_cast<char*>(data);
+		while (bytes > 0) {
+			ssize_t got = ::pread(m_fd, p, bytes, offset);
+			if (got < 0 && errno == EINTR) continue;
+			if (got <= 0) throw std::runtime_error("Unable to read a spill file");
+			p += got;
+			bytes -= got;
+			offset += got;
+		}
+	}
+
+	std::size_t size() const {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_size;
+	}
+
+private:
+	int m_fd;
+	std::size_t m_size = 0;
+	mutable std::mutex m_mutex;
+};
+
+/** class spill_list
+ *
+ * A sequence of trivially copyable values, held in memory until spill()
+ * appends them to the one file of the list. The values are stored as
+ * their raw bytes, as the file only lives as long as the process.
+ *
+ * The list is a run of segments, each a range of records in some file or
+ * values still in memory, followed by the tail pushed to. Appending
+ * another list shares its files and copies its segments, and keeps the
+ * tail of this list as a segment in memory rather than writing it, so a
+ * merged result refers to at most one file per block it came from, and
+ * for_each() reads them back a buffer at a time.
+ */
+template <typename T>
+class spill_list {
+	static_assert(std::is_trivially_copyable<T>::value, "Spilled values are stored as raw bytes");
+public:
+	typedef T value_type;
+
+	static const std::size_t read_buffer = 4096;
+
+	explicit spill_list(std::string directory = default_directory()):
+		m_directory(std::move(directory)) {}
+
+	void push_back(const T& value) {
+		m_tail.push_back(value);
+	}
+
+	// Appends every value held in memory to the file of this list, which
+	// is created on the first call. Should writing fail, the values not
+	// yet written stay in memory.
+	void spill() {
+		if (m_memory == 0 && m_tail.empty()) return;
+		if (!m_file) m_file = std::make_shared<spill_file>(m_directory);
+		for (auto& s: m_segments) {
+			if (s.file) continue;
+			s.offset = m_file->append(s.values.data(), s.values.size() * sizeof(T));
+			s.file = m_file;
+			m_memory -= s.values.size();
+			std::vector<T>().swap(s.values);
+		}
+		if (!m_tail.empty()) {
+			std::size_t offset = m_file->append(m_tail.data(), m_tail.size() * sizeof(T));
+			m_segments.push_back(segment{ m_file, offset, m_tail.size(), {} });
+			m_tail = std::vector<T>();
+		}
+		coalesce();
+	}
+
+	void append(const spill_list& other) {
+		if (!other.m_segments.empty()) {
+			if (!m_tail.empty()) {
+				m_memory += m_tail.size();
+				m_segments.push_back(segment{ nullptr, 0, m_tail.size(), std::move(m_tail) });
+				m_tail = std::vector<T>();
+			}
+			m_segments.insert(m_segments.end(), other.m_segments.begin(), other.m_segments.end());
+			m_memory += other.m_memory;
+			coalesce();
+		}
+		m_tail.insert(m_tail.end(), other.m_tail.begin(), other.m_tail.end());
+	}
+
+	// Calls fn with every value in order
+	template <typename Fn>
+	void for_each(const Fn& fn) const {
+		std::vector<T> buffer;
+		for (const auto& s: m_segments) {
+			if (!s.file) {
+				for (const T& value: s.values) fn(value);
+				continue;
+			}
+			for (std::size_t r = 0; r < s.count; r += read_buffer) {
+				buffer.resize(std::min(read_buffer, s.count - r));
+				s.file->read(buffer.data(), buffer.size() * sizeof(T), s.offset + r * sizeof(T));
+				for (const T& value: buffer) fn(value);
+			}
+		}
+		for (const T& value: m_tail) fn(value);
+	}
+
+	std::vector<T> values() const {
+		std::vector<T> ret;
+		ret.reserve(size());
+		for_each([&](const T& value) { ret.push_back(value); });
+		return ret;
+	}
+
+	std::size_t size() const {
+		std::size_t ret = m_tail.size();
+		for (const auto& s: m_segments) ret += s.count;
+		return ret;
+	}
+	bool empty() const { return size() == 0; }
+	std::size_t num_segments() const { return m_segments.size(); }
+	std::size_t tail_bytes() const { return m_tail.size() * sizeof(T); }
+	// Bytes of the values held in memory, the tail included
+	std::size_t memory_bytes() const { return (m_memory + m_tail.size()) * sizeof(T); }
+
+	// The distinct files the segments are in
+	std::size_t num_files() const {
+		std::vector<const spill_file*> files;
+		for (const auto& s: m_segments) {
+			if (s.file) files.push_back(s.file.get());
+		}
+		std::sort(files.begin(), files.end());
+		return std::unique(files.begin(), files.end()) - files.begin();
+	}
+
+	// Bytes held in memory outside of the object itself, files excluded
+	std::size_t heap_usage() const {
+		std::size_t ret = m_directory.capacity() + m_tail.capacity() * sizeof(T) +
+			m_segments.capacity() * sizeof(segment) + (m_file ? sizeof(spill_file) : 0);
+		for (const auto& s: m_segments) ret += s.values.capacity() * sizeof(T);
+		return ret;
+	}
+
+	static std::string default_directory() {
+		const char* dir = std::getenv("TMPDIR");
+		return dir != nullptr && *dir != '\0' ? dir : "/tmp";
+	}
+
+private:
+	// count records from byte offset on in file, or values if file is null
+	struct segment {
+		std::shared_ptr<spill_file> file;
+		std::size_t offset;
+		std::size_t count;
+		std::vector<T> values;
+	};
+
+	// Joins consecutive segments which follow each other in one file
+	void coalesce() {
+		std::size_t kept = 0;
+		for (std::size_t i = 0; i < m_segments.size(); ++i) {
+			auto& s = m_segments[i];
+			if (kept > 0) {
+				auto& last = m_segments[kept - 1];
+				if (s.file && last.file == s.file && last.offset + last.count * sizeof(T) == s.offset) {
+					last.count += s.count;
+					continue;
+				}
+			}
+			if (kept != i) m_segments[kept] = std::move(s);
+			++kept;
+		}
+		m_segments.resize(kept);
+	}
+
+	std::string m_directory;
+	std::shared_ptr<spill_file> m_file;
+	std::vector<segment> m_segments;
+	// Values in the segments held in memory
+	std::size_t m_memory = 0;
+	std::vector<T> m_tail;
+};
+
+template <typename T>
+const std::size_t spill_list<T>::read_buffer;
+
+}
+
+#endif
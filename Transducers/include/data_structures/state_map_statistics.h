@@ -0,0 +1,49 @@
+#ifndef DATA_STRUCTURES_STATE_MAP_STATISTICS_H_
+#define DATA_STRUCTURES_STATE_MAP_STATISTICS_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace data_structures {
+
+/** struct state_map_statistics
+ *
+ * Size and shape summary of a pushdown state map. The depth histograms
+ * are indexed by stack length and count the entries with a start or
+ * finish stack of that length. Node counts are the number of stack
+ * elements the map actually stores, so for the tree map they reflect
+ * the sharing of common prefixes and for the vector map they do not.
+ * Bytes only covers the map's own structure, not memory owned by the
+ * values.
+ */
+struct state_map_statistics {
+	std::size_t entries = 0;
+	std::size_t start_nodes = 0;
+	std::size_t finish_nodes = 0;
+	std::size_t bytes = 0;
+	std::vector<std::size_t> start_depths;
+	std::vector<std::size_t> finish_depths;
+
+	std::size_t max_start_depth() const { return max_depth(start_depths); }
+	std::size_t max_finish_depth() const { return max_depth(finish_depths); }
+
+	void add_start_depth(std::size_t depth, std::size_t count = 1) {
+		add_depth(start_depths, depth, count);
+	}
+	void add_finish_depth(std::size_t depth, std::size_t count = 1) {
+		add_depth(finish_depths, depth, count);
+	}
+private:
+	static std::size_t max_depth(const std::vector<std::size_t>& h) {
+		return h.empty() ? 0 : h.size() - 1;
+	}
+	static void add_depth(std::vector<std::size_t>& h, std::size_t depth, std::size_t count) {
+		if (count == 0) return;
+		if (h.size() <= depth) h.resize(depth + 1);
+		h[depth] += count;
+	}
+};
+
+}
+
+#endif
@@ -1,9 +1,17 @@
 #ifndef DATA_STRUCTURES_TREE_STATE_MAP_H_
 #define DATA_STRUCTURES_TREE_STATE_MAP_H_
 
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <ostream>
+#include <vector>
+
 #include <boost/intrusive/set.hpp>
 #include <boost/intrusive/list.hpp>
+#include <boost/iterator/iterator_facade.hpp>
 
+#include <data_structures/state_map_statistics.h>
 #include <util/range.h>
 
 namespace data_structures {
@@ -152,7 +160,7 @@ public:
 				lhs.value() == rhs.value();
 		}
 	private:
-		const Value* m_value;
+		const Value* m_value = nullptr;
 		std::vector<int> m_start_stack;
 		std::vector<int> m_finish_stack;
 		friend class entry_iterator;
@@ -245,7 +253,7 @@ public:
 	template <typename Range>
 	util::range<entry_iterator> matching_entries(const Range& r) const {
 		start_node* sn = &*m_start_root;
-		start_layer_iterator find_iter;
+		start_layer_iterator find_iter = sn->m_children.end();
 		for (auto iter = r.begin(); iter != r.end() && sn->m_finish_node == nullptr; ++iter) {
 			find_iter = sn->find_child(*iter);
 			if (find_iter == sn->m_children.end()) {
@@ -253,6 +261,9 @@ public:
 			}
 			sn = const_cast<start_node*>(&*find_iter);
 		}
+		if (sn == m_start_root.get()) {
+			return util::range<entry_iterator>(entries_end(), entries_end());
+		}
 		auto first = find_iter;
 		auto last = ++find_iter;
 		return util::range<entry_iterator>(entry_iterator(first, last), entry_iterator(last,last));
@@ -300,6 +311,18 @@ public:
 		assert(m_next_root->m_children.empty());
 	}
 	void start_stack_finalise() const { }
+
+	std::size_t size() const { return count_entries(*m_finish_root); }
+
+	state_map_statistics statistics() const {
+		state_map_statistics stats;
+		stats.bytes = sizeof(*this) + sizeof(start_node) + 2 * sizeof(finish_node);
+		collect_statistics(*m_start_root, 0, stats);
+		collect_statistics(*m_finish_root, 0, stats);
+		stats.bytes += stats.start_nodes * sizeof(start_node) +
+			stats.finish_nodes * sizeof(finish_node);
+		return stats;
+	}
 	struct no_value_update {
 		void operator() (const Value&) const {}
 	};
@@ -396,7 +419,10 @@ private:
 			add_child(n, child);
 		} else {
 			auto &old_n = *find;
-			for (auto& gc: child.m_children) {
+			// Grandchildren are unlinked before they move to their new parent
+			for (auto iter = child.m_children.begin(); iter != child.m_children.end();) {
+				auto& gc = *iter;
+				child.m_children.erase(iter++);
 				merge_child(old_n, gc);
 			}
 			for (auto iter = child.m_start_nodes.begin(); iter != child.m_start_nodes.end();) {
@@ -438,6 +464,30 @@ private:
 		}
 		free_start_node(&sn);
 	}
+	std::size_t count_entries(const finish_node& fn) const {
+		std::size_t count = fn.m_start_nodes.size();
+		for (const auto& child: fn.m_children) {
+			count += count_entries(child);
+		}
+		return count;
+	}
+	void collect_statistics(const start_node& sn, std::size_t depth, state_map_statistics& stats) const {
+		for (const auto& child: sn.m_children) {
+			++stats.start_nodes;
+			if (child.m_finish_node) {
+				++stats.entries;
+				stats.add_start_depth(depth + 1);
+			}
+			collect_statistics(child, depth + 1, stats);
+		}
+	}
+	void collect_statistics(const finish_node& fn, std::size_t depth, state_map_statistics& stats) const {
+		for (const auto& child: fn.m_children) {
+			++stats.finish_nodes;
+			stats.add_finish_depth(depth + 1, child.m_start_nodes.size());
+			collect_statistics(child, depth + 1, stats);
+		}
+	}
 	void validate() {
 		validate(*m_start_root);
 	}
@@ -0,0 +1,132 @@
+#ifndef TRANSDUCERS_PIPELINES_JSON_QUERY_H_
+#define TRANSDUCERS_PIPELINES_JSON_QUERY_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <data_structures/tree_state_map.h>
+#include <representation/json_path_compiler.h>
+#include <symbols/match.h>
+#include <transducers/aggregation/match_buffer.h>
+#include <transducers/finite/associative_finite_transducer.h>
+#include <transducers/parallel.h>
+#include <transducers/pushdown/state_map_pushdown_transducer.h>
+#include <transducers/util/match_adapter.h>
+
+namespace pipelines {
+
+/** class json_query
+ *
+ * Evaluates JSONPath selectors over a JSON document, or newline
+ * delimited JSON records, held in memory, in parallel blocks. The stages
+ * are
+ *
+ *   associative_finite_transducer (json_tokenizer)
+ *     -> state_map_pushdown_transducer (json_path_compiler)
+ *     -> match_adapter -> match_buffer
+ *
+ * Unlike XML there is no byte at which a JSON tokenizer is known to be
+ * outside a string, so each block follows the tokenizer from every
+ * state, with one run of the later stages for each state still distinct,
+ * and a block may start anywhere, including inside a string or escape.
+ *
+ * The query at index i reports rule i, once for every value it matches,
+ * even when other queries match the same value. A match covers its value from
+ * its first to its last byte inclusive, and matches are returned in
+ * document order. Input the JSON grammar does not allow throws
+ * std::runtime_error.
+ */
+class json_query {
+public:
+	typedef transducers::aggregation::match_buffer sink_type;
+	typedef transducers::util::match_adapter<sink_type> adapter_type;
+	typedef transducers::pushdown::state_map_pushdown_transducer<adapter_type,
+		data_structures::tree_state_map> query_type;
+	typedef transducers::finite::associative_finite_transducer<query_type> tokenizer_type;
+
+	explicit json_query(const std::vector<std::string>& paths):
+		json_query(compiler(paths)) {}
+
+	json_query(const json_query&) = delete;
+	json_query& operator=(const json_query&) = delete;
+
+	std::vector<symbols::match> run(const std::string& document,
+			std::size_t blocks = std::thread::hardware_concurrency()) const {
+		return run(document.data(), document.size(), blocks);
+	}
+
+	std::vector<symbols::match> run(const char* data, std::size_t size,
+			std::size_t blocks = std::thread::hardware_concurrency()) const {
+		const unsigned char* begin = reinterpret_cast<const unsigned char*>(data);
+		auto pr = transducers::run_parallel(m_tokenizer, begin, begin + size, blocks);
+		if (pr.second.map().size() != 1) {
+			throw std::runtime_error("Malformed JSON document");
+		}
+		std::vector<symbols::match> ret;
+		for (auto m: m_tokenizer.last_stage_result(pr).matches()) {
+			if (m.start_offset == m.end_offset) {
+				m.end_offset = value_end(data, size, m.start_offset);
+			}
+			auto group = m_groups.find(m.rule);
+			if (group == m_groups.end()) {
+				ret.push_back(m);
+				continue;
+			}
+			for (int rule: group->second) {
+				m.rule = rule;
+				ret.push_back(m);
+			}
+		}
+		std::sort(ret.begin(), ret.end(), [](const symbols::match& lhs, const symbols::match& rhs) {
+			return lhs.start_offset < rhs.start_offset ||
+				(lhs.start_offset == rhs.start_offset && lhs.rule < rhs.rule);
+		});
+		return ret;
+	}
+
+	const tokenizer_type& transducer() const { return m_tokenizer; }
+
+private:
+	static representation::json_path_compiler compiler(const std::vector<std::string>& paths) {
+		representation::json_path_compiler ret;
+		for (std::size_t i = 0; i < paths.size(); ++i) {
+			ret.add(paths[i], i);
+		}
+		return ret;
+	}
+
+	// Strings and scalars are reported at their first byte only
+	static std::size_t value_end(const char* data, std::size_t size, std::size_t start) {
+		std::size_t pos = start + 1;
+		if (data[start] == '"') {
+			while (pos < size && data[pos] != '"') {
+				pos += data[pos] == '\\' ? 2 : 1;
+			}
+			return std::min(pos, size - 1);
+		}
+		while (pos < size && std::strchr(" \t\r\n,:{}[]\"", data[pos]) == nullptr) {
+			++pos;
+		}
+		return pos - 1;
+	}
+
+	explicit json_query(const representation::json_path_compiler& queries):
+		m_adapter(m_sink),
+		m_query(m_adapter, queries.compile(m_groups)),
+		m_tokenizer(m_query, queries.tokenizer().description()) {}
+
+	representation::json_path_compiler::rule_groups m_groups;
+	sink_type m_sink;
+	adapter_type m_adapter;
+	query_type m_query;
+	tokenizer_type m_tokenizer;
+};
+
+}
+
+#endif
@@ -0,0 +1,336 @@
+#ifndef TRANSDUCERS_PIPELINES_XML_QUERY_H_
+#define TRANSDUCERS_PIPELINES_XML_QUERY_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <data_structures/tree_state_map.h>
+#include <representation/path_query_compiler.h>
+#include <symbols/match.h>
+#include <transducers/aggregation/match_buffer.h>
+#include <transducers/aggregation/stream_sink.h>
+#include <transducers/base/sink_transducer.h>
+#include <transducers/finite/finite_transducer.h>
+#include <transducers/parallel.h>
+#include <transducers/process_block.h>
+#include <transducers/pushdown/state_map_pushdown_transducer.h>
+#include <transducers/util/match_adapter.h>
+#include <transducers/util/ordered_match_adapter.h>
+
+namespace pipelines {
+
+/** class xml_query
+ *
+ * Evaluates path queries over an XML document held in memory, in
+ * parallel blocks. The stages are
+ *
+ *   finite_transducer (xml_tokenizer)
+ *     -> state_map_pushdown_transducer (path_query_compiler)
+ *     -> match_adapter -> match_buffer
+ *
+ * Each block but the first starts at a '<' and is tokenized from the
+ * character data state, which is right unless the '<' lies inside a
+ * comment, CDATA section, processing instruction or attribute value.
+ * A first parallel pass tokenizes the blocks, keeping their symbols and
+ * the tags each leaves open or closes from before it. Each block is then
+ * checked against the state the block before it ended in, and run again
+ * from that state if the guess was wrong, so the result never depends
+ * on the blocks. Joining the open tags in order gives the element stack
+ * at the start of every block, and with it the one stack the pushdown
+ * stage has there, so the second parallel pass reads the symbols of each
+ * block following a single stack rather than every possible one.
+ *
+ * The query at index i reports rule i, once for every element it
+ * matches, even when other queries match the same element. A match
+ * covers its element from the '<' of the start tag to the '>' of the
+ * end tag inclusive, and matches are returned in document order. Should
+ * the blocks not join into a single stack, which only a malformed
+ * document can cause, std::runtime_error is thrown.
+ *
+ * run() with a callback streams the matches instead. It reads the
+ * document a window at a time, each window in parallel blocks as above
+ * and continuing from the tokenizer state and open tags the windows
+ * before it left, through an ordered_match_adapter and a stream_sink in
+ * place of the last two stages, so each match is handed on in document
+ * order once the windows read so far complete it.
+ */
+class xml_query {
+public:
+	typedef transducers::aggregation::match_buffer sink_type;
+	typedef transducers::util::match_adapter<sink_type> adapter_type;
+	typedef transducers::pushdown::state_map_pushdown_transducer<adapter_type,
+		data_structures::tree_state_map> query_type;
+	typedef transducers::finite::finite_transducer<query_type> tokenizer_type;
+	typedef std::function<void(const symbols::match&)> callback;
+
+	explicit xml_query(const std::vector<std::string>& paths):
+		xml_query(compiler(paths)) {}
+
+	xml_query(const xml_query&) = delete;
+	xml_query& operator=(const xml_query&) = delete;
+
+	std::vector<symbols::match> run(const std::string& document,
+			std::size_t blocks = std::thread::hardware_concurrency()) const {
+		return run(document.data(), document.size(), blocks);
+	}
+
+	std::vector<symbols::match> run(const char* data, std::size_t size,
+			std::size_t blocks = std::thread::hardware_concurrency()) const {
+		const unsigned char* begin = reinterpret_cast<const unsigned char*>(data);
+		std::vector<std::size_t> bounds = block_bounds(data, 0, size, blocks);
+		query_type::partial_result pr;
+		if (bounds.size() == 2 && m_tag_tokenizer.streams() < 2) {
+			auto result = m_tokenizer.initial_result();
+			transducers::process_block(m_tokenizer, result, begin, begin + size, 0);
+			pr = std::move(result.second);
+		} else {
+			cursor<query_type> at{ m_tokenizer.automaton().start_state(), {}, m_query.initial_result() };
+			run_blocks(m_query, begin, bounds, at);
+			pr = std::move(at.query);
+		}
+		if (pr.map().size() != 1) {
+			throw std::runtime_error("Malformed XML document");
+		}
+
+		std::vector<symbols::match> ret;
+		m_query.last_stage_result(pr).for_each([&](const symbols::match& m) {
+			report(data, m, [&](const symbols::match& r) { ret.push_back(r); });
+		});
+		std::sort(ret.begin(), ret.end(), [](const symbols::match& lhs, const symbols::match& rhs) {
+			return lhs.start_offset < rhs.start_offset ||
+				(lhs.start_offset == rhs.start_offset && lhs.rule < rhs.rule);
+		});
+		return ret;
+	}
+
+	// Calls emit for every match in document order, reading window bytes
+	// of the document at a time in up to blocks parallel blocks, and
+	// returns the number of matches. A window of 0 reads the whole
+	// document at once.
+	std::size_t run(const char* data, std::size_t size, std::size_t blocks,
+			std::size_t window, const callback& emit) const {
+		const unsigned char* begin = reinterpret_cast<const unsigned char*>(data);
+		std::size_t count = 0;
+		stream_type sink([&](const symbols::match& m) {
+			report(data, m, [&](const symbols::match& r) {
+				++count;
+				emit(r);
+			});
+		});
+		ordered_adapter_type adapter(sink);
+		stream_query_type query(adapter, m_query.automaton());
+		cursor<stream_query_type> at{ m_tokenizer.automaton().start_state(), {}, query.initial_result() };
+		if (window == 0 || window > size) window = size;
+		for (std::size_t from = 0; from < size; from += window) {
+			run_blocks(query, begin, block_bounds(data, from, std::min(from + window, size), blocks), at);
+			if (at.query.map().size() != 1) {
+				throw std::runtime_error("Malformed XML document");
+			}
+		}
+		return count;
+	}
+
+	// Tokenizes each block in streams chunks at once, see
+	// finite_transducer::process_interleaved(). Only the first parallel
+	// pass is interleaved, which a single block then goes through too, as
+	// every chunk but the first would start the pushdown stage from every
+	// state.
+	void set_streams(std::size_t streams) { m_tag_tokenizer.set_streams(streams); }
+
+	const tokenizer_type& transducer() const { return m_tokenizer; }
+
+private:
+	typedef transducers::aggregation::stream_sink<symbols::match> stream_type;
+	typedef transducers::util::ordered_match_adapter<stream_type> ordered_adapter_type;
+	typedef transducers::pushdown::state_map_pushdown_transducer<ordered_adapter_type,
+		data_structures::tree_state_map> stream_query_type;
+
+	// Where the blocks read so far leave the document: the state of the
+	// tokenizer, the tags still open, outermost first, and the result of
+	// the pushdown stage
+	template <typename Query>
+	struct cursor {
+		int state;
+		std::vector<int> open;
+		typename Query::partial_result query;
+	};
+
+	// Calls fn with m starting at the '<' of its start tag, once for each
+	// rule of its group
+	template <typename Fn>
+	void report(const char* data, symbols::match m, const Fn& fn) const {
+		// Start tags are reported after their name
+		while (m.start_offset != symbols::match::npos && m.start_offset > 0 &&
+				data[m.start_offset] != '<') {
+			--m.start_offset;
+		}
+		auto group = m_groups.find(m.rule);
+		if (group == m_groups.end()) {
+			fn(m);
+			return;
+		}
+		for (int rule: group->second) {
+			m.rule = rule;
+			fn(m);
+		}
+	}
+
+	// The symbols of a block, the tags it leaves open, outermost first, and
+	// how many tags opened before it the block closes
+	struct block_symbols {
+		struct symbol {
+			std::size_t offset;
+			int value;
+		};
+		std::vector<symbol> symbols;
+		std::size_t closed_before = 0;
+		std::vector<int> open;
+	};
+
+	class tag_sink : public transducers::base::sink_transducer<int, block_symbols> {
+	public:
+		explicit tag_sink(int close_symbol):
+			m_close_symbol(close_symbol) {}
+
+		void process_symbol(block_symbols& pr, int s, std::size_t offset) const {
+			pr.symbols.push_back(block_symbols::symbol{ offset, s });
+			if (s < m_close_symbol) {
+				pr.open.push_back(s);
+			} else if (pr.open.empty()) {
+				++pr.closed_before;
+			} else {
+				pr.open.pop_back();
+			}
+		}
+
+		void merge_results(block_symbols& lhs, const block_symbols& rhs) const {
+			lhs.symbols.insert(lhs.symbols.end(), rhs.symbols.begin(), rhs.symbols.end());
+			std::size_t closed = std::min(rhs.closed_before, lhs.open.size());
+			lhs.open.resize(lhs.open.size() - closed);
+			lhs.closed_before += rhs.closed_before - closed;
+			lhs.open.insert(lhs.open.end(), rhs.open.begin(), rhs.open.end());
+		}
+
+	private:
+		int m_close_symbol;
+	};
+	typedef transducers::finite::finite_transducer<tag_sink> tag_tokenizer_type;
+
+	// Tokenizes the blocks in parallel, the first from the state at,
+	// every other from the character data state, and runs again each
+	// block whose guess was wrong from the state the block before it ended
+	// in. The pushdown stage then reads the symbols of each block in
+	// parallel, from the one stack the tags left open by the blocks before
+	// it give, and at is moved past the blocks.
+	template <typename Query>
+	void run_blocks(const Query& query, const unsigned char* begin,
+			const std::vector<std::size_t>& bounds, cursor<Query>& at) const {
+		std::vector<tag_tokenizer_type::partial_result> tags;
+		tags.push_back(m_tag_tokenizer.identity_result(at.state));
+		while (tags.size() + 1 < bounds.size()) {
+			tags.push_back(m_tag_tokenizer.identity_result());
+		}
+		transducers::detail::process_chunks(m_tag_tokenizer, begin, bounds, 0, tags);
+		for (std::size_t b = 1; b < tags.size(); ++b) {
+			int state = tags[b - 1].first;
+			if (state != m_tag_tokenizer.automaton().start_state()) {
+				tags[b] = m_tag_tokenizer.identity_result(state);
+				transducers::process_block(m_tag_tokenizer, tags[b], begin + bounds[b],
+					begin + bounds[b + 1], bounds[b]);
+			}
+		}
+
+		std::vector<typename Query::partial_result> results;
+		results.push_back(std::move(at.query));
+		for (std::size_t b = 1; b < tags.size(); ++b) {
+			follow(at.open, tags[b - 1].second);
+			results.push_back(query_stack(query, at.open));
+		}
+		follow(at.open, tags.back().second);
+		at.state = tags.back().first;
+
+		transducers::detail::run_threads(results.size(), [&](std::size_t b) {
+			for (const auto& s: tags[b].second.symbols) {
+				query.process_symbol(results[b], s.value, s.offset);
+			}
+		});
+		at.query = transducers::detail::merge_chunks(query, std::move(results));
+	}
+
+	// The tags open after block, given those open before it
+	static void follow(std::vector<int>& open, const block_symbols& block) {
+		if (block.closed_before > open.size()) {
+			throw std::runtime_error("Malformed XML document");
+		}
+		open.resize(open.size() - block.closed_before);
+		open.insert(open.end(), block.open.begin(), block.open.end());
+	}
+
+	// The pushdown stage inside the open tags, whose automaton pushes on
+	// every start tag and pops back to the state below on its end tag
+	template <typename Query>
+	typename Query::partial_result query_stack(const Query& query, const std::vector<int>& open) const {
+		const auto& automaton = query.automaton();
+		std::vector<int> stack;
+		int state = automaton.start_state();
+		for (int s: open) {
+			const auto& details = automaton.lookup(state, s);
+			if (details.next == -1 || details.push == -1) return query.identity_result();
+			stack.push_back(details.push);
+			state = details.next;
+		}
+		stack.push_back(state);
+		return query.stack_result(stack.rbegin(), stack.rend());
+	}
+
+	static representation::path_query_compiler compiler(const std::vector<std::string>& paths) {
+		representation::path_query_compiler ret;
+		for (std::size_t i = 0; i < paths.size(); ++i) {
+			ret.add(paths[i], i);
+		}
+		return ret;
+	}
+
+	// Block b of [begin, end) is [bounds[b], bounds[b + 1]), and every
+	// block but the first starts at the first '<' after its share
+	static std::vector<std::size_t> block_bounds(const char* data, std::size_t begin,
+			std::size_t end, std::size_t blocks) {
+		if (blocks == 0) blocks = 1;
+		std::size_t size = end - begin;
+		std::vector<std::size_t> ret(1, begin);
+		for (std::size_t b = 1; b < blocks; ++b) {
+			std::size_t from = std::max(begin + size * b / blocks, ret.back() + 1);
+			if (from >= end) break;
+			const void* lt = std::memchr(data + from, '<', end - from);
+			if (lt == nullptr) break;
+			ret.push_back(static_cast<const char*>(lt) - data);
+		}
+		ret.push_back(end);
+		return ret;
+	}
+
+	explicit xml_query(const representation::path_query_compiler& queries):
+		m_adapter(m_sink),
+		m_query(m_adapter, queries.compile(m_groups)),
+		m_tokenizer(m_query, queries.tokenizer().description()),
+		m_tag_sink(queries.tokenizer().close_symbol()),
+		m_tag_tokenizer(m_tag_sink, m_tokenizer.automaton()) {}
+
+	representation::path_query_compiler::rule_groups m_groups;
+	sink_type m_sink;
+	adapter_type m_adapter;
+	query_type m_query;
+	tokenizer_type m_tokenizer;
+	tag_sink m_tag_sink;
+	tag_tokenizer_type m_tag_tokenizer;
+};
+
+}
+
+#endif
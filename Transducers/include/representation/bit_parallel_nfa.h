@@ -0,0 +1,167 @@
+#ifndef TRANSDUCERS_REPRESENTATION_BIT_PARALLEL_NFA_H_
+#define TRANSDUCERS_REPRESENTATION_BIT_PARALLEL_NFA_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <representation/symbol_classes.h>
+#include <representation/transition_description.h>
+
+namespace representation {
+
+/** A set of up to 64 * Words NFA states. The operations are plain loops
+ * over the words which the compiler unrolls and vectorises.
+ */
+template <std::size_t Words>
+struct state_mask {
+	uint64_t words[Words] = {};
+
+	void set(std::size_t i) { words[i / 64] |= uint64_t(1) << (i % 64); }
+	bool test(std::size_t i) const { return (words[i / 64] >> (i % 64)) & 1; }
+	bool any() const {
+		uint64_t r = 0;
+		for (std::size_t w = 0; w < Words; ++w) r |= words[w];
+		return r != 0;
+	}
+	bool intersects(const state_mask& other) const { return (*this & other).any(); }
+
+	state_mask& operator|=(const state_mask& other) {
+		for (std::size_t w = 0; w < Words; ++w) words[w] |= other.words[w];
+		return *this;
+	}
+	friend state_mask operator&(const state_mask& lhs, const state_mask& rhs) {
+		state_mask ret;
+		for (std::size_t w = 0; w < Words; ++w) ret.words[w] = lhs.words[w] & rhs.words[w];
+		return ret;
+	}
+	friend state_mask operator|(state_mask lhs, const state_mask& rhs) {
+		return lhs |= rhs;
+	}
+	// Moves every state i to i + 1
+	state_mask shifted() const {
+		state_mask ret;
+		ret.words[0] = words[0] << 1;
+		for (std::size_t w = 1; w < Words; ++w) {
+			ret.words[w] = (words[w] << 1) | (words[w - 1] >> 63);
+		}
+		return ret;
+	}
+	template <typename Fn>
+	void for_each(const Fn& fn) const {
+		for (std::size_t w = 0; w < Words; ++w) {
+			for (uint64_t bits = words[w]; bits != 0; bits &= bits - 1) {
+				fn(w * 64 + __builtin_ctzll(bits));
+			}
+		}
+	}
+	friend bool operator==(const state_mask& lhs, const state_mask& rhs) {
+		return std::equal(lhs.words, lhs.words + Words, rhs.words);
+	}
+	friend bool operator!=(const state_mask& lhs, const state_mask& rhs) {
+		return !(lhs == rhs);
+	}
+};
+
+/** class bit_parallel_nfa
+ *
+ * An nfa_description compiled for bit parallel simulation in the style
+ * of Shift-And. Every transition from state i to i + 1 is handled by a
+ * single masked shift and every self loop by a mask, so automata whose
+ * states are numbered along their patterns advance all of their active
+ * states in a few word operations. Any other transition is an exception
+ * and costs one test and one OR when its source state is active.
+ */
+template <std::size_t Words>
+class bit_parallel_nfa {
+public:
+	typedef state_mask<Words> mask;
+	static const std::size_t max_states = Words * 64;
+
+	explicit bit_parallel_nfa(const nfa_description& nfa):
+		m_classes(nfa.transitions),
+		m_tables(m_classes.size()) {
+		std::size_t num_states = nfa.start_state + 1;
+		auto check = [&](int s) {
+			if (s < 0 || static_cast<std::size_t>(s) >= max_states) {
+				throw std::length_error("NFA state out of range for the bit parallel mask");
+			}
+			num_states = std::max<std::size_t>(num_states, s + 1);
+		};
+		check(nfa.start_state);
+		std::vector<std::map<int, mask>> exceptions(m_tables.size());
+		for (const auto& p: nfa.transitions) {
+			check(p.first.first);
+			check(p.second);
+			if (!m_classes.is_representative(p.first.second)) continue;
+			auto& t = m_tables[m_classes(p.first.second)];
+			int from = p.first.first;
+			if (p.second == from + 1) {
+				t.shift.set(from);
+			} else if (p.second == from) {
+				t.loop.set(from);
+			} else {
+				exceptions[m_classes(p.first.second)][from].set(p.second);
+			}
+		}
+		for (std::size_t cls = 0; cls < m_tables.size(); ++cls) {
+			m_tables[cls].exceptions.assign(exceptions[cls].begin(), exceptions[cls].end());
+		}
+		m_num_states = num_states;
+		m_start.set(nfa.start_state);
+
+		std::map<int, mask> output_masks;
+		for (const auto& p: nfa.output) {
+			check(p.first);
+			m_accept.set(p.first);
+			output_masks[p.second].set(p.first);
+		}
+		m_output_masks.assign(output_masks.begin(), output_masks.end());
+	}
+
+	mask step(const mask& d, unsigned int symbol) const {
+		const auto& t = m_tables[m_classes(symbol)];
+		mask next = (d & t.shift).shifted() | (d & t.loop);
+		for (const auto& e: t.exceptions) {
+			if (d.test(e.first)) next |= e.second;
+		}
+		return next;
+	}
+
+	// Output ids reported on entering d, in increasing order
+	template <typename Fn>
+	void for_each_output(const mask& d, const Fn& fn) const {
+		if (!d.intersects(m_accept)) return;
+		for (const auto& p: m_output_masks) {
+			if (d.intersects(p.second)) fn(p.first);
+		}
+	}
+
+	const mask& start() const { return m_start; }
+	const mask& accept() const { return m_accept; }
+	// Every output id with the states that report it
+	const std::vector<std::pair<int, mask>>& output_masks() const { return m_output_masks; }
+	std::size_t num_states() const { return m_num_states; }
+	std::size_t num_classes() const { return m_classes.size(); }
+
+private:
+	struct class_table {
+		mask shift;
+		mask loop;
+		std::vector<std::pair<int, mask>> exceptions;
+	};
+	symbol_classes m_classes;
+	std::vector<class_table> m_tables;
+	std::size_t m_num_states;
+	mask m_start;
+	mask m_accept;
+	std::vector<std::pair<int, mask>> m_output_masks;
+};
+
+}
+
+#endif
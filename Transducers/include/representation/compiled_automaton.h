@@ -0,0 +1,442 @@
+#ifndef TRANSDUCERS_REPRESENTATION_COMPILED_AUTOMATON_H_
+#define TRANSDUCERS_REPRESENTATION_COMPILED_AUTOMATON_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <representation/transition_description.h>
+#include <util/range.h>
+
+namespace representation {
+
+/** class compiled_automaton
+ *
+ * Dense, read only form of a dft_description. Input symbols are first
+ * mapped to an alphabet class and each (state, class) pair indexes a
+ * flat table of transitions, with pops stored in a shared pool. State
+ * ids index the table directly so descriptions should number their
+ * states densely from zero.
+ *
+ * The whole automaton lives in a single contiguous block which is
+ * written to disk as is, so loading a file is an mmap and a header
+ * check rather than a parse. Copies share the underlying block.
+ */
+class compiled_automaton {
+public:
+	static const uint32_t format_version = 1;
+
+	struct transition {
+		int32_t next;
+		int32_t output;
+		int32_t push;
+		uint32_t pop_begin;
+		uint32_t pop_end;
+	};
+
+	struct pop_entry {
+		int32_t label;
+		int32_t state;
+	};
+
+	// Everything known about one (state, symbol) pair, -1 marks an absent field
+	struct transition_record {
+		int state;
+		unsigned short symbol;
+		int next;
+		int output;
+		int push;
+	};
+
+	struct pop_record {
+		int state;
+		unsigned short symbol;
+		int label;
+		int new_state;
+	};
+
+	explicit compiled_automaton(const dft_description& dft) {
+		std::map<std::pair<int, unsigned short>, transition_record> merged;
+		auto record = [&](const std::pair<int, unsigned short>& k) -> transition_record& {
+			return merged.insert(std::make_pair(k,
+				transition_record{ k.first, k.second, -1, -1, -1 })).first->second;
+		};
+		for (const auto& p: dft.transitions) record(p.first).next = p.second;
+		for (const auto& p: dft.output) record(p.first).output = p.second;
+		for (const auto& p: dft.push) record(p.first).push = p.second;
+
+		std::vector<transition_record> records;
+		records.reserve(merged.size());
+		for (const auto& p: merged) records.push_back(p.second);
+		std::vector<pop_record> pop_records;
+		pop_records.reserve(dft.pop.size());
+		for (const auto& p: dft.pop) {
+			pop_records.push_back(pop_record{ p.first.first, p.first.second,
+				p.second.first, p.second.second });
+		}
+		compile(dft.start_state, records, pop_records);
+	}
+
+	// Compiles from records sorted by (state, symbol) with at most one
+	// transition_record per pair, as produced by description_builder
+	compiled_automaton(int start_state, const std::vector<transition_record>& records,
+			const std::vector<pop_record>& pop_records) {
+		compile(start_state, records, pop_records);
+	}
+
+	// Maps a file previously written by save()
+	explicit compiled_automaton(const std::string& filename) {
+		int fd = ::open(filename.c_str(), O_RDONLY);
+		if (fd < 0) {
+			throw std::runtime_error("Unable to open compiled automaton: " + filename);
+		}
+		struct stat st;
+		if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(header))) {
+			::close(fd);
+			throw std::runtime_error("Compiled automaton too small: " + filename);
+		}
+		std::size_t size = st.st_size;
+		void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (addr == MAP_FAILED) {
+			throw std::runtime_error("Unable to map compiled automaton: " + filename);
+		}
+		m_data = std::shared_ptr<const char>(static_cast<const char*>(addr),
+			[size](const char* p) { ::munmap(const_cast<char*>(p), size); });
+		m_size = size;
+		attach();
+	}
+
+	void save(const std::string& filename) const {
+		std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+		out.write(m_data.get(), m_size);
+		if (!out) {
+			throw std::runtime_error("Unable to write compiled automaton: " + filename);
+		}
+	}
+
+	int start_state() const { return m_header->start_state; }
+	std::size_t num_states() const { return m_header->num_states; }
+	std::size_t num_classes() const { return m_header->num_classes; }
+	std::size_t alphabet_size() const { return m_header->alphabet_size; }
+	std::size_t size_bytes() const { return m_size; }
+
+	// Symbols outside of the alphabet share class 0 which never transitions
+	unsigned int symbol_class(unsigned int symbol) const {
+		return symbol < m_header->alphabet_size ? m_classes[symbol] : 0;
+	}
+
+	std::size_t transition_index(int state, unsigned int symbol) const {
+		assert(state >= 0 && static_cast<std::size_t>(state) < num_states());
+		return state * m_header->num_classes + symbol_class(symbol);
+	}
+	const transition& lookup(int state, unsigned int symbol) const {
+		return m_transitions[transition_index(state, symbol)];
+	}
+
+	util::range<const pop_entry*> pops(const transition& t) const {
+		return util::range<const pop_entry*>(m_pops + t.pop_begin, m_pops + t.pop_end);
+	}
+
+	// The states which appear as the source or target of a transition
+	util::range<const int32_t*> states() const {
+		return util::range<const int32_t*>(m_states, m_states + m_header->num_used_states);
+	}
+
+	// The same automaton read over class ids instead of symbols, for input
+	// which an earlier stage such as util::byte_classifier has already
+	// mapped through symbol_class(). Class c is symbol c of the result.
+	compiled_automaton over_classes() const {
+		header h = *m_header;
+		h.alphabet_size = h.num_classes;
+		layout from(*m_header), to(h);
+		h.total_size = to.total;
+		std::shared_ptr<char> data(new char[to.total](), std::default_delete<char[]>());
+		std::memcpy(data.get(), &h, sizeof(h));
+		uint16_t* classes = reinterpret_cast<uint16_t*>(data.get() + to.classes);
+		for (uint32_t c = 0; c < h.num_classes; ++c) classes[c] = c;
+		std::memcpy(data.get() + to.transitions, m_data.get() + from.transitions, from.total - from.transitions);
+		return compiled_automaton(data, to.total);
+	}
+
+	static const int max_exit_bytes = 4;
+
+	// The bytes on which a state does anything but loop silently, that is
+	// change state, output, push or pop. count is -1 for states with more
+	// than max_exit_bytes of them, so that only states worth scanning
+	// ahead in have a set.
+	struct exit_set {
+		int count;
+		unsigned char bytes[max_exit_bytes];
+	};
+
+	const exit_set& exits(int state) const {
+		assert(state >= 0 && static_cast<std::size_t>(state) < num_states());
+		return (*m_exits)[state];
+	}
+
+private:
+	struct header {
+		char magic[4];
+		uint32_t byte_order;
+		uint32_t version;
+		int32_t start_state;
+		uint32_t num_states;
+		uint32_t num_classes;
+		uint32_t alphabet_size;
+		uint32_t num_used_states;
+		uint32_t num_pops;
+		uint32_t reserved;
+		uint64_t total_size;
+	};
+
+	struct layout {
+		std::size_t classes;
+		std::size_t transitions;
+		std::size_t pops;
+		std::size_t states;
+		std::size_t total;
+		explicit layout(const header& h) {
+			classes = align(sizeof(header));
+			transitions = align(classes + h.alphabet_size * sizeof(uint16_t));
+			pops = align(transitions +
+				static_cast<std::size_t>(h.num_states) * h.num_classes * sizeof(transition));
+			states = align(pops + h.num_pops * sizeof(pop_entry));
+			total = align(states + h.num_used_states * sizeof(int32_t));
+		}
+		static std::size_t align(std::size_t s) { return (s + 7) & ~std::size_t(7); }
+	};
+
+	static const uint32_t byte_order_mark = 0x01020304;
+
+	compiled_automaton(std::shared_ptr<const char> data, std::size_t size):
+		m_data(std::move(data)),
+		m_size(size) {
+		attach();
+	}
+
+	void attach() {
+		m_header = reinterpret_cast<const header*>(m_data.get());
+		if (std::memcmp(m_header->magic, "ATCA", 4) != 0) {
+			throw std::runtime_error("Not a compiled automaton");
+		}
+		if (m_header->byte_order != byte_order_mark) {
+			throw std::runtime_error("Compiled automaton has the wrong byte order");
+		}
+		if (m_header->version != format_version) {
+			std::ostringstream stream;
+			stream << "Wrong compiled automaton version. Expected: " << format_version
+				<< " got: " << m_header->version;
+			throw std::runtime_error(stream.str());
+		}
+		// Bounds the table sizes before layout multiplies them
+		if (static_cast<uint64_t>(m_header->num_states) * m_header->num_classes >
+				m_size / sizeof(transition)) {
+			throw std::runtime_error("Compiled automaton is truncated");
+		}
+		layout l(*m_header);
+		if (m_header->total_size != l.total || m_size < l.total) {
+			throw std::runtime_error("Compiled automaton is truncated");
+		}
+		m_classes = reinterpret_cast<const uint16_t*>(m_data.get() + l.classes);
+		m_transitions = reinterpret_cast<const transition*>(m_data.get() + l.transitions);
+		m_pops = reinterpret_cast<const pop_entry*>(m_data.get() + l.pops);
+		m_states = reinterpret_cast<const int32_t*>(m_data.get() + l.states);
+		validate();
+		find_exits();
+	}
+
+	// Checks every id a lookup may follow, so that a corrupt file fails
+	// here instead of reading or writing out of bounds later
+	void validate() const {
+		const uint32_t states = m_header->num_states;
+		auto is_state = [&](int32_t s) { return s >= 0 && static_cast<uint32_t>(s) < states; };
+		auto fail = [](const char* what) {
+			throw std::runtime_error(std::string("Corrupt compiled automaton: ") + what);
+		};
+		if (m_header->num_classes == 0) fail("no symbol classes");
+		if (!is_state(m_header->start_state)) fail("start state out of range");
+		for (uint32_t i = 0; i < m_header->alphabet_size; ++i) {
+			if (m_classes[i] >= m_header->num_classes) fail("symbol class out of range");
+		}
+		const std::size_t num_transitions = static_cast<std::size_t>(states) * m_header->num_classes;
+		for (std::size_t i = 0; i < num_transitions; ++i) {
+			const transition& t = m_transitions[i];
+			if (t.next != -1 && !is_state(t.next)) fail("transition target out of range");
+			if (t.push != -1 && !is_state(t.push)) fail("pushed label out of range");
+			if (t.pop_begin > t.pop_end || t.pop_end > m_header->num_pops) fail("pop range out of range");
+		}
+		for (uint32_t i = 0; i < m_header->num_pops; ++i) {
+			if (!is_state(m_pops[i].label) || !is_state(m_pops[i].state)) fail("pop entry out of range");
+		}
+		for (uint32_t i = 0; i < m_header->num_used_states; ++i) {
+			if (!is_state(m_states[i])) fail("used state out of range");
+		}
+	}
+
+	// Derived on load rather than stored, so files stay as they are
+	void find_exits() {
+		std::vector<std::vector<unsigned char>> class_bytes(num_classes());
+		for (int c = 0; c < 256; ++c) {
+			class_bytes[symbol_class(c)].push_back(c);
+		}
+		auto exits = std::make_shared<std::vector<exit_set>>(num_states());
+		for (std::size_t s = 0; s < num_states(); ++s) {
+			exit_set& e = (*exits)[s];
+			e.count = 0;
+			for (std::size_t cls = 0; cls < num_classes() && e.count != -1; ++cls) {
+				const transition& t = m_transitions[s * num_classes() + cls];
+				if (t.next == static_cast<int32_t>(s) && t.output == -1 && t.push == -1 &&
+						t.pop_begin == t.pop_end) {
+					continue;
+				}
+				for (unsigned char c: class_bytes[cls]) {
+					if (e.count == max_exit_bytes) {
+						e.count = -1;
+						break;
+					}
+					e.bytes[e.count++] = c;
+				}
+			}
+		}
+		m_exits = exits;
+	}
+
+	static void check_state(int s) {
+		if (s < 0) {
+			throw std::invalid_argument("Compiled automata require non-negative state ids");
+		}
+	}
+
+	void compile(int start_state, const std::vector<transition_record>& records,
+			const std::vector<pop_record>& pop_records) {
+		std::vector<int32_t> used_states;
+		int max_state = start_state;
+		unsigned int alphabet_size = 0;
+		auto note_key = [&](int s, unsigned short c) {
+			check_state(s);
+			max_state = std::max(max_state, s);
+			alphabet_size = std::max(alphabet_size, c + 1u);
+		};
+		check_state(start_state);
+		for (const auto& r: records) {
+			note_key(r.state, r.symbol);
+			for (int s: { r.next, r.push }) {
+				if (s != -1) note_key(s, 0);
+			}
+			if (r.next != -1) {
+				used_states.push_back(r.state);
+				used_states.push_back(r.next);
+			}
+		}
+		for (const auto& r: pop_records) {
+			note_key(r.state, r.symbol);
+			note_key(r.label, 0);
+			note_key(r.new_state, 0);
+		}
+		std::sort(used_states.begin(), used_states.end());
+		used_states.erase(std::unique(used_states.begin(), used_states.end()), used_states.end());
+
+		header h;
+		std::memset(&h, 0, sizeof(h));
+		std::memcpy(h.magic, "ATCA", 4);
+		h.byte_order = byte_order_mark;
+		h.version = format_version;
+		h.start_state = start_state;
+		h.num_states = max_state + 1;
+		h.alphabet_size = alphabet_size;
+		h.num_used_states = used_states.size();
+
+		// Symbols are grouped into classes by their column of the transition
+		// table, class 0 being the column with no transitions at all. The
+		// records are sorted by state so each column comes out in order.
+		std::map<unsigned short, std::vector<int>> signatures;
+		for (const auto& r: records) {
+			auto& sig = signatures[r.symbol];
+			sig.insert(sig.end(), { r.state, r.next, r.output, r.push });
+		}
+		for (const auto& r: pop_records) {
+			auto& sig = signatures[r.symbol];
+			sig.insert(sig.end(), { -2, r.state, r.label, r.new_state });
+		}
+
+		std::map<std::vector<int>, uint16_t> class_ids;
+		std::vector<unsigned short> representatives(1);
+		std::vector<uint16_t> classes(h.alphabet_size, 0);
+		for (const auto& p: signatures) {
+			auto inserted = class_ids.insert(std::make_pair(p.second, representatives.size()));
+			if (inserted.second) {
+				if (representatives.size() > 0xFFFF) {
+					throw std::overflow_error("Too many alphabet classes");
+				}
+				representatives.push_back(p.first);
+			}
+			classes[p.first] = inserted.first->second;
+		}
+		h.num_classes = representatives.size();
+
+		// Only the representative symbol of each class fills in its column
+		std::vector<transition> transitions(static_cast<std::size_t>(h.num_states) * h.num_classes,
+			transition{ -1, -1, -1, 0, 0 });
+		std::vector<pop_entry> pops;
+		auto column = [&](int s, unsigned short c) -> transition* {
+			uint16_t cls = classes[c];
+			if (representatives[cls] != c) return nullptr;
+			return &transitions[static_cast<std::size_t>(s) * h.num_classes + cls];
+		};
+		for (const auto& r: records) {
+			if (auto t = column(r.state, r.symbol)) {
+				t->next = r.next;
+				t->output = r.output;
+				t->push = r.push;
+			}
+		}
+		for (const auto& r: pop_records) {
+			if (auto t = column(r.state, r.symbol)) {
+				if (t->pop_begin == t->pop_end) t->pop_begin = pops.size();
+				pops.push_back(pop_entry{ r.label, r.new_state });
+				t->pop_end = pops.size();
+			}
+		}
+		h.num_pops = pops.size();
+
+		layout l(h);
+		h.total_size = l.total;
+		std::shared_ptr<char> data(new char[l.total](), std::default_delete<char[]>());
+		std::memcpy(data.get(), &h, sizeof(h));
+		std::copy(classes.begin(), classes.end(), reinterpret_cast<uint16_t*>(data.get() + l.classes));
+		std::copy(transitions.begin(), transitions.end(), reinterpret_cast<transition*>(data.get() + l.transitions));
+		std::copy(pops.begin(), pops.end(), reinterpret_cast<pop_entry*>(data.get() + l.pops));
+		std::copy(used_states.begin(), used_states.end(), reinterpret_cast<int32_t*>(data.get() + l.states));
+		m_data = data;
+		m_size = l.total;
+		attach();
+	}
+
+	std::shared_ptr<const char> m_data;
+	std::size_t m_size = 0;
+	const header* m_header = nullptr;
+	const uint16_t* m_classes = nullptr;
+	const transition* m_transitions = nullptr;
+	const pop_entry* m_pops = nullptr;
+	const int32_t* m_states = nullptr;
+	std::shared_ptr<const std::vector<exit_set>> m_exits;
+};
+
+}
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef TRANSDUCERS_REPRESENTATION_DESCRIPTION_BUILDER_H_
+#define TRANSDUCERS_REPRESENTATION_DESCRIPTION_BUILDER_H_
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <representation/compiled_automaton.h>
+#include <representation/transition_description.h>
+
+namespace representation {
+
+/** class description_builder
+ *
+ * Collects transitions for large generated automata. Everything is
+ * appended to flat vectors and only sorted, deduplicated and checked
+ * once when the description or compiled automaton is requested.
+ * Repeating a transition is harmless, but giving one (state, symbol)
+ * pair two different targets, pushes or outputs throws
+ * std::invalid_argument.
+ */
+class description_builder {
+public:
+	typedef compiled_automaton::transition_record transition_record;
+	typedef compiled_automaton::pop_record pop_record;
+
+	void set_start_state(int s) {
+		m_start_state = s;
+		m_finalised = false;
+	}
+
+	void reserve(std::size_t transitions, std::size_t pops = 0) {
+		m_records.reserve(transitions);
+		m_pops.reserve(pops);
+	}
+
+	void add_transition(int start, unsigned short c, int end, int push = -1, int output = -1) {
+		m_records.push_back(transition_record{ start, c, end, output, push });
+		m_finalised = false;
+	}
+
+	// Outputs on pairs without a plain transition, such as pops
+	void add_output(int start, unsigned short c, int output) {
+		add_transition(start, c, -1, -1, output);
+	}
+
+	void add_pop(int start, unsigned short c, int label, int new_state) {
+		m_pops.push_back(pop_record{ start, c, label, new_state });
+		m_finalised = false;
+	}
+
+	dft_description description() {
+		finalise();
+		dft_description ret;
+		ret.start_state = m_start_state;
+		ret.num_states = m_num_states;
+		for (const auto& r: m_records) {
+			auto key = std::make_pair(r.state, r.symbol);
+			if (r.next != -1) ret.transitions.emplace_hint(ret.transitions.end(), key, r.next);
+			if (r.push != -1) ret.push.emplace_hint(ret.push.end(), key, r.push);
+			if (r.output != -1) ret.output.emplace_hint(ret.output.end(), key, r.output);
+		}
+		for (const auto& p: m_pops) {
+			ret.pop.emplace_hint(ret.pop.end(), std::make_pair(p.state, p.symbol),
+				std::make_pair(p.label, p.new_state));
+		}
+		return ret;
+	}
+
+	compiled_automaton compile() {
+		finalise();
+		return compiled_automaton(m_start_state, m_records, m_pops);
+	}
+
+private:
+	static bool key_less(int s1, unsigned short c1, int s2, unsigned short c2) {
+		return s1 < s2 || (s1 == s2 && c1 < c2);
+	}
+
+	static void merge_field(int& into, int value, const transition_record& r, const char* what) {
+		if (value == -1 || into == value) return;
+		if (into != -1) {
+			std::ostringstream stream;
+			stream << "Conflicting " << what << " from state " << r.state
+				<< " on symbol " << r.symbol << ": " << into << " and " << value;
+			throw std::invalid_argument(stream.str());
+		}
+		into = value;
+	}
+
+	void finalise() {
+		if (m_finalised) return;
+		std::sort(m_records.begin(), m_records.end(),
+			[](const transition_record& lhs, const transition_record& rhs) {
+			return key_less(lhs.state, lhs.symbol, rhs.state, rhs.symbol);
+		});
+		auto out = m_records.begin();
+		for (auto iter = m_records.begin(); iter != m_records.end(); ++iter) {
+			if (out != m_records.begin() && (out - 1)->state == iter->state &&
+					(out - 1)->symbol == iter->symbol) {
+				auto& r = *(out - 1);
+				merge_field(r.next, iter->next, r, "transitions");
+				merge_field(r.push, iter->push, r, "pushes");
+				merge_field(r.output, iter->output, r, "outputs");
+			} else {
+				*out++ = *iter;
+			}
+		}
+		m_records.erase(out, m_records.end());
+
+		std::sort(m_pops.begin(), m_pops.end(), [](const pop_record& lhs, const pop_record& rhs) {
+			if (key_less(lhs.state, lhs.symbol, rhs.state, rhs.symbol)) return true;
+			if (key_less(rhs.state, rhs.symbol, lhs.state, lhs.symbol)) return false;
+			return std::make_pair(lhs.label, lhs.new_state) < std::make_pair(rhs.label, rhs.new_state);
+		});
+		m_pops.erase(std::unique(m_pops.begin(), m_pops.end(),
+			[](const pop_record& lhs, const pop_record& rhs) {
+			return lhs.state == rhs.state && lhs.symbol == rhs.symbol &&
+				lhs.label == rhs.label && lhs.new_state == rhs.new_state;
+		}), m_pops.end());
+
+		int max_state = m_start_state;
+		for (const auto& r: m_records) {
+			max_state = std::max({ max_state, r.state, r.next, r.push });
+		}
+		for (const auto& p: m_pops) {
+			max_state = std::max({ max_state, p.state, p.label, p.new_state });
+		}
+		m_num_states = max_state + 1;
+		m_finalised = true;
+	}
+
+	std::vector<transition_record> m_records;
+	std::vector<pop_record> m_pops;
+	int m_start_state = 0;
+	int m_num_states = 0;
+	bool m_finalised = false;
+};
+
+}
+
+#endif
@@ -0,0 +1,334 @@
+#ifndef TRANSDUCERS_REPRESENTATION_JSON_PATH_COMPILER_H_
+#define TRANSDUCERS_REPRESENTATION_JSON_PATH_COMPILER_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <representation/description_builder.h>
+#include <representation/json_tokenizer.h>
+#include <representation/transition_description.h>
+#include <symbols/match.h>
+
+namespace representation {
+
+/** class json_path_compiler
+ *
+ * Compiles JSONPath selectors such as $.a[*].b into a pushdown automaton
+ * over the symbols of tokenizer(). A step is .name, ['name'], .* or [*],
+ * and .. in place of . makes the step match at any depth. The wildcard
+ * selects both the members of objects and the elements of arrays.
+ *
+ * A state is the set of query steps matched by the current container
+ * together with the position in its grammar, such as expecting a member
+ * name or following a value. Opening a container pushes the state to
+ * return to once it closes, so the stack depth follows the nesting.
+ *
+ * Matching objects and arrays are reported with MATCH_FLAGS_START on the
+ * opening bracket and MATCH_FLAGS_END on the closing one. Strings and
+ * scalars are reported with both flags on their first byte, and the
+ * caller extends those matches to the end of the value. A value
+ * matching several rules reports a group id, above every rule id, which
+ * compile(groups) maps to those rules. Bytes following a complete top
+ * level value start another one, as in newline delimited JSON.
+ *
+ * Symbols the JSON grammar does not allow have no transition, so the
+ * pushdown transducer drops every stack they arrive on. This is what
+ * keeps blocks started from an unknown stack small, as most guesses at
+ * the enclosing containers fail within a few symbols.
+ */
+class json_path_compiler {
+public:
+	void add(const std::string& path, int rule) {
+		if (rule < 0 || static_cast<uint32_t>(rule) & symbols::match::MATCH_FLAGS_MASK) {
+			throw std::invalid_argument("Rule ids must fit below the match flags");
+		}
+		if (path.empty() || path[0] != '$') error(path, "expected '$'");
+		query q;
+		q.rule = rule;
+		std::size_t pos = 1;
+		while (pos < path.size()) {
+			step s;
+			s.descendant = path.compare(pos, 2, "..") == 0;
+			if (s.descendant) {
+				pos += 2;
+				if (path.compare(pos, 1, "[") == 0) error(path, "expected a name after '..'");
+			} else if (path[pos] == '.') {
+				++pos;
+			} else if (path[pos] != '[') {
+				error(path, "expected '.' or '['");
+			}
+			std::string name;
+			if (pos < path.size() && path[pos] == '[') {
+				if (path.compare(pos, 3, "[*]") == 0) {
+					name = "*";
+					pos += 3;
+				} else {
+					if (pos + 1 >= path.size() || (path[pos + 1] != '\'' && path[pos + 1] != '"')) {
+						error(path, "unsupported subscript");
+					}
+					char quote = path[pos + 1];
+					std::size_t end = path.find(quote, pos + 2);
+					if (end == std::string::npos || path.compare(end + 1, 1, "]") != 0) {
+						error(path, "unterminated subscript");
+					}
+					name = path.substr(pos + 2, end - pos - 2);
+					if (name.find_first_of("\"\\") != std::string::npos) {
+						error(path, "unsupported step \"" + name + "\"");
+					}
+					// A quoted '*' is a member name, not the wildcard
+					s.name = intern(name);
+					q.steps.push_back(s);
+					pos = end + 2;
+					continue;
+				}
+			} else {
+				std::size_t end = std::min(path.find_first_of(".[", pos), path.size());
+				name = path.substr(pos, end - pos);
+				if (name.empty()) error(path, "empty step");
+				pos = end;
+			}
+			if (name.find_first_of("\"\\ \t\r\n]()@?=") != std::string::npos) {
+				error(path, "unsupported step \"" + name + "\"");
+			}
+			s.name = name == "*" ? -1 : intern(name);
+			q.steps.push_back(s);
+		}
+		m_queries.push_back(std::move(q));
+	}
+
+	// The tokenizer whose symbols the compiled automaton reads
+	json_tokenizer tokenizer() const {
+		return json_tokenizer(m_names);
+	}
+
+	// Rule ids reported for values matching several queries, and the
+	// rules of each, in ascending order
+	typedef std::map<int, std::vector<int>> rule_groups;
+
+	// Throws std::invalid_argument if a value can match several queries,
+	// as only compile(groups) can report those
+	dft_description compile(std::size_t max_states = 16384) const {
+		return compile(nullptr, max_states);
+	}
+
+	// Throws std::length_error if the queries need more than max_states
+	dft_description compile(rule_groups& groups, std::size_t max_states = 16384) const {
+		groups.clear();
+		return compile(&groups, max_states);
+	}
+
+private:
+	dft_description compile(rule_groups* groups, std::size_t max_states) const {
+		json_tokenizer tok = tokenizer();
+		std::vector<std::size_t> base;
+		std::size_t positions = 0;
+		for (const auto& q: m_queries) {
+			base.push_back(positions);
+			positions += q.steps.size() + 1;
+		}
+		const int element = -2;
+		const int other_name = m_names.size();
+
+		std::map<std::vector<std::size_t>, int> set_ids;
+		std::vector<const std::vector<std::size_t>*> sets;
+		auto intern_set = [&](std::vector<std::size_t> s) {
+			auto inserted = set_ids.insert(std::make_pair(std::move(s), sets.size()));
+			if (inserted.second) sets.push_back(&inserted.first->first);
+			return inserted.first->second;
+		};
+		// The steps matched by a member (name >= 0) or element of a container
+		auto child = [&](int set, int name) {
+			std::vector<std::size_t> target;
+			for (std::size_t q = 0; q < m_queries.size(); ++q) {
+				const auto& steps = m_queries[q].steps;
+				for (std::size_t p: *sets[set]) {
+					if (p < base[q] || p >= base[q] + steps.size()) continue;
+					const step& s = steps[p - base[q]];
+					if (s.descendant) target.push_back(p);
+					if (s.name == -1 || (name >= 0 && s.name == name)) {
+						target.push_back(p + 1);
+					}
+				}
+			}
+			std::sort(target.begin(), target.end());
+			target.erase(std::unique(target.begin(), target.end()), target.end());
+			return intern_set(std::move(target));
+		};
+		int next_group = 0;
+		for (const auto& q: m_queries) next_group = std::max(next_group, q.rule + 1);
+		std::map<std::vector<int>, int> group_ids;
+		auto matched_rule = [&](int set) {
+			std::vector<int> rules;
+			for (std::size_t q = 0; q < m_queries.size(); ++q) {
+				std::size_t final_position = base[q] + m_queries[q].steps.size();
+				if (std::binary_search(sets[set]->begin(), sets[set]->end(), final_position)) {
+					rules.push_back(m_queries[q].rule);
+				}
+			}
+			std::sort(rules.begin(), rules.end());
+			rules.erase(std::unique(rules.begin(), rules.end()), rules.end());
+			if (rules.size() < 2) return rules.empty() ? -1 : rules.front();
+			if (groups == nullptr) {
+				throw std::invalid_argument("JSONPath queries match the same values, compile them with rule groups");
+			}
+			auto inserted = group_ids.insert(std::make_pair(rules, next_group));
+			if (inserted.second) {
+				if (static_cast<uint32_t>(next_group) & symbols::match::MATCH_FLAGS_MASK) {
+					throw std::length_error("JSONPath queries need too many rule groups");
+				}
+				groups->insert(std::make_pair(next_group++, std::move(rules)));
+			}
+			return inserted.first->second;
+		};
+
+		std::map<state, int> ids;
+		std::vector<state> states;
+		auto intern_state = [&](int set, container kind, position pos, int name = -1) {
+			state s{ set, kind, pos, name };
+			auto inserted = ids.insert(std::make_pair(s, states.size()));
+			if (inserted.second) {
+				if (states.size() >= max_states) {
+					throw std::length_error("JSONPath queries need too many automaton states");
+				}
+				states.push_back(s);
+			}
+			return inserted.first->second;
+		};
+
+		std::vector<std::size_t> start;
+		for (std::size_t b: base) start.push_back(b);
+
+		description_builder builder;
+		builder.set_start_state(intern_state(intern_set(start), root, value));
+		// Transitions within one container, along which the possible
+		// states below the top of the stack are the same
+		std::vector<std::pair<int, int>> moves;
+		std::vector<std::vector<int>> parents;
+		for (std::size_t id = 0; id < states.size(); ++id) {
+			const state st = states[id];
+			auto move = [&](int symbol, int next, int output = -1) {
+				builder.add_transition(id, symbol, next, -1, output);
+				moves.emplace_back(id, next);
+			};
+
+			bool accepts_value = st.pos == value || (st.kind == root && st.pos == after);
+			if (accepts_value) {
+				int target = st.kind == root ? st.set :
+					child(st.set, st.kind == array ? element : st.name);
+				int rule = matched_rule(target);
+				uint32_t flags = rule == -1 ? 0 : static_cast<uint32_t>(rule);
+				int start_output = rule == -1 ? -1 : static_cast<int>(symbols::match::MATCH_FLAGS_START | flags);
+				int value_output = rule == -1 ? -1 : static_cast<int>(
+					symbols::match::MATCH_FLAGS_START | symbols::match::MATCH_FLAGS_END | flags);
+				int ret = intern_state(st.set, st.kind, after);
+				for (auto open: { std::make_pair(tok.open_object_symbol(), object),
+						std::make_pair(tok.open_array_symbol(), array) }) {
+					int next = intern_state(target, open.second, open.second == object ? member : value);
+					builder.add_transition(id, open.first, next, ret, start_output);
+					parents.resize(states.size());
+					parents[next].push_back(ret);
+				}
+				move(tok.quote_symbol(), intern_state(st.set, st.kind, in_string), value_output);
+				move(tok.scalar_symbol(), ret, value_output);
+			}
+			if (st.pos == in_string || st.pos == in_name) {
+				for (int name = 0; name <= other_name; ++name) {
+					move(name, st.pos == in_string ? intern_state(st.set, st.kind, after) :
+						intern_state(st.set, st.kind, name_done, name));
+				}
+			}
+			if (st.kind == object && st.pos == member) {
+				move(tok.quote_symbol(), intern_state(st.set, st.kind, in_name));
+			}
+			if (st.kind == object && st.pos == name_done) {
+				move(tok.colon_symbol(), intern_state(st.set, st.kind, value, st.name));
+			}
+			if (st.kind != root && st.pos == after) {
+				move(tok.comma_symbol(), intern_state(st.set, st.kind, st.kind == object ? member : value));
+			}
+		}
+
+		// Pops are added once the possible parents of every state are known
+		parents.resize(states.size());
+		for (bool changed = true; changed; ) {
+			changed = false;
+			for (const auto& m: moves) {
+				if (m.first == m.second) continue;
+				auto& to = parents[m.second];
+				std::size_t size = to.size();
+				to.insert(to.end(), parents[m.first].begin(), parents[m.first].end());
+				std::sort(to.begin(), to.end());
+				to.erase(std::unique(to.begin(), to.end()), to.end());
+				changed = changed || to.size() != size;
+			}
+		}
+		for (std::size_t id = 0; id < states.size(); ++id) {
+			const state& st = states[id];
+			if (st.kind == root || (st.pos != after && st.pos != (st.kind == object ? member : value))) {
+				continue;
+			}
+			int rule = matched_rule(states[id].set);
+			int symbol = st.kind == object ? tok.close_object_symbol() : tok.close_array_symbol();
+			for (int parent: parents[id]) {
+				builder.add_pop(id, symbol, parent, parent);
+			}
+			if (rule != -1) {
+				builder.add_output(id, symbol, static_cast<int>(symbols::match::MATCH_FLAGS_END | rule));
+			}
+		}
+		return builder.description();
+	}
+
+	struct step {
+		bool descendant;
+		int name;
+	};
+	struct query {
+		std::vector<step> steps;
+		int rule;
+	};
+
+	enum container { root, object, array };
+	// Where in its container the automaton is: expecting a member name,
+	// inside one, after one, expecting a value, inside a string value or
+	// after a value
+	enum position { member, in_name, name_done, value, in_string, after };
+	struct state {
+		int set;
+		container kind;
+		position pos;
+		int name;
+
+		bool operator<(const state& other) const {
+			return std::tie(set, kind, pos, name) < std::tie(other.set, other.kind, other.pos, other.name);
+		}
+	};
+
+	[[noreturn]] static void error(const std::string& path, const std::string& what) {
+		std::ostringstream stream;
+		stream << "Invalid JSONPath \"" << path << "\": " << what;
+		throw std::invalid_argument(stream.str());
+	}
+
+	int intern(const std::string& name) {
+		auto inserted = m_name_ids.insert(std::make_pair(name, m_names.size()));
+		if (inserted.second) m_names.push_back(name);
+		return inserted.first->second;
+	}
+
+	std::vector<query> m_queries;
+	std::vector<std::string> m_names;
+	std::map<std::string, int> m_name_ids;
+};
+
+}
+
+#endif
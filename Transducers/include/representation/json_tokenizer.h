@@ -0,0 +1,153 @@
+#ifndef TRANSDUCERS_REPRESENTATION_JSON_TOKENIZER_H_
+#define TRANSDUCERS_REPRESENTATION_JSON_TOKENIZER_H_
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <representation/description_builder.h>
+#include <representation/transition_description.h>
+
+namespace representation {
+
+/** class json_tokenizer
+ *
+ * Generates a finite transducer over bytes which turns JSON into the
+ * structural events consumed by a JSONPath automaton. Brackets, braces,
+ * ':' and ',' outside strings produce their own symbols. A string
+ * produces quote_symbol() at its opening quote and, at its closing
+ * quote, string_symbol(i) if its raw contents equal the i-th name or
+ * other_string_symbol() otherwise. The first byte of a number, true,
+ * false or null produces scalar_symbol().
+ *
+ * Escaped characters never match a name, so names are compared with
+ * the unescaped bytes of the document. The tokenizer does not validate
+ * its input.
+ */
+class json_tokenizer {
+public:
+	explicit json_tokenizer(std::vector<std::string> names):
+		m_names(std::move(names)) {
+		for (const auto& n: m_names) {
+			for (char c: n) {
+				if (c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20) {
+					throw std::invalid_argument("Invalid member name \"" + n + "\"");
+				}
+			}
+		}
+	}
+
+	int string_symbol(std::size_t name) const { return name; }
+	int other_string_symbol() const { return m_names.size(); }
+	int open_object_symbol() const { return m_names.size() + 1; }
+	int close_object_symbol() const { return m_names.size() + 2; }
+	int open_array_symbol() const { return m_names.size() + 3; }
+	int close_array_symbol() const { return m_names.size() + 4; }
+	int colon_symbol() const { return m_names.size() + 5; }
+	int comma_symbol() const { return m_names.size() + 6; }
+	int quote_symbol() const { return m_names.size() + 7; }
+	int scalar_symbol() const { return m_names.size() + 8; }
+	std::size_t num_symbols() const { return m_names.size() + 9; }
+	const std::vector<std::string>& names() const { return m_names; }
+
+	dft_description description() const {
+		table t;
+		for (int i = 0; i <= string_start; ++i) t.add(other_string);
+
+		t.fill(outside, scalar, scalar_symbol());
+		structure(t, outside);
+		t.fill(scalar, scalar);
+		structure(t, scalar);
+		t.fill(escape, other_string);
+		string_state(t, other_string, other_string_symbol());
+
+		// Names are recognised by a trie hanging off string_start, with
+		// other_string collecting every string which leaves the trie
+		std::vector<std::map<unsigned char, int>> trie(1);
+		std::vector<int> trie_state(1, string_start);
+		std::vector<int> complete(1, -1);
+		for (std::size_t n = 0; n < m_names.size(); ++n) {
+			std::size_t node = 0;
+			for (unsigned char c: m_names[n]) {
+				auto inserted = trie[node].insert(std::make_pair(c, trie.size()));
+				if (inserted.second) {
+					trie.emplace_back();
+					trie_state.push_back(t.add(other_string));
+					complete.push_back(-1);
+				}
+				node = inserted.first->second;
+			}
+			complete[node] = n;
+		}
+		for (std::size_t node = 0; node < trie.size(); ++node) {
+			int from = trie_state[node];
+			string_state(t, from, complete[node] == -1 ? other_string_symbol() : string_symbol(complete[node]));
+			for (const auto& p: trie[node]) {
+				t.set(from, p.first, trie_state[p.second]);
+			}
+		}
+
+		description_builder builder;
+		builder.set_start_state(outside);
+		builder.reserve(t.next.size() * 256);
+		for (std::size_t from = 0; from < t.next.size(); ++from) {
+			for (int c = 0; c < 256; ++c) {
+				builder.add_transition(from, c, t.next[from][c], -1, t.output[from][c]);
+			}
+		}
+		return builder.description();
+	}
+
+private:
+	enum fixed_state {
+		outside, scalar, escape, other_string, string_start
+	};
+	struct table {
+		std::vector<std::array<int, 256>> next;
+		std::vector<std::array<int, 256>> output;
+
+		int add(int fill_state) {
+			next.emplace_back();
+			output.emplace_back();
+			next.back().fill(fill_state);
+			output.back().fill(-1);
+			return next.size() - 1;
+		}
+		void fill(int from, int to, int out = -1) {
+			next[from].fill(to);
+			output[from].fill(out);
+		}
+		void set(int from, unsigned char c, int to, int out = -1) {
+			next[from][c] = to;
+			output[from][c] = out;
+		}
+	};
+
+	// Whitespace, punctuation and quotes outside of strings
+	void structure(table& t, int from) const {
+		for (char c: std::string(" \t\r\n")) t.set(from, c, outside);
+		t.set(from, '{', outside, open_object_symbol());
+		t.set(from, '}', outside, close_object_symbol());
+		t.set(from, '[', outside, open_array_symbol());
+		t.set(from, ']', outside, close_array_symbol());
+		t.set(from, ':', outside, colon_symbol());
+		t.set(from, ',', outside, comma_symbol());
+		t.set(from, '"', string_start, quote_symbol());
+	}
+
+	// A state inside a string, which reports symbol at the closing quote
+	static void string_state(table& t, int from, int symbol) {
+		t.fill(from, other_string);
+		t.set(from, '\\', escape);
+		t.set(from, '"', outside, symbol);
+	}
+
+	std::vector<std::string> m_names;
+};
+
+}
+
+#endif
@@ -0,0 +1,210 @@
+#ifndef TRANSDUCERS_REPRESENTATION_PATH_QUERY_COMPILER_H_
+#define TRANSDUCERS_REPRESENTATION_PATH_QUERY_COMPILER_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <representation/description_builder.h>
+#include <representation/transition_description.h>
+#include <representation/xml_tokenizer.h>
+#include <symbols/match.h>
+
+namespace representation {
+
+/** class path_query_compiler
+ *
+ * Compiles simple path expressions such as /a/b//c, where a step may
+ * also be the wildcard '*', into a pushdown automaton over the symbols
+ * of tokenizer(). Each state is the set of query steps matched at the
+ * current depth. A start tag pushes the current state and an end tag
+ * pops it again, so the stack depth follows the element depth.
+ *
+ * Matching elements are reported with match_adapter events, the rule
+ * with MATCH_FLAGS_START on the start tag and with MATCH_FLAGS_END on
+ * the end tag. An element matching several rules reports a group id,
+ * above every rule id, which compile(groups) maps to those rules.
+ */
+class path_query_compiler {
+public:
+	void add(const std::string& path, int rule) {
+		if (rule < 0 || static_cast<uint32_t>(rule) & symbols::match::MATCH_FLAGS_MASK) {
+			throw std::invalid_argument("Rule ids must fit below the match flags");
+		}
+		query q;
+		q.rule = rule;
+		std::size_t pos = 0;
+		while (pos < path.size()) {
+			if (path[pos] != '/') error(path, "expected '/'");
+			step s;
+			s.descendant = pos + 1 < path.size() && path[pos + 1] == '/';
+			pos += s.descendant ? 2 : 1;
+			std::size_t end = path.find('/', pos);
+			if (end == std::string::npos) end = path.size();
+			std::string name = path.substr(pos, end - pos);
+			if (name.empty()) error(path, "empty step");
+			if (name.find_first_of(" \t\r\n<>[]()@=\"'") != std::string::npos) {
+				error(path, "unsupported step \"" + name + "\"");
+			}
+			s.name = name == "*" ? -1 : intern(name);
+			q.steps.push_back(s);
+			pos = end;
+		}
+		if (q.steps.empty()) error(path, "empty path");
+		m_queries.push_back(std::move(q));
+	}
+
+	// The tokenizer whose symbols the compiled automaton reads
+	xml_tokenizer tokenizer() const {
+		return xml_tokenizer(m_names);
+	}
+
+	// Rule ids reported for elements matching several queries, and the
+	// rules of each, in ascending order
+	typedef std::map<int, std::vector<int>> rule_groups;
+
+	// Throws std::invalid_argument if an element can match several
+	// queries, as only compile(groups) can report those
+	dft_description compile(std::size_t max_states = 4096) const {
+		return compile(nullptr, max_states);
+	}
+
+	// Throws std::length_error if the queries need more than max_states
+	dft_description compile(rule_groups& groups, std::size_t max_states = 4096) const {
+		groups.clear();
+		return compile(&groups, max_states);
+	}
+
+private:
+	dft_description compile(rule_groups* groups, std::size_t max_states) const {
+		xml_tokenizer tok = tokenizer();
+		std::vector<std::size_t> base;
+		std::size_t positions = 0;
+		for (const auto& q: m_queries) {
+			base.push_back(positions);
+			positions += q.steps.size() + 1;
+		}
+
+		std::map<std::vector<std::size_t>, int> ids;
+		std::vector<const std::vector<std::size_t>*> sets;
+		auto intern_set = [&](std::vector<std::size_t> s) {
+			auto inserted = ids.insert(std::make_pair(std::move(s), sets.size()));
+			if (inserted.second) {
+				if (sets.size() >= max_states) {
+					throw std::length_error("Path queries need too many automaton states");
+				}
+				sets.push_back(&inserted.first->first);
+			}
+			return inserted.first->second;
+		};
+		int next_group = 0;
+		for (const auto& q: m_queries) next_group = std::max(next_group, q.rule + 1);
+		std::map<std::vector<int>, int> group_ids;
+		auto matched_rule = [&](const std::vector<std::size_t>& s) {
+			std::vector<int> rules;
+			for (std::size_t q = 0; q < m_queries.size(); ++q) {
+				std::size_t final_position = base[q] + m_queries[q].steps.size();
+				if (std::binary_search(s.begin(), s.end(), final_position)) {
+					rules.push_back(m_queries[q].rule);
+				}
+			}
+			std::sort(rules.begin(), rules.end());
+			rules.erase(std::unique(rules.begin(), rules.end()), rules.end());
+			if (rules.size() < 2) return rules.empty() ? -1 : rules.front();
+			if (groups == nullptr) {
+				throw std::invalid_argument("Path queries match the same elements, compile them with rule groups");
+			}
+			auto inserted = group_ids.insert(std::make_pair(rules, next_group));
+			if (inserted.second) {
+				if (static_cast<uint32_t>(next_group) & symbols::match::MATCH_FLAGS_MASK) {
+					throw std::length_error("Path queries need too many rule groups");
+				}
+				groups->insert(std::make_pair(next_group++, std::move(rules)));
+			}
+			return inserted.first->second;
+		};
+
+		std::vector<std::size_t> start;
+		for (std::size_t b: base) start.push_back(b);
+
+		description_builder builder;
+		builder.set_start_state(intern_set(start));
+		// Every state that can be on the stack below each state
+		std::vector<std::vector<int>> parents;
+		for (std::size_t id = 0; id < sets.size(); ++id) {
+			for (std::size_t name = 0; name <= m_names.size(); ++name) {
+				std::vector<std::size_t> target;
+				for (std::size_t q = 0; q < m_queries.size(); ++q) {
+					const auto& steps = m_queries[q].steps;
+					for (std::size_t p: *sets[id]) {
+						if (p < base[q] || p >= base[q] + steps.size()) continue;
+						const step& s = steps[p - base[q]];
+						if (s.descendant) target.push_back(p);
+						if (s.name == -1 || static_cast<std::size_t>(s.name) == name) {
+							target.push_back(p + 1);
+						}
+					}
+				}
+				std::sort(target.begin(), target.end());
+				target.erase(std::unique(target.begin(), target.end()), target.end());
+				int rule = matched_rule(target);
+				int next = intern_set(std::move(target));
+				int symbol = name == m_names.size() ? tok.other_open_symbol() : tok.open_symbol(name);
+				builder.add_transition(id, symbol, next, id,
+					rule == -1 ? -1 : static_cast<int>(symbols::match::MATCH_FLAGS_START | rule));
+				parents.resize(sets.size());
+				parents[next].push_back(id);
+			}
+		}
+		for (std::size_t id = 0; id < sets.size(); ++id) {
+			auto& p = parents[id];
+			std::sort(p.begin(), p.end());
+			p.erase(std::unique(p.begin(), p.end()), p.end());
+			int rule = matched_rule(*sets[id]);
+			for (int symbol: { tok.close_symbol(), tok.self_close_symbol() }) {
+				for (int parent: p) {
+					builder.add_pop(id, symbol, parent, parent);
+				}
+				if (rule != -1) {
+					builder.add_output(id, symbol, static_cast<int>(symbols::match::MATCH_FLAGS_END | rule));
+				}
+			}
+		}
+		return builder.description();
+	}
+
+	struct step {
+		bool descendant;
+		int name;
+	};
+	struct query {
+		std::vector<step> steps;
+		int rule;
+	};
+
+	[[noreturn]] static void error(const std::string& path, const std::string& what) {
+		std::ostringstream stream;
+		stream << "Invalid path query \"" << path << "\": " << what;
+		throw std::invalid_argument(stream.str());
+	}
+
+	int intern(const std::string& name) {
+		auto inserted = m_name_ids.insert(std::make_pair(name, m_names.size()));
+		if (inserted.second) m_names.push_back(name);
+		return inserted.first->second;
+	}
+
+	std::vector<query> m_queries;
+	std::vector<std::string> m_names;
+	std::map<std::string, int> m_name_ids;
+};
+
+}
+
+#endif
@@ -0,0 +1,457 @@
+#ifndef TRANSDUCERS_REPRESENTATION_REGEX_COMPILER_H_
+#define TRANSDUCERS_REPRESENTATION_REGEX_COMPILER_H_
+
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <representation/description_builder.h>
+#include <representation/symbol_classes.h>
+#include <representation/transition_description.h>
+
+namespace representation {
+
+/** class regex_compiler
+ *
+ * Compiles a set of regular expressions, each tagged with a rule id,
+ * into one automaton over bytes which scans for all of them at once.
+ * The automaton reports a rule at every offset where a match of that
+ * rule ends, wherever the match started. Matches of the empty string
+ * are never reported.
+ *
+ * The supported syntax is literals, '.', escapes (\d \w \s and their
+ * negations, \n \r \t \xHH and escaped metacharacters), bracket
+ * classes, grouping with ( ) or (?: ), alternation and the * + ? {m}
+ * {m,} {m,n} quantifiers. Anything else, such as anchors or back
+ * references, throws std::invalid_argument.
+ *
+ * compile_nfa() gives the Glushkov automaton, suitable for the lazy DFA
+ * and bit parallel transducers, where each rule reports from its own
+ * states. compile() determinises it for finite_transducer, and as a
+ * dft_description has one output per transition, the lowest rule id
+ * ending at an offset is the one reported.
+ */
+class regex_compiler {
+public:
+	void add(const std::string& pattern, int rule) {
+		if (rule < 0) {
+			throw std::invalid_argument("Rule ids must be non-negative");
+		}
+		parser p(pattern);
+		m_patterns.emplace_back(p.parse(), rule);
+	}
+
+	nfa_description compile_nfa() const {
+		glushkov g;
+		nfa_description nfa;
+		nfa.start_state = 0;
+		for (int b = 0; b < 256; ++b) {
+			nfa.transitions.insert(std::make_pair(std::make_pair(0, b), 0));
+		}
+		for (const auto& p: m_patterns) {
+			auto info = g.visit(*p.first);
+			for (int q: info.first) {
+				add_edges(nfa, 0, q, g.chars[q]);
+			}
+			for (int l: info.last) {
+				nfa.output.insert(std::make_pair(l, p.second));
+			}
+		}
+		for (std::size_t p = 1; p < g.follow.size(); ++p) {
+			for (int q: g.follow[p]) {
+				add_edges(nfa, p, q, g.chars[q]);
+			}
+		}
+		nfa.num_states = g.chars.size();
+		return nfa;
+	}
+
+	// Throws std::length_error if determinisation needs more than max_states
+	dft_description compile(std::size_t max_states = 65536) const {
+		return determinise(compile_nfa(), max_states);
+	}
+
+	static dft_description determinise(const nfa_description& nfa, std::size_t max_states) {
+		symbol_classes classes(nfa.transitions);
+		std::vector<std::vector<int>> class_symbols(classes.size());
+		for (int b = 0; b < 256; ++b) {
+			class_symbols[classes(b)].push_back(b);
+		}
+
+		std::map<std::vector<int>, int> ids;
+		std::vector<const std::vector<int>*> sets;
+		auto intern = [&](std::vector<int> s) {
+			auto inserted = ids.insert(std::make_pair(std::move(s), sets.size()));
+			if (inserted.second) {
+				if (sets.size() >= max_states) {
+					throw std::length_error("Regular expressions need too many DFA states");
+				}
+				sets.push_back(&inserted.first->first);
+			}
+			return inserted.first->second;
+		};
+
+		description_builder builder;
+		builder.set_start_state(intern(std::vector<int>(1, nfa.start_state)));
+		for (std::size_t id = 0; id < sets.size(); ++id) {
+			for (const auto& symbols: class_symbols) {
+				if (symbols.empty()) continue;
+				std::vector<int> target;
+				for (int s: *sets[id]) {
+					auto range = nfa.transitions.equal_range(std::make_pair(s, symbols.front()));
+					for (auto iter = range.first; iter != range.second; ++iter) {
+						target.push_back(iter->second);
+					}
+				}
+				std::sort(target.begin(), target.end());
+				target.erase(std::unique(target.begin(), target.end()), target.end());
+				int output = -1;
+				for (int s: target) {
+					auto range = nfa.output.equal_range(s);
+					for (auto iter = range.first; iter != range.second; ++iter) {
+						if (output == -1 || iter->second < output) output = iter->second;
+					}
+				}
+				int next = intern(std::move(target));
+				for (int b: symbols) {
+					builder.add_transition(id, b, next, -1, output);
+				}
+			}
+		}
+		return builder.description();
+	}
+
+private:
+	typedef std::bitset<256> char_set;
+
+	struct node {
+		enum kind_type { symbol, empty, concat, alternate, star };
+		kind_type kind;
+		char_set chars;
+		std::vector<std::unique_ptr<node>> children;
+
+		explicit node(kind_type k): kind(k) {}
+		std::unique_ptr<node> clone() const {
+			std::unique_ptr<node> ret(new node(kind));
+			ret->chars = chars;
+			for (const auto& c: children) {
+				ret->children.push_back(c->clone());
+			}
+			return ret;
+		}
+	};
+	typedef std::unique_ptr<node> node_ptr;
+
+	static node_ptr make(typename node::kind_type k, node_ptr a = nullptr, node_ptr b = nullptr) {
+		node_ptr ret(new node(k));
+		if (a) ret->children.push_back(std::move(a));
+		if (b) ret->children.push_back(std::move(b));
+		return ret;
+	}
+
+	class parser {
+	public:
+		explicit parser(const std::string& pattern): m_pattern(pattern) {}
+
+		node_ptr parse() {
+			node_ptr ret = alternation();
+			if (m_pos != m_pattern.size()) error("unexpected ')'");
+			return ret;
+		}
+	private:
+		const std::string& m_pattern;
+		std::size_t m_pos = 0;
+
+		[[noreturn]] void error(const std::string& what) const {
+			std::ostringstream stream;
+			stream << "Invalid regular expression \"" << m_pattern << "\" at "
+				<< m_pos << ": " << what;
+			throw std::invalid_argument(stream.str());
+		}
+		bool at_end() const { return m_pos == m_pattern.size(); }
+		char peek() const { return m_pattern[m_pos]; }
+		unsigned char next() {
+			if (at_end()) error("unexpected end");
+			return m_pattern[m_pos++];
+		}
+
+		node_ptr alternation() {
+			node_ptr ret = concatenation();
+			while (!at_end() && peek() == '|') {
+				++m_pos;
+				ret = make(node::alternate, std::move(ret), concatenation());
+			}
+			return ret;
+		}
+
+		node_ptr concatenation() {
+			node_ptr ret = make(node::empty);
+			while (!at_end() && peek() != '|' && peek() != ')') {
+				ret = make(node::concat, std::move(ret), repetition());
+			}
+			return ret;
+		}
+
+		node_ptr repetition() {
+			node_ptr ret = atom();
+			while (!at_end()) {
+				char c = peek();
+				if (c == '*') {
+					++m_pos;
+					ret = make(node::star, std::move(ret));
+				} else if (c == '+') {
+					++m_pos;
+					node_ptr copy = ret->clone();
+					ret = make(node::concat, std::move(ret), make(node::star, std::move(copy)));
+				} else if (c == '?') {
+					++m_pos;
+					ret = make(node::alternate, std::move(ret), make(node::empty));
+				} else if (c == '{') {
+					ret = bounded(std::move(ret));
+				} else {
+					break;
+				}
+			}
+			return ret;
+		}
+
+		std::size_t number() {
+			if (at_end() || !std::isdigit(static_cast<unsigned char>(peek()))) error("expected a number");
+			std::size_t ret = 0;
+			while (!at_end() && std::isdigit(static_cast<unsigned char>(peek()))) {
+				ret = ret * 10 + (next() - '0');
+				if (ret > 1000) error("repeat count too large");
+			}
+			return ret;
+		}
+
+		node_ptr bounded(node_ptr base) {
+			++m_pos;
+			std::size_t min = number();
+			std::size_t max = min;
+			bool unbounded = false;
+			if (!at_end() && peek() == ',') {
+				++m_pos;
+				if (!at_end() && peek() == '}') {
+					unbounded = true;
+				} else {
+					max = number();
+				}
+			}
+			if (next() != '}') error("expected '}'");
+			if (max < min) error("bad repeat range");
+
+			node_ptr ret = make(node::empty);
+			for (std::size_t i = 0; i < min; ++i) {
+				ret = make(node::concat, std::move(ret), base->clone());
+			}
+			if (unbounded) {
+				return make(node::concat, std::move(ret), make(node::star, std::move(base)));
+			}
+			// Nest the optional copies so that a{1,3} is a(a(a)?)?
+			node_ptr tail = make(node::empty);
+			for (std::size_t i = min; i < max; ++i) {
+				tail = make(node::alternate,
+					make(node::concat, base->clone(), std::move(tail)), make(node::empty));
+			}
+			return make(node::concat, std::move(ret), std::move(tail));
+		}
+
+		node_ptr atom() {
+			unsigned char c = next();
+			node_ptr ret;
+			switch (c) {
+			case '(':
+				if (m_pattern.compare(m_pos, 2, "?:") == 0) {
+					m_pos += 2;
+				} else if (!at_end() && peek() == '?') {
+					error("unsupported group");
+				}
+				ret = alternation();
+				if (next() != ')') error("expected ')'");
+				return ret;
+			case '[':
+				ret = make(node::symbol);
+				ret->chars = bracket();
+				return ret;
+			case '.':
+				ret = make(node::symbol);
+				ret->chars.set();
+				ret->chars.reset('\n');
+				return ret;
+			case '\\':
+				ret = make(node::symbol);
+				ret->chars = escape(false);
+				return ret;
+			case '*': case '+': case '?': case '{':
+				error("nothing to repeat");
+			case '^': case '$':
+				error("anchors are not supported");
+			default:
+				ret = make(node::symbol);
+				ret->chars.set(c);
+				return ret;
+			}
+		}
+
+		static int hex_digit(char c) {
+			if (c >= '0' && c <= '9') return c - '0';
+			if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+			if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+			return -1;
+		}
+
+		char_set escape(bool in_bracket) {
+			unsigned char c = next();
+			char_set ret;
+			auto range = [&](int lo, int hi) {
+				for (int i = lo; i <= hi; ++i) ret.set(i);
+			};
+			switch (c) {
+			case 'd': range('0', '9'); return ret;
+			case 'D': range('0', '9'); return ret.flip();
+			case 'w': range('0', '9'); range('a', 'z'); range('A', 'Z'); ret.set('_'); return ret;
+			case 'W': range('0', '9'); range('a', 'z'); range('A', 'Z'); ret.set('_'); return ret.flip();
+			case 's': for (char s: std::string(" \t\n\r\f\v")) ret.set(static_cast<unsigned char>(s)); return ret;
+			case 'S': for (char s: std::string(" \t\n\r\f\v")) ret.set(static_cast<unsigned char>(s)); return ret.flip();
+			case 'n': ret.set('\n'); return ret;
+			case 'r': ret.set('\r'); return ret;
+			case 't': ret.set('\t'); return ret;
+			case 'f': ret.set('\f'); return ret;
+			case 'v': ret.set('\v'); return ret;
+			case 'x': {
+				int hi = hex_digit(next());
+				int lo = hex_digit(next());
+				if (hi < 0 || lo < 0) error("bad hex escape");
+				ret.set(hi * 16 + lo);
+				return ret;
+			}
+			case 'b':
+				// A word boundary outside of brackets, a backspace inside
+				if (!in_bracket) error("unsupported escape");
+				ret.set('\b');
+				return ret;
+			default:
+				if (std::isalnum(c)) error("unsupported escape");
+				ret.set(c);
+				return ret;
+			}
+		}
+
+		char_set bracket() {
+			char_set ret;
+			bool negate = false;
+			if (!at_end() && peek() == '^') {
+				negate = true;
+				++m_pos;
+			}
+			bool first = true;
+			while (first || at_end() || peek() != ']') {
+				first = false;
+				char_set item;
+				int lo = -1;
+				unsigned char c = next();
+				if (c == '\\') {
+					item = escape(true);
+					if (item.count() == 1) {
+						for (int i = 0; i < 256; ++i) if (item.test(i)) lo = i;
+					}
+				} else {
+					lo = c;
+					item.set(c);
+				}
+				if (lo >= 0 && m_pos + 1 < m_pattern.size() && peek() == '-' && m_pattern[m_pos + 1] != ']') {
+					++m_pos;
+					unsigned char h = next();
+					int hi = h;
+					if (h == '\\') {
+						char_set e = escape(true);
+						if (e.count() != 1) error("bad range");
+						for (int i = 0; i < 256; ++i) if (e.test(i)) hi = i;
+					}
+					if (hi < lo) error("bad range");
+					for (int i = lo; i <= hi; ++i) item.set(i);
+				}
+				ret |= item;
+			}
+			++m_pos;
+			return negate ? ret.flip() : ret;
+		}
+	};
+
+	struct glushkov {
+		// Position 0 is the shared start state
+		std::vector<char_set> chars = std::vector<char_set>(1);
+		std::vector<std::set<int>> follow = std::vector<std::set<int>>(1);
+
+		struct info {
+			bool nullable;
+			std::vector<int> first;
+			std::vector<int> last;
+		};
+
+		info visit(const node& n) {
+			switch (n.kind) {
+			case node::symbol: {
+				int p = chars.size();
+				chars.push_back(n.chars);
+				follow.emplace_back();
+				return info{ false, { p }, { p } };
+			}
+			case node::empty:
+				return info{ true, {}, {} };
+			case node::concat: {
+				info a = visit(*n.children[0]);
+				info b = visit(*n.children[1]);
+				for (int l: a.last) {
+					follow[l].insert(b.first.begin(), b.first.end());
+				}
+				info ret{ a.nullable && b.nullable, a.first, b.last };
+				if (a.nullable) ret.first.insert(ret.first.end(), b.first.begin(), b.first.end());
+				if (b.nullable) ret.last.insert(ret.last.end(), a.last.begin(), a.last.end());
+				return ret;
+			}
+			case node::alternate: {
+				info a = visit(*n.children[0]);
+				info b = visit(*n.children[1]);
+				a.nullable = a.nullable || b.nullable;
+				a.first.insert(a.first.end(), b.first.begin(), b.first.end());
+				a.last.insert(a.last.end(), b.last.begin(), b.last.end());
+				return a;
+			}
+			case node::star: {
+				info a = visit(*n.children[0]);
+				for (int l: a.last) {
+					follow[l].insert(a.first.begin(), a.first.end());
+				}
+				a.nullable = true;
+				return a;
+			}
+			}
+			return info{ true, {}, {} };
+		}
+	};
+
+	static void add_edges(nfa_description& nfa, int from, int to, const char_set& chars) {
+		for (int b = 0; b < 256; ++b) {
+			if (chars.test(b)) {
+				nfa.transitions.insert(std::make_pair(std::make_pair(from, b), to));
+			}
+		}
+	}
+
+	std::vector<std::pair<node_ptr, int>> m_patterns;
+};
+
+}
+
+#endif
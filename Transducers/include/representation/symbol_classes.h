@@ -0,0 +1,58 @@
+#ifndef TRANSDUCERS_REPRESENTATION_SYMBOL_CLASSES_H_
+#define TRANSDUCERS_REPRESENTATION_SYMBOL_CLASSES_H_
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace representation {
+
+/** class symbol_classes
+ *
+ * Partitions the input symbols of a transition map into classes of
+ * symbols with identical columns, so tables only need one column per
+ * class. Class 0 holds every symbol without a transition, including
+ * those beyond the largest symbol in the map. The lowest symbol of
+ * each class is its representative.
+ */
+class symbol_classes {
+public:
+	template <typename TransitionMap>
+	explicit symbol_classes(const TransitionMap& transitions) {
+		std::map<unsigned short, std::vector<std::pair<int, int>>> signatures;
+		for (const auto& p: transitions) {
+			signatures[p.first.second].emplace_back(p.first.first, p.second);
+		}
+		m_classes.assign(signatures.empty() ? 0 : signatures.rbegin()->first + 1, 0);
+		m_representatives.push_back(0);
+
+		std::map<std::vector<std::pair<int, int>>, unsigned int> class_ids;
+		for (auto& p: signatures) {
+			std::sort(p.second.begin(), p.second.end());
+			p.second.erase(std::unique(p.second.begin(), p.second.end()), p.second.end());
+			auto inserted = class_ids.insert(std::make_pair(p.second, m_representatives.size()));
+			if (inserted.second) m_representatives.push_back(p.first);
+			m_classes[p.first] = inserted.first->second;
+		}
+	}
+
+	unsigned int operator()(unsigned int symbol) const {
+		return symbol < m_classes.size() ? m_classes[symbol] : 0;
+	}
+	std::size_t size() const { return m_representatives.size(); }
+	std::size_t alphabet_size() const { return m_classes.size(); }
+
+	// Lets table builders fill each column once from a single symbol
+	bool is_representative(unsigned short symbol) const {
+		unsigned int cls = (*this)(symbol);
+		return cls != 0 && m_representatives[cls] == symbol;
+	}
+private:
+	std::vector<unsigned int> m_classes;
+	std::vector<unsigned short> m_representatives;
+};
+
+}
+
+#endif
@@ -9,6 +9,11 @@
 #include <boost/archive/text_oarchive.hpp>
 
 #include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <typeinfo>
 #include <utility>
 
 namespace representation {
@@ -41,9 +46,14 @@ public:
 	int start_state;
 	int num_states;
 
-	void add_transition(int start, unsigned short c, int end, int push, int output) {
-
-	};
+	// Convenience for small hand written automata, use description_builder
+	// for large generated ones. A push or output of -1 is not recorded.
+	void add_transition(int start, unsigned short c, int end, int push = -1, int output = -1) {
+		auto key = std::make_pair(start, c);
+		transitions.insert(std::make_pair(key, end));
+		if (push != -1) this->push.insert(std::make_pair(key, push));
+		if (output != -1) this->output.insert(std::make_pair(key, output));
+	}
 private:
 	template <class Archive>
 	void serialize(Archive& ar, const unsigned int version) {
@@ -66,6 +76,8 @@ private:
 };
 
 typedef transition_description<dt_type, dft_type> dft_description;
+// Non-deterministic automata report outputs for the states they enter
+typedef transition_description<nt_type, fsm_type> nfa_description;
 
 }
 
@@ -0,0 +1,207 @@
+#ifndef TRANSDUCERS_REPRESENTATION_XML_TOKENIZER_H_
+#define TRANSDUCERS_REPRESENTATION_XML_TOKENIZER_H_
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <representation/description_builder.h>
+#include <representation/transition_description.h>
+
+namespace representation {
+
+/** class xml_tokenizer
+ *
+ * Generates a finite transducer over bytes which turns XML into the tag
+ * events consumed by a path query automaton. Start tags whose name is
+ * one of the given names produce open_symbol(i), any other start tag
+ * produces other_open_symbol(), both at the byte following the name.
+ * End tags produce close_symbol() at their '>' and empty element tags
+ * produce self_close_symbol() at theirs. Comments, CDATA sections,
+ * processing instructions, declarations and quoted attribute values are
+ * skipped.
+ *
+ * The start state is the state for character data, so a block may be
+ * started in the start state at any '<' outside those constructs.
+ */
+class xml_tokenizer {
+public:
+	explicit xml_tokenizer(std::vector<std::string> names):
+		m_names(std::move(names)) {
+		for (const auto& n: m_names) {
+			if (n.empty()) {
+				throw std::invalid_argument("Element names must not be empty");
+			}
+			for (char c: n) {
+				if (is_space(c) || c == '/' || c == '>' || c == '<') {
+					throw std::invalid_argument("Invalid element name \"" + n + "\"");
+				}
+			}
+		}
+	}
+
+	int open_symbol(std::size_t name) const { return name; }
+	int other_open_symbol() const { return m_names.size(); }
+	int close_symbol() const { return m_names.size() + 1; }
+	int self_close_symbol() const { return m_names.size() + 2; }
+	std::size_t num_symbols() const { return m_names.size() + 3; }
+	const std::vector<std::string>& names() const { return m_names; }
+
+	dft_description description() const {
+		table t;
+		for (int i = 0; i <= other_name; ++i) t.add(text);
+
+		t.set(text, '<', lt);
+		t.fill(lt, other_name);
+		for (char c: std::string(" \t\r\n>")) t.set(lt, c, text);
+		t.set(lt, '<', lt);
+		t.set(lt, '/', close_tag);
+		t.set(lt, '!', bang);
+		t.set(lt, '?', pi);
+
+		t.fill(attrs, attrs);
+		t.set(attrs, '"', dq);
+		t.set(attrs, '\'', sq);
+		t.set(attrs, '/', tag_slash);
+		t.set(attrs, '>', text);
+		t.fill(dq, dq);
+		t.set(dq, '"', attrs);
+		t.fill(sq, sq);
+		t.set(sq, '\'', attrs);
+		t.fill(tag_slash, attrs);
+		t.set(tag_slash, '"', dq);
+		t.set(tag_slash, '\'', sq);
+		t.set(tag_slash, '/', tag_slash);
+		t.set(tag_slash, '>', text, self_close_symbol());
+
+		t.fill(close_tag, close_tag);
+		t.set(close_tag, '>', text, close_symbol());
+
+		t.fill(bang, decl);
+		t.set(bang, '-', bang_dash);
+		t.set(bang, '[', cdata_open);
+		t.set(bang, '>', text);
+		t.fill(bang_dash, decl);
+		t.set(bang_dash, '-', comment);
+		t.set(bang_dash, '>', text);
+		t.fill(decl, decl);
+		t.set(decl, '[', subset);
+		t.set(decl, '>', text);
+		t.fill(subset, subset);
+		t.set(subset, ']', decl);
+
+		t.fill(comment, comment);
+		t.set(comment, '-', comment_dash);
+		t.fill(comment_dash, comment);
+		t.set(comment_dash, '-', comment_end);
+		t.fill(comment_end, comment);
+		t.set(comment_end, '-', comment_end);
+		t.set(comment_end, '>', text);
+
+		const std::string cdata_marker = "CDATA[";
+		for (std::size_t i = 0; i < cdata_marker.size(); ++i) {
+			int from = cdata_open + i;
+			t.fill(from, decl);
+			t.set(from, '>', text);
+			t.set(from, cdata_marker[i], i + 1 < cdata_marker.size() ? from + 1 : cdata);
+		}
+		t.fill(cdata, cdata);
+		t.set(cdata, ']', cdata_bracket);
+		t.fill(cdata_bracket, cdata);
+		t.set(cdata_bracket, ']', cdata_end);
+		t.fill(cdata_end, cdata);
+		t.set(cdata_end, ']', cdata_end);
+		t.set(cdata_end, '>', text);
+
+		t.fill(pi, pi);
+		t.set(pi, '?', pi_end);
+		t.fill(pi_end, pi);
+		t.set(pi_end, '?', pi_end);
+		t.set(pi_end, '>', text);
+
+		// Element names are recognised by a trie hanging off lt, with
+		// other_name collecting every name which leaves the trie
+		std::vector<std::map<unsigned char, int>> trie(1);
+		std::vector<int> trie_state(1, lt);
+		std::vector<int> complete(1, -1);
+		for (std::size_t n = 0; n < m_names.size(); ++n) {
+			std::size_t node = 0;
+			for (unsigned char c: m_names[n]) {
+				auto inserted = trie[node].insert(std::make_pair(c, trie.size()));
+				if (inserted.second) {
+					trie.emplace_back();
+					trie_state.push_back(t.add(other_name));
+					complete.push_back(-1);
+				}
+				node = inserted.first->second;
+			}
+			complete[node] = n;
+		}
+		name_state(t, other_name, other_open_symbol());
+		for (std::size_t node = 0; node < trie.size(); ++node) {
+			int from = trie_state[node];
+			if (node != 0) {
+				name_state(t, from, complete[node] == -1 ? other_open_symbol() : open_symbol(complete[node]));
+			}
+			for (const auto& p: trie[node]) {
+				t.set(from, p.first, trie_state[p.second]);
+			}
+		}
+
+		description_builder builder;
+		builder.set_start_state(text);
+		builder.reserve(t.next.size() * 256);
+		for (std::size_t from = 0; from < t.next.size(); ++from) {
+			for (int c = 0; c < 256; ++c) {
+				builder.add_transition(from, c, t.next[from][c], -1, t.output[from][c]);
+			}
+		}
+		return builder.description();
+	}
+
+private:
+	enum fixed_state {
+		text, lt, attrs, dq, sq, tag_slash, close_tag,
+		bang, bang_dash, decl, subset, comment, comment_dash, comment_end,
+		cdata_open, cdata = cdata_open + 6, cdata_bracket, cdata_end,
+		pi, pi_end, other_name
+	};
+	struct table {
+		std::vector<std::array<int, 256>> next;
+		std::vector<std::array<int, 256>> output;
+
+		int add(int fill_state) {
+			next.emplace_back();
+			output.emplace_back();
+			next.back().fill(fill_state);
+			output.back().fill(-1);
+			return next.size() - 1;
+		}
+		void fill(int from, int to) { next[from].fill(to); }
+		void set(int from, unsigned char c, int to, int out = -1) {
+			next[from][c] = to;
+			output[from][c] = out;
+		}
+	};
+
+	static bool is_space(char c) {
+		return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+	}
+
+	// A state inside a start tag name, which reports symbol once the name ends
+	static void name_state(table& t, int from, int symbol) {
+		t.fill(from, other_name);
+		for (char c: std::string(" \t\r\n")) t.set(from, c, attrs, symbol);
+		t.set(from, '/', tag_slash, symbol);
+		t.set(from, '>', text, symbol);
+	}
+
+	std::vector<std::string> m_names;
+};
+
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef SYMBOLS_BOUNDARY_H_
+#define SYMBOLS_BOUNDARY_H_
+
+#include <cstddef>
+
+namespace symbols {
+
+/** The offset of a byte ending a field or a whole record */
+struct boundary {
+	std::size_t offset;
+	bool record;
+
+	explicit boundary(std::size_t offset = 0, bool record = false):
+		offset(offset),
+		record(record) {}
+
+	bool operator==(const boundary& other) const {
+		return offset == other.offset && record == other.record;
+	}
+	bool operator!=(const boundary& other) const {
+		return !(*this == other);
+	}
+};
+
+template <typename Stream>
+Stream& operator<<(Stream& s, const boundary& b) {
+	s << "boundary: " << b.offset << (b.record ? ", record" : ", field") << "\n";
+	return s;
+}
+
+}
+
+#endif
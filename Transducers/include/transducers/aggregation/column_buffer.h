@@ -0,0 +1,34 @@
+#ifndef TRANSDUCERS_AGGREGATION_COLUMN_BUFFER_H_
+#define TRANSDUCERS_AGGREGATION_COLUMN_BUFFER_H_
+
+#include <cstddef>
+
+#include <data_structures/match_columns.h>
+#include <symbols/match.h>
+#include <transducers/base/sink_transducer.h>
+
+namespace transducers {
+namespace aggregation {
+
+/** Stores matches as data_structures::match_columns, ready to be handed
+ * over column by column or written out with match_columns::save().
+ */
+class column_buffer : public base::sink_transducer<symbols::match, data_structures::match_columns> {
+public:
+	void process_symbol(partial_result& pr, const input_symbol& s, std::size_t /*offset*/) const {
+		pr.push_back(s);
+	}
+
+	void merge_results(partial_result& lhs, const partial_result& rhs) const {
+		lhs.append(rhs);
+	}
+
+	std::size_t memory_usage(const partial_result& p) const {
+		return sizeof(p) + p.heap_usage();
+	}
+};
+
+}
+}
+
+#endif
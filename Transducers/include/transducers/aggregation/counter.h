@@ -0,0 +1,30 @@
+#ifndef TRANSDUCERS_AGGREGATION_COUNTER_H_
+#define TRANSDUCERS_AGGREGATION_COUNTER_H_
+
+#include <cstddef>
+
+#include <transducers/base/sink_transducer.h>
+
+namespace transducers {
+namespace aggregation {
+
+/** Counts the input symbols */
+template <typename SymbolType>
+class counter : public base::sink_transducer<SymbolType, std::size_t> {
+public:
+	using partial_result = typename base::sink_transducer<SymbolType, std::size_t>::partial_result;
+	using input_symbol = typename base::sink_transducer<SymbolType, std::size_t>::input_symbol;
+
+	void process_symbol(partial_result& pr, const input_symbol& /*s*/, std::size_t /*offset*/) const {
+		++pr;
+	}
+
+	void merge_results(partial_result& lhs, const partial_result& rhs) const {
+		lhs += rhs;
+	}
+};
+
+}
+}
+
+#endif
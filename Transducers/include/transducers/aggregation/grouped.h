@@ -0,0 +1,55 @@
+#ifndef TRANSDUCERS_AGGREGATION_GROUPED_H_
+#define TRANSDUCERS_AGGREGATION_GROUPED_H_
+
+#include <cstddef>
+#include <vector>
+
+#include <symbols/match.h>
+#include <transducers/base/sink_transducer.h>
+
+namespace transducers {
+namespace aggregation {
+
+/** Runs a separate Aggregate, such as counter or min_max over matches,
+ * for each match rule. The partial result holds one partial result of
+ * Aggregate per rule up to the largest rule seen, so its size depends
+ * on the number of rules and not on the number of matches.
+ */
+template <typename Aggregate>
+class grouped : public base::sink_transducer<symbols::match,
+	std::vector<typename Aggregate::partial_result>>
+{
+public:
+	using partial_result = typename base::sink_transducer<symbols::match,
+		std::vector<typename Aggregate::partial_result>>::partial_result;
+	using input_symbol = symbols::match;
+
+	explicit grouped(Aggregate aggregate = Aggregate()):
+		m_aggregate(aggregate) {}
+
+	void process_symbol(partial_result& pr, const input_symbol& s, std::size_t offset) const {
+		if (s.rule >= pr.size()) grow(pr, s.rule + 1);
+		m_aggregate.process_symbol(pr[s.rule], s, offset);
+	}
+
+	void merge_results(partial_result& lhs, const partial_result& rhs) const {
+		if (rhs.size() > lhs.size()) grow(lhs, rhs.size());
+		for (std::size_t r = 0; r < rhs.size(); ++r) {
+			m_aggregate.merge_results(lhs[r], rhs[r]);
+		}
+	}
+
+	const Aggregate& aggregate() const { return m_aggregate; }
+
+private:
+	void grow(partial_result& pr, std::size_t size) const {
+		while (pr.size() < size) pr.push_back(m_aggregate.identity_result());
+	}
+
+	Aggregate m_aggregate;
+};
+
+}
+}
+
+#endif
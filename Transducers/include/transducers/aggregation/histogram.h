@@ -0,0 +1,58 @@
+#ifndef TRANSDUCERS_AGGREGATION_HISTOGRAM_H_
+#define TRANSDUCERS_AGGREGATION_HISTOGRAM_H_
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include <transducers/aggregation/projections.h>
+#include <transducers/base/sink_transducer.h>
+
+namespace transducers {
+namespace aggregation {
+
+/** Counts the input symbols per bucket, the bucket being the projected
+ * value divided by bucket_width. Values beyond the last bucket are
+ * counted in it, so the result always has exactly buckets entries. With
+ * match_rule as the projection this counts matches per rule.
+ */
+template <typename SymbolType, typename Projection = identity>
+class histogram : public base::sink_transducer<SymbolType, std::vector<std::size_t>> {
+public:
+	using partial_result = typename base::sink_transducer<SymbolType, std::vector<std::size_t>>::partial_result;
+	using input_symbol = typename base::sink_transducer<SymbolType, std::vector<std::size_t>>::input_symbol;
+
+	explicit histogram(std::size_t buckets, std::size_t bucket_width = 1,
+			Projection projection = Projection()):
+		m_buckets(buckets),
+		m_bucket_width(bucket_width),
+		m_projection(projection) {
+		if (buckets == 0 || bucket_width == 0) {
+			throw std::invalid_argument("Histograms need at least one bucket of non-zero width");
+		}
+	}
+
+	void process_symbol(partial_result& pr, const input_symbol& s, std::size_t /*offset*/) const {
+		std::size_t bucket = static_cast<std::size_t>(m_projection(s)) / m_bucket_width;
+		++pr[bucket < m_buckets ? bucket : m_buckets - 1];
+	}
+
+	void merge_results(partial_result& lhs, const partial_result& rhs) const {
+		for (std::size_t b = 0; b < m_buckets; ++b) {
+			lhs[b] += rhs[b];
+		}
+	}
+
+	partial_result initial_result() const { return partial_result(m_buckets, 0); }
+	partial_result identity_result() const { return partial_result(m_buckets, 0); }
+
+private:
+	std::size_t m_buckets;
+	std::size_t m_bucket_width;
+	Projection m_projection;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef TRANSDUCERS_AGGREGATION_MATCH_BUFFER_H_
+#define TRANSDUCERS_AGGREGATION_MATCH_BUFFER_H_
+
+#include <cstddef>
+
+#include <data_structures/match_list.h>
+#include <symbols/match.h>
+#include <transducers/base/sink_transducer.h>
+
+namespace transducers {
+namespace aggregation {
+
+/** Stores matches in a data_structures::match_list, which takes half the
+ * memory of a symbol_buffer<symbols::match> and half the bytes to copy
+ * when merging.
+ */
+class match_buffer : public base::sink_transducer<symbols::match, data_structures::match_list> {
+public:
+	void process_symbol(partial_result& pr, const input_symbol& s, std::size_t /*offset*/) const {
+		pr.push_back(s);
+	}
+
+	void merge_results(partial_result& lhs, const partial_result& rhs) const {
+		lhs.append(rhs);
+	}
+
+	std::size_t memory_usage(const partial_result& p) const {
+		return sizeof(p) + p.heap_usage();
+	}
+};
+
+}
+}
+
+#endif
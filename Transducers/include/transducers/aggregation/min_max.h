@@ -0,0 +1,67 @@
+#ifndef TRANSDUCERS_AGGREGATION_MIN_MAX_H_
+#define TRANSDUCERS_AGGREGATION_MIN_MAX_H_
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include <transducers/aggregation/projections.h>
+#include <transducers/base/sink_transducer.h>
+
+namespace transducers {
+namespace aggregation {
+
+/** Partial state of min_max, min and max are only meaningful when count
+ * is not zero.
+ */
+template <typename ValueType>
+struct extremes {
+	std::size_t count = 0;
+	ValueType min{};
+	ValueType max{};
+};
+
+/** Tracks the smallest and largest projected value of the input symbols,
+ * and how many there were.
+ */
+template <typename SymbolType, typename Projection = identity,
+	typename ValueType = typename std::decay<
+		decltype(std::declval<Projection>()(std::declval<SymbolType>()))>::type>
+class min_max : public base::sink_transducer<SymbolType, extremes<ValueType>> {
+public:
+	using partial_result = typename base::sink_transducer<SymbolType, extremes<ValueType>>::partial_result;
+	using input_symbol = typename base::sink_transducer<SymbolType, extremes<ValueType>>::input_symbol;
+
+	explicit min_max(Projection projection = Projection()):
+		m_projection(projection) {}
+
+	void process_symbol(partial_result& pr, const input_symbol& s, std::size_t /*offset*/) const {
+		ValueType value = m_projection(s);
+		if (pr.count++ == 0) {
+			pr.min = pr.max = value;
+		} else if (value < pr.min) {
+			pr.min = value;
+		} else if (pr.max < value) {
+			pr.max = value;
+		}
+	}
+
+	void merge_results(partial_result& lhs, const partial_result& rhs) const {
+		if (rhs.count == 0) return;
+		if (lhs.count == 0) {
+			lhs = rhs;
+			return;
+		}
+		lhs.count += rhs.count;
+		if (rhs.min < lhs.min) lhs.min = rhs.min;
+		if (lhs.max < rhs.max) lhs.max = rhs.max;
+	}
+
+private:
+	Projection m_projection;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef TRANSDUCERS_AGGREGATION_OFFSET_BUFFER_H_
+#define TRANSDUCERS_AGGREGATION_OFFSET_BUFFER_H_
+
+#include <cstddef>
+
+#include <data_structures/offset_index.h>
+#include <transducers/base/sink_transducer.h>
+
+namespace transducers {
+namespace aggregation {
+
+/** Stores offset symbols, such as those of delimiter_index, in a
+ * data_structures::offset_index, which takes half the memory of a
+ * symbol_buffer<std::size_t>. Offsets must arrive in order.
+ */
+class offset_buffer : public base::sink_transducer<std::size_t, data_structures::offset_index> {
+public:
+	void process_symbol(partial_result& pr, const input_symbol& s, std::size_t /*offset*/) const {
+		pr.push_back(s);
+	}
+
+	void merge_results(partial_result& lhs, const partial_result& rhs) const {
+		lhs.append(rhs);
+	}
+
+	std::size_t memory_usage(const partial_result& p) const {
+		return sizeof(p) + p.heap_usage();
+	}
+};
+
+}
+}
+
+#endif
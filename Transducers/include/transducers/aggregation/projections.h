@@ -0,0 +1,36 @@
+#ifndef TRANSDUCERS_AGGREGATION_PROJECTIONS_H_
+#define TRANSDUCERS_AGGREGATION_PROJECTIONS_H_
+
+#include <cstddef>
+
+#include <symbols/match.h>
+
+namespace transducers {
+namespace aggregation {
+
+/** Projections pick the value an aggregating sink works on out of each
+ * input symbol.
+ */
+
+// The symbol itself
+struct identity {
+	template <typename T>
+	const T& operator()(const T& t) const { return t; }
+};
+
+// The rule of a match
+struct match_rule {
+	std::size_t operator()(const symbols::match& m) const { return m.rule; }
+};
+
+// The number of bytes covered by a match, both ends included
+struct match_length {
+	std::size_t operator()(const symbols::match& m) const {
+		return m.end_offset - m.start_offset + 1;
+	}
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef TRANSDUCERS_AGGREGATION_SPILL_BUFFER_H_
+#define TRANSDUCERS_AGGREGATION_SPILL_BUFFER_H_
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#include <data_structures/spill_list.h>
+#include <transducers/base/sink_transducer.h>
+
+namespace transducers {
+namespace aggregation {
+
+/** Stores the input symbols like symbol_buffer, but in a
+ * data_structures::spill_list whose in memory part is appended to one
+ * temporary file in directory whenever it grows past memory_limit
+ * bytes. Merging shares the files of the right hand result, and the
+ * terminal result is read back with spill_list::for_each(), so memory
+ * stays near memory_limit per block whatever the size of the output,
+ * with one open file per block at most.
+ */
+template <typename SymbolType>
+class spill_buffer : public base::sink_transducer<SymbolType, data_structures::spill_list<SymbolType>> {
+public:
+	using partial_result = typename base::sink_transducer<SymbolType,
+		data_structures::spill_list<SymbolType>>::partial_result;
+	using input_symbol = typename base::sink_transducer<SymbolType,
+		data_structures::spill_list<SymbolType>>::input_symbol;
+
+	explicit spill_buffer(std::size_t memory_limit = 1 << 20,
+			std::string directory = partial_result::default_directory()):
+		m_memory_limit(memory_limit),
+		m_directory(std::move(directory)) {}
+
+	void process_symbol(partial_result& pr, const input_symbol& s, std::size_t /*offset*/) const {
+		pr.push_back(s);
+		if (pr.memory_bytes() >= m_memory_limit) pr.spill();
+	}
+
+	void merge_results(partial_result& lhs, const partial_result& rhs) const {
+		lhs.append(rhs);
+		if (lhs.memory_bytes() >= m_memory_limit) lhs.spill();
+	}
+
+	partial_result initial_result() const { return partial_result(m_directory); }
+	partial_result identity_result() const { return partial_result(m_directory); }
+
+	std::size_t memory_usage(const partial_result& p) const {
+		return sizeof(p) + p.heap_usage();
+	}
+
+private:
+	std::size_t m_memory_limit;
+	std::string m_directory;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef TRANSDUCERS_AGGREGATION_STREAM_SINK_H_
+#define TRANSDUCERS_AGGREGATION_STREAM_SINK_H_
+
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include <transducers/base/sink_transducer.h>
+
+namespace transducers {
+namespace aggregation {
+
+/** Partial state of stream_sink. Only the leftmost result, the one
+ * started from initial_result(), hands symbols on; the others keep them
+ * in pending until they are merged into it.
+ */
+template <typename SymbolType>
+struct stream_block {
+	bool leftmost = false;
+	std::size_t emitted = 0;
+	std::vector<SymbolType> pending;
+};
+
+/** class stream_sink
+ *
+ * Hands every input symbol to a callback in input order, as soon as
+ * everything before it is known, instead of storing the whole output.
+ * Symbols reaching the leftmost result are passed on at once, and the
+ * pending symbols of any other result are passed on when it is merged
+ * into the leftmost one, and freed with it. Combined with run_windowed this bounds the
+ * buffered output to one window.
+ *
+ * The callback is only ever called along the chain of merges into the
+ * leftmost result, so it sees one call at a time.
+ */
+template <typename SymbolType>
+class stream_sink : public base::sink_transducer<SymbolType, stream_block<SymbolType>> {
+public:
+	using partial_result = typename base::sink_transducer<SymbolType, stream_block<SymbolType>>::partial_result;
+	using input_symbol = typename base::sink_transducer<SymbolType, stream_block<SymbolType>>::input_symbol;
+	typedef std::function<void(const SymbolType&)> callback;
+
+	explicit stream_sink(callback emit):
+		m_emit(std::move(emit)) {}
+
+	// Writes each symbol to out followed by separator
+	explicit stream_sink(std::ostream& out, char separator = '\n'):
+		m_emit([&out, separator](const SymbolType& s) { out << s << separator; }) {}
+
+	void process_symbol(partial_result& pr, const input_symbol& s, std::size_t /*offset*/) const {
+		if (pr.leftmost) {
+			m_emit(s);
+			++pr.emitted;
+		} else {
+			pr.pending.push_back(s);
+		}
+	}
+
+	void merge_results(partial_result& lhs, const partial_result& rhs) const {
+		if (lhs.leftmost) {
+			for (const auto& s: rhs.pending) m_emit(s);
+			lhs.emitted += rhs.pending.size();
+		} else {
+			lhs.pending.insert(lhs.pending.end(), rhs.pending.begin(), rhs.pending.end());
+		}
+	}
+
+	partial_result initial_result() const {
+		partial_result ret;
+		ret.leftmost = true;
+		return ret;
+	}
+
+	std::size_t memory_usage(const partial_result& p) const {
+		return sizeof(p) + p.pending.capacity() * sizeof(SymbolType);
+	}
+
+private:
+	callback m_emit;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef TRANSDUCERS_AGGREGATION_SUM_H_
+#define TRANSDUCERS_AGGREGATION_SUM_H_
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include <transducers/aggregation/projections.h>
+#include <transducers/base/sink_transducer.h>
+
+namespace transducers {
+namespace aggregation {
+
+/** Adds up the projected values of the input symbols, starting from a
+ * value initialised ValueType.
+ */
+template <typename SymbolType, typename Projection = identity,
+	typename ValueType = typename std::decay<
+		decltype(std::declval<Projection>()(std::declval<SymbolType>()))>::type>
+class sum : public base::sink_transducer<SymbolType, ValueType> {
+public:
+	using partial_result = typename base::sink_transducer<SymbolType, ValueType>::partial_result;
+	using input_symbol = typename base::sink_transducer<SymbolType, ValueType>::input_symbol;
+
+	explicit sum(Projection projection = Projection()):
+		m_projection(projection) {}
+
+	void process_symbol(partial_result& pr, const input_symbol& s, std::size_t /*offset*/) const {
+		pr += m_projection(s);
+	}
+
+	void merge_results(partial_result& lhs, const partial_result& rhs) const {
+		lhs += rhs;
+	}
+
+private:
+	Projection m_projection;
+};
+
+}
+}
+
+#endif
@@ -6,12 +6,16 @@
 #include <iterator>
 #include <algorithm>
 
+#include <data_structures/chunk_list.h>
 #include <transducers/base/sink_transducer.h>
 
 namespace transducers {
 namespace aggregation {
 
-/** Stores all of the input symbols into an internal state */
+/** Stores all of the input symbols into an internal state. With a
+ * data_structures::chunk_list as storage, merging shares the segments of
+ * the right hand result rather than copying its symbols.
+ */
 
 template <typename SymbolType, typename StorageType = std::vector<SymbolType>>
 class symbol_buffer : public base::sink_transducer<SymbolType, StorageType> {
@@ -24,8 +28,19 @@ public:
 	}
 
 	void merge_results(partial_result& lhs, const partial_result& rhs) const {
+		append(lhs, rhs);
+	}
+
+private:
+	template <typename Storage>
+	static void append(Storage& lhs, const Storage& rhs) {
 		std::copy(rhs.begin(), rhs.end(), std::back_inserter(lhs));
 	}
+
+	template <typename T>
+	static void append(data_structures::chunk_list<T>& lhs, const data_structures::chunk_list<T>& rhs) {
+		lhs.append(rhs);
+	}
 };
 
 }
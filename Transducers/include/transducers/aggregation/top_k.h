@@ -0,0 +1,76 @@
+#ifndef TRANSDUCERS_AGGREGATION_TOP_K_H_
+#define TRANSDUCERS_AGGREGATION_TOP_K_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <transducers/aggregation/projections.h>
+#include <transducers/base/sink_transducer.h>
+
+namespace transducers {
+namespace aggregation {
+
+/** Keeps the k input symbols with the largest projected values, ties
+ * going to the symbol with the lower offset, so the result does not
+ * depend on how the input was split into blocks. The partial result
+ * is a heap of (symbol, offset) pairs with the weakest on top, and
+ * sorted() lists it from the strongest down.
+ */
+template <typename SymbolType, typename Projection = identity>
+class top_k : public base::sink_transducer<SymbolType, std::vector<std::pair<SymbolType, std::size_t>>> {
+public:
+	using entry = std::pair<SymbolType, std::size_t>;
+	using partial_result = typename base::sink_transducer<SymbolType, std::vector<entry>>::partial_result;
+	using input_symbol = typename base::sink_transducer<SymbolType, std::vector<entry>>::input_symbol;
+
+	explicit top_k(std::size_t k, Projection projection = Projection()):
+		m_k(k),
+		m_projection(projection) {}
+
+	void process_symbol(partial_result& pr, const input_symbol& s, std::size_t offset) const {
+		insert(pr, entry(s, offset));
+	}
+
+	void merge_results(partial_result& lhs, const partial_result& rhs) const {
+		for (const auto& e: rhs) insert(lhs, e);
+	}
+
+	std::vector<SymbolType> sorted(const partial_result& pr) const {
+		std::vector<entry> entries(pr);
+		std::sort(entries.begin(), entries.end(), [this](const entry& lhs, const entry& rhs) {
+			return stronger(lhs, rhs);
+		});
+		std::vector<SymbolType> ret;
+		ret.reserve(entries.size());
+		for (const auto& e: entries) ret.push_back(e.first);
+		return ret;
+	}
+
+private:
+	bool stronger(const entry& lhs, const entry& rhs) const {
+		auto l = m_projection(lhs.first), r = m_projection(rhs.first);
+		return r < l || (!(l < r) && lhs.second < rhs.second);
+	}
+
+	void insert(partial_result& pr, const entry& e) const {
+		auto weaker = [this](const entry& lhs, const entry& rhs) { return stronger(lhs, rhs); };
+		if (pr.size() < m_k) {
+			pr.push_back(e);
+			std::push_heap(pr.begin(), pr.end(), weaker);
+		} else if (m_k > 0 && stronger(e, pr.front())) {
+			std::pop_heap(pr.begin(), pr.end(), weaker);
+			pr.back() = e;
+			std::push_heap(pr.begin(), pr.end(), weaker);
+		}
+	}
+
+	std::size_t m_k;
+	Projection m_projection;
+};
+
+}
+}
+
+#endif
@@ -1,7 +1,10 @@
 #ifndef TRANSDUCERS_BASE_SINK_TRANSDUCER_H_
 #define TRANSDUCERS_BASE_SINK_TRANSDUCER_H_
 
+#include <cstddef>
+
 #include <transducers/base/empty_state.h>
+#include <util/memory_usage.h>
 
 namespace transducers {
 namespace base {
@@ -17,6 +20,7 @@ public:
 	partial_result initial_result() const { return partial_result {}; }
 	partial_result identity_result() const  { return partial_result {}; }
 	const terminal_result& last_stage_result(const partial_result& p) const { return p; }
+	std::size_t memory_usage(const partial_result& p) const { return ::util::memory_usage(p); }
 };
 
 }
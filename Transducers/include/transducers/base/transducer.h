@@ -1,7 +1,12 @@
 #ifndef TRANSDUCER_BASE_TRANSDUCER_H_
 #define TRANSDUCER_BASE_TRANSDUCER_H_
 
+#include <cstddef>
+#include <utility>
+
 #include <transducers/base/empty_state.h>
+#include <transducers/process_block.h>
+#include <util/memory_usage.h>
 
 namespace transducers {
 namespace base {
@@ -19,6 +24,12 @@ public:
 	void output(partial_result& p, const output_symbol& s, std::size_t offset) const {
 		m_next->process_symbol(p.second, s, offset);
 	}
+	// Outputs the symbols of [begin, end), the first at offset, through
+	// the block interface of the next stage where it has one
+	template <typename Iterator>
+	void output_block(partial_result& p, Iterator begin, Iterator end, std::size_t offset) const {
+		::transducers::process_block(*m_next, p.second, begin, end, offset);
+	}
 	PartialType& unwrap(partial_result& p) const { return p.first; }
 	const PartialType& unwrap(const partial_result& p) const { return p.first; }
 
@@ -28,7 +39,7 @@ public:
 	void merge_results(partial_result& lhs, const partial_result& rhs) const {
 		m_next->merge_results(lhs.second, rhs.second);
 	}
-	void merge_next(partial_result& lhs, const partial_result& rhs) {
+	void merge_next(partial_result& lhs, const partial_result& rhs) const {
 		m_next->merge_results(lhs.second, rhs.second);
 	}
 
@@ -43,6 +54,12 @@ public:
 	const terminal_result& last_stage_result(const partial_result& p) const {
 		return m_next->last_stage_result(p.second);
 	}
+
+	// Bytes used by this partial result including all later stages
+	std::size_t memory_usage(const partial_result& p) const {
+		return sizeof(partial_result) - sizeof(typename Next::partial_result) +
+			::util::heap_usage(p.first) + m_next->memory_usage(p.second);
+	}
 	transducer(const Next& n):
 		m_next(&n) {}
 
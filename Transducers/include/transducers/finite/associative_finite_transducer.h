@@ -0,0 +1,221 @@
+#ifndef TRANSDUCERS_FINITE_ASSOCIATIVE_FINITE_TRANSDUCER_H_
+#define TRANSDUCERS_FINITE_ASSOCIATIVE_FINITE_TRANSDUCER_H_
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <representation/compiled_automaton.h>
+#include <transducers/base/transducer.h>
+
+namespace transducers {
+namespace finite {
+
+/** Partial state of associative_finite_transducer.
+ *
+ * A block whose starting state is known runs like finite_transducer. A
+ * block started from identity_result() runs one lane per distinct state
+ * reached so far, and each lane feeds its own partial result of the next
+ * stage. When lanes reach the same state they are frozen and continue as
+ * a single new lane, so every starting state maps to a list of frozen
+ * lanes followed by a live one.
+ */
+template <typename NextPartial>
+struct finite_lanes {
+	struct lane {
+		int state;
+		NextPartial next;
+	};
+	typedef std::shared_ptr<const lane> frozen_lane;
+
+	bool known = false;
+	int current = -1;
+	std::vector<lane> live;
+	// Indexed by starting state, -1 and empty for states not in the automaton
+	std::vector<int> live_of;
+	std::vector<std::vector<frozen_lane>> history;
+};
+
+/** class associative_finite_transducer
+ *
+ * An associative version of finite_transducer for lexers with no safe
+ * place to split their input, such as JSON where a block may start in
+ * the middle of a string. Most lexers have only a few states which stay
+ * distinct for long, for JSON inside and outside a string, so after the
+ * first few symbols of a block the cost is that many runs of the later
+ * stages.
+ */
+template <typename Next>
+class associative_finite_transducer :
+	public base::transducer<Next, unsigned short, int, finite_lanes<typename Next::partial_result>>
+{
+public:
+	using block = finite_lanes<typename Next::partial_result>;
+	using base_transducer = base::transducer<Next, unsigned short, int, block>;
+	using partial_result = typename base_transducer::partial_result;
+	using input_symbol = typename base_transducer::input_symbol;
+	using output_symbol = typename base_transducer::output_symbol;
+
+	associative_finite_transducer(const Next& n, const representation::dft_description& dft):
+		base_transducer(n),
+		m_automaton(dft),
+		m_next(&n) {}
+
+	associative_finite_transducer(const Next& n, representation::compiled_automaton automaton):
+		base_transducer(n),
+		m_automaton(std::move(automaton)),
+		m_next(&n) {}
+
+	void process_symbol(partial_result& pr, const input_symbol& s, std::size_t offset) const {
+		auto& b = base_transducer::unwrap(pr);
+		if (b.known) {
+			const auto& details = m_automaton.lookup(b.current, s);
+			assert(details.next != -1);
+			b.current = details.next;
+			if (details.output != -1) {
+				base_transducer::output(pr, details.output, offset);
+			}
+			return;
+		}
+		bool converged = false;
+		for (auto& l: b.live) {
+			const auto& details = m_automaton.lookup(l.state, s);
+			assert(details.next != -1);
+			if (l.state != details.next) {
+				converged = converged || b.live.size() > 1;
+				l.state = details.next;
+			}
+			if (details.output != -1) {
+				m_next->process_symbol(l.next, details.output, offset);
+			}
+		}
+		if (converged) converge(b);
+	}
+
+	void merge_results(partial_result& r_lhs, const partial_result& r_rhs) const {
+		auto& lhs = base_transducer::unwrap(r_lhs);
+		const auto& rhs = base_transducer::unwrap(r_rhs);
+		assert(!rhs.known);
+		if (lhs.known) {
+			for (const auto& l: rhs.history[lhs.current]) {
+				m_next->merge_results(r_lhs.second, l->next);
+			}
+			assert(rhs.live_of[lhs.current] != -1);
+			const auto& l = rhs.live[rhs.live_of[lhs.current]];
+			m_next->merge_results(r_lhs.second, l.next);
+			lhs.current = l.state;
+			return;
+		}
+
+		// Freeze the left hand lanes and follow each one into the right
+		// hand block, which keeps its live lanes
+		std::vector<typename block::frozen_lane> frozen;
+		for (auto& l: lhs.live) {
+			frozen.push_back(std::make_shared<const typename block::lane>(std::move(l)));
+		}
+		block ret;
+		ret.live_of.assign(lhs.live_of.size(), -1);
+		ret.history.resize(lhs.live_of.size());
+		std::vector<int> new_index(rhs.live.size(), -1);
+		for (std::size_t s = 0; s < lhs.live_of.size(); ++s) {
+			if (lhs.live_of[s] == -1) continue;
+			const auto& l = frozen[lhs.live_of[s]];
+			auto& h = ret.history[s];
+			h = std::move(lhs.history[s]);
+			h.push_back(l);
+			h.insert(h.end(), rhs.history[l->state].begin(), rhs.history[l->state].end());
+			int r = rhs.live_of[l->state];
+			assert(r != -1);
+			if (new_index[r] == -1) {
+				new_index[r] = ret.live.size();
+				ret.live.push_back(rhs.live[r]);
+			}
+			ret.live_of[s] = new_index[r];
+		}
+		lhs = std::move(ret);
+	}
+
+	partial_result initial_result() const {
+		block b;
+		b.known = true;
+		b.current = m_automaton.start_state();
+		return base_transducer::initial_result(std::move(b));
+	}
+
+	partial_result identity_result() const {
+		block b;
+		b.live_of.assign(m_automaton.num_states(), -1);
+		b.history.resize(m_automaton.num_states());
+		for (int s: m_automaton.states()) {
+			b.live_of[s] = b.live.size();
+			b.live.push_back(typename block::lane{ s, m_next->identity_result() });
+		}
+		return base_transducer::identity_result(std::move(b));
+	}
+
+	std::size_t memory_usage(const partial_result& pr) const {
+		const auto& b = base_transducer::unwrap(pr);
+		std::size_t ret = base_transducer::memory_usage(pr) +
+			b.live.capacity() * sizeof(typename block::lane) +
+			b.live_of.capacity() * sizeof(int) +
+			b.history.capacity() * sizeof(std::vector<typename block::frozen_lane>);
+		for (const auto& l: b.live) {
+			ret += m_next->memory_usage(l.next) - sizeof(l.next);
+		}
+		// Frozen lanes are shared, so only their handles are counted
+		for (const auto& h: b.history) {
+			ret += h.capacity() * sizeof(typename block::frozen_lane);
+		}
+		return ret;
+	}
+
+	const representation::compiled_automaton& automaton() const { return m_automaton; }
+private:
+	// Replaces every group of live lanes in the same state by one new lane
+	void converge(block& b) const {
+		std::vector<int> group_of(m_automaton.num_states(), -1);
+		std::vector<int> group(b.live.size());
+		std::vector<int> group_size;
+		for (std::size_t i = 0; i < b.live.size(); ++i) {
+			int& g = group_of[b.live[i].state];
+			if (g == -1) {
+				g = group_size.size();
+				group_size.push_back(0);
+			}
+			group[i] = g;
+			++group_size[g];
+		}
+		if (group_size.size() == b.live.size()) return;
+
+		std::vector<typename block::frozen_lane> frozen(b.live.size());
+		std::vector<typename block::lane> live(group_size.size());
+		for (std::size_t i = 0; i < b.live.size(); ++i) {
+			int g = group[i];
+			if (group_size[g] == 1) {
+				live[g] = std::move(b.live[i]);
+			} else {
+				live[g].state = b.live[i].state;
+				frozen[i] = std::make_shared<const typename block::lane>(std::move(b.live[i]));
+			}
+		}
+		for (std::size_t g = 0; g < live.size(); ++g) {
+			if (group_size[g] > 1) live[g].next = m_next->identity_result();
+		}
+		for (std::size_t s = 0; s < b.live_of.size(); ++s) {
+			int i = b.live_of[s];
+			if (i == -1) continue;
+			if (frozen[i]) b.history[s].push_back(frozen[i]);
+			b.live_of[s] = group[i];
+		}
+		b.live = std::move(live);
+	}
+
+	representation::compiled_automaton m_automaton;
+	const Next* m_next;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,203 @@
+#ifndef TRANSDUCERS_FINITE_BIT_PARALLEL_TRANSDUCER_H_
+#define TRANSDUCERS_FINITE_BIT_PARALLEL_TRANSDUCER_H_
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <representation/bit_parallel_nfa.h>
+#include <transducers/base/transducer.h>
+
+namespace transducers {
+namespace finite {
+
+/** Simulates an nfa_description with one bit per NFA state, see
+ * representation::bit_parallel_nfa. The outputs are the same as those
+ * of lazy_dfa_transducer but no DFA states are ever built. Like the
+ * other finite transducers this one is not associative.
+ */
+template <std::size_t Words, typename Next>
+class bit_parallel_transducer :
+	public base::transducer<Next, unsigned short, int, representation::state_mask<Words>>
+{
+public:
+	using base_transducer = base::transducer<Next, unsigned short, int,
+		representation::state_mask<Words>>;
+	using partial_result = typename base_transducer::partial_result;
+	using input_symbol = typename base_transducer::input_symbol;
+	using output_symbol = typename base_transducer::output_symbol;
+	using nfa_type = representation::bit_parallel_nfa<Words>;
+
+	void process_symbol(partial_result& pr, const input_symbol& s, std::size_t offset) const {
+		auto& d = base_transducer::unwrap(pr);
+		d = m_nfa->step(d, s);
+		m_nfa->for_each_output(d, [&](int o) {
+			base_transducer::output(pr, o, offset);
+		});
+	}
+
+	bit_parallel_transducer(const Next& n, const representation::nfa_description& nfa):
+		base_transducer(n),
+		m_nfa(std::make_shared<nfa_type>(nfa)) {}
+
+	partial_result initial_result() const {
+		return base_transducer::initial_result(m_nfa->start());
+	}
+
+	partial_result identity_result() const {
+		return base_transducer::identity_result(m_nfa->start());
+	}
+private:
+	std::shared_ptr<const nfa_type> m_nfa;
+};
+
+template <typename Next>
+using bit_parallel_transducer_64 = bit_parallel_transducer<1, Next>;
+template <typename Next>
+using bit_parallel_transducer_256 = bit_parallel_transducer<4, Next>;
+template <typename Next>
+using bit_parallel_transducer_512 = bit_parallel_transducer<8, Next>;
+
+/** Partial state of associative_bit_parallel_transducer. Blocks whose
+ * starting states are known track them in current, the others track in
+ * rows[i] the states reached from state i and hold back their outputs.
+ */
+template <std::size_t Words>
+struct bit_parallel_block {
+	using mask = representation::state_mask<Words>;
+	struct pending_output {
+		std::size_t offset;
+		int output;
+		mask starts;
+	};
+	bool known = false;
+	mask current;
+	std::vector<mask> rows;
+	std::vector<pending_output> pending;
+};
+
+/** Associative version of bit_parallel_transducer.
+ *
+ * The step function distributes over unions of states, so the rows of
+ * a block describe it completely and two blocks compose by ORing rows.
+ * An output is held back with the set of starting states that produce
+ * it and is released once the block is merged onto one whose states are
+ * known. Each symbol costs one step per live row, so this is intended
+ * for automata with at most a few hundred states.
+ */
+template <std::size_t Words, typename Next>
+class associative_bit_parallel_transducer :
+	public base::transducer<Next, unsigned short, int, bit_parallel_block<Words>>
+{
+public:
+	using base_transducer = base::transducer<Next, unsigned short, int, bit_parallel_block<Words>>;
+	using partial_result = typename base_transducer::partial_result;
+	using input_symbol = typename base_transducer::input_symbol;
+	using output_symbol = typename base_transducer::output_symbol;
+	using nfa_type = representation::bit_parallel_nfa<Words>;
+	using mask = representation::state_mask<Words>;
+	using block = bit_parallel_block<Words>;
+
+	associative_bit_parallel_transducer(const Next& n, const representation::nfa_description& nfa):
+		base_transducer(n),
+		m_nfa(std::make_shared<nfa_type>(nfa)) {}
+
+	void process_symbol(partial_result& pr, const input_symbol& s, std::size_t offset) const {
+		auto& b = base_transducer::unwrap(pr);
+		if (b.known) {
+			b.current = m_nfa->step(b.current, s);
+			m_nfa->for_each_output(b.current, [&](int o) {
+				base_transducer::output(pr, o, offset);
+			});
+			return;
+		}
+		mask reached;
+		for (auto& row: b.rows) {
+			if (row.any()) {
+				row = m_nfa->step(row, s);
+				reached |= row;
+			}
+		}
+		if (!reached.intersects(m_nfa->accept())) return;
+		for (const auto& p: m_nfa->output_masks()) {
+			if (!reached.intersects(p.second)) continue;
+			mask starts;
+			for (std::size_t i = 0; i < b.rows.size(); ++i) {
+				if (b.rows[i].intersects(p.second)) starts.set(i);
+			}
+			b.pending.push_back(typename block::pending_output{ offset, p.first, starts });
+		}
+	}
+
+	void merge_results(partial_result& r_lhs, const partial_result& r_rhs) const {
+		auto& lhs = base_transducer::unwrap(r_lhs);
+		const auto& rhs = base_transducer::unwrap(r_rhs);
+		assert(!rhs.known);
+		if (lhs.known) {
+			for (const auto& p: rhs.pending) {
+				if (lhs.current.intersects(p.starts)) {
+					base_transducer::output(r_lhs, p.output, p.offset);
+				}
+			}
+			lhs.current = apply(rhs.rows, lhs.current);
+		} else {
+			for (const auto& p: rhs.pending) {
+				mask starts;
+				for (std::size_t i = 0; i < lhs.rows.size(); ++i) {
+					if (lhs.rows[i].intersects(p.starts)) starts.set(i);
+				}
+				if (starts.any()) {
+					lhs.pending.push_back(typename block::pending_output{ p.offset, p.output, starts });
+				}
+			}
+			for (auto& row: lhs.rows) {
+				row = apply(rhs.rows, row);
+			}
+		}
+		base_transducer::merge_results(r_lhs, r_rhs);
+	}
+
+	partial_result initial_result() const {
+		block b;
+		b.known = true;
+		b.current = m_nfa->start();
+		return base_transducer::initial_result(std::move(b));
+	}
+
+	partial_result identity_result() const {
+		block b;
+		b.rows.resize(m_nfa->num_states());
+		for (std::size_t i = 0; i < b.rows.size(); ++i) {
+			b.rows[i].set(i);
+		}
+		return base_transducer::identity_result(std::move(b));
+	}
+
+	std::size_t memory_usage(const partial_result& pr) const {
+		const auto& b = base_transducer::unwrap(pr);
+		return base_transducer::memory_usage(pr) + b.rows.capacity() * sizeof(mask) +
+			b.pending.capacity() * sizeof(typename block::pending_output);
+	}
+private:
+	static mask apply(const std::vector<mask>& rows, const mask& states) {
+		mask ret;
+		states.for_each([&](std::size_t i) {
+			ret |= rows[i];
+		});
+		return ret;
+	}
+	std::shared_ptr<const nfa_type> m_nfa;
+};
+
+template <typename Next>
+using associative_bit_parallel_transducer_64 = associative_bit_parallel_transducer<1, Next>;
+template <typename Next>
+using associative_bit_parallel_transducer_256 = associative_bit_parallel_transducer<4, Next>;
+template <typename Next>
+using associative_bit_parallel_transducer_512 = associative_bit_parallel_transducer<8, Next>;
+
+}
+}
+
+#endif
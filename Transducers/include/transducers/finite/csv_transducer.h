@@ -0,0 +1,135 @@
+#ifndef TRANSDUCERS_FINITE_CSV_TRANSDUCER_H_
+#define TRANSDUCERS_FINITE_CSV_TRANSDUCER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <symbols/boundary.h>
+#include <transducers/base/transducer.h>
+#include <util/simd.h>
+
+namespace transducers {
+namespace finite {
+
+/** Partial state of csv_transducer. A block whose starting quote parity
+ * is known tracks whether it is inside quotes and outputs directly. The
+ * others track the parity of the quotes they have seen and hold back in
+ * pending[p] the boundaries seen while that parity was p, which are the
+ * real boundaries if the block turns out to start with parity p.
+ */
+struct csv_block {
+	bool known = false;
+	bool parity = false;
+	std::vector<symbols::boundary> pending[2];
+};
+
+/** class csv_transducer
+ *
+ * An associative splitter for CSV and similar formats. A delimiter ends
+ * a field and a newline ends a record unless an odd number of quotes
+ * precede it, which also covers quotes escaped by doubling. Each
+ * boundary is output as a symbols::boundary at its offset.
+ *
+ * process_block() classifies 64 bytes at a time and finds the quoted
+ * regions with a prefix XOR over the quote mask, so the only state
+ * carried between windows and between blocks is one parity bit.
+ */
+template <typename Next>
+class csv_transducer :
+	public base::transducer<Next, unsigned char, symbols::boundary, csv_block>
+{
+public:
+	using base_transducer = base::transducer<Next, unsigned char, symbols::boundary, csv_block>;
+	using partial_result = typename base_transducer::partial_result;
+	using input_symbol = typename base_transducer::input_symbol;
+	using output_symbol = typename base_transducer::output_symbol;
+
+	csv_transducer(const Next& n, unsigned char delimiter = ',', unsigned char quote = '"'):
+		base_transducer(n),
+		m_delimiter(delimiter),
+		m_quote(quote) {}
+
+	void process_symbol(partial_result& pr, const input_symbol& s, std::size_t offset) const {
+		auto& b = base_transducer::unwrap(pr);
+		if (s == m_quote) {
+			b.parity = !b.parity;
+		} else if (s == m_delimiter || s == '\n') {
+			boundary(pr, symbols::boundary(offset, s == '\n'), b.parity);
+		}
+	}
+
+	void process_block(partial_result& pr, const unsigned char* begin,
+			const unsigned char* end, std::size_t offset) const {
+		auto& b = base_transducer::unwrap(pr);
+		for (; end - begin >= static_cast<std::ptrdiff_t>(::util::simd_window);
+				begin += ::util::simd_window, offset += ::util::simd_window) {
+			uint64_t quotes = ::util::byte_mask(begin, m_quote);
+			uint64_t records = ::util::byte_mask(begin, '\n');
+			uint64_t fields = ::util::byte_mask(begin, m_delimiter) & ~records;
+			uint64_t inside = ::util::prefix_xor(quotes) ^ (b.parity ? ~uint64_t(0) : 0);
+			b.parity = inside >> 63;
+			uint64_t candidates = fields | records;
+			if (b.known) candidates &= ~inside;
+			::util::for_each_bit(candidates, [&](std::size_t i) {
+				boundary(pr, symbols::boundary(offset + i, (records >> i) & 1), (inside >> i) & 1);
+			});
+		}
+		for (; begin != end; ++begin, ++offset) {
+			process_symbol(pr, *begin, offset);
+		}
+	}
+
+	void merge_results(partial_result& r_lhs, const partial_result& r_rhs) const {
+		auto& lhs = base_transducer::unwrap(r_lhs);
+		const auto& rhs = base_transducer::unwrap(r_rhs);
+		if (lhs.known) {
+			for (const auto& s: rhs.pending[lhs.parity]) {
+				base_transducer::output(r_lhs, s, s.offset);
+			}
+		} else {
+			for (int p = 0; p < 2; ++p) {
+				const auto& from = rhs.pending[p ^ lhs.parity];
+				lhs.pending[p].insert(lhs.pending[p].end(), from.begin(), from.end());
+			}
+		}
+		lhs.parity = lhs.parity != rhs.parity;
+		base_transducer::merge_next(r_lhs, r_rhs);
+	}
+
+	partial_result initial_result() const {
+		csv_block b;
+		b.known = true;
+		return base_transducer::initial_result(std::move(b));
+	}
+
+	partial_result identity_result() const {
+		return base_transducer::identity_result(csv_block());
+	}
+
+	std::size_t memory_usage(const partial_result& pr) const {
+		const auto& b = base_transducer::unwrap(pr);
+		return base_transducer::memory_usage(pr) +
+			(b.pending[0].capacity() + b.pending[1].capacity()) * sizeof(symbols::boundary);
+	}
+
+private:
+	// Outputs s if it is outside quotes, or holds it back with the parity
+	// it was seen at
+	void boundary(partial_result& pr, const symbols::boundary& s, bool parity) const {
+		auto& b = base_transducer::unwrap(pr);
+		if (b.known) {
+			if (!parity) base_transducer::output(pr, s, s.offset);
+		} else {
+			b.pending[parity].push_back(s);
+		}
+	}
+
+	unsigned char m_delimiter;
+	unsigned char m_quote;
+};
+
+}
+}
+
+#endif
@@ -1,10 +1,13 @@
 #ifndef TRANSDUCERS_FINITE_FINITE_TRANSDUCER_H_
 #define TRANSDUCERS_FINITE_FINITE_TRANSDUCER_H_
 
-#include <unordered_map>
+#include <cassert>
+#include <cstddef>
+#include <vector>
 
 #include <transducers/base/transducer.h>
-#include <representation/transition_description.h>
+#include <representation/compiled_automaton.h>
+#include <util/simd.h>
 
 namespace transducers {
 namespace finite {
@@ -25,42 +28,162 @@ public:
 	using output_symbol = typename base_transducer::output_symbol;
 
 	void process_symbol(partial_result& pr, const input_symbol& s, std::size_t offset) const {
-		auto find_iter = m_transitions.find(to_int(base_transducer::unwrap(pr), s));
-		assert(find_iter != m_transitions.end());
-		const auto& details = find_iter->second;
-		base_transducer::unwrap(pr) = details.state;
+		const auto& details = m_automaton.lookup(base_transducer::unwrap(pr), s);
+		assert(details.next != -1);
+		base_transducer::unwrap(pr) = details.next;
 		if (details.output != -1) {
 			base_transducer::output(pr, details.output, offset);
 		}
 	}
 
-	finite_transducer(const Next& n, const representation::dft_description& dft):
-		base_transducer(n)
-	{
-		for (const auto& p: dft.transitions) {
-			m_transitions[to_int(p.first.first, p.first.second)].state = p.second;
+	// Scans the block in one go, or with more than one stream set runs it
+	// through process_interleaved()
+	void process_block(partial_result& pr, const unsigned char* begin,
+			const unsigned char* end, std::size_t offset) const {
+		if (m_streams > 1) {
+			process_interleaved(pr, begin, end, offset, m_streams);
+		} else {
+			scan(pr, begin, end, offset);
+		}
+	}
+
+	// Splits [begin, end) into streams chunks and steps them through the
+	// automaton together, so the table lookups of one chunk overlap those
+	// of the others. Every chunk after the first starts in the state the
+	// automaton reaches from the start state over the interleave_lookback
+	// bytes before it, and is run again from the right state if that
+	// guess turns out wrong, so the result is the same as scanning the
+	// block in one go. Blocks too short to give every chunk at least
+	// interleave_lookback bytes are scanned in one go.
+	void process_interleaved(partial_result& pr, const unsigned char* begin,
+			const unsigned char* end, std::size_t offset, std::size_t streams = 4) const {
+		std::size_t length = streams == 0 ? 0 : (end - begin) / streams;
+		if (streams < 2 || length < interleave_lookback) {
+			scan(pr, begin, end, offset);
+			return;
 		}
-		for (const auto& p: dft.output) {
-			m_transitions[to_int(p.first.first, p.first.second)].output = p.second;
+		std::vector<partial_result> chunks;
+		std::vector<int> guesses;
+		std::vector<char> failed(streams, false);
+		chunks.reserve(streams);
+		for (std::size_t k = 1; k < streams; ++k) {
+			const unsigned char* from = begin + k * length;
+			guesses.push_back(guess(from - interleave_lookback, from));
+			chunks.push_back(base_transducer::identity_result(guesses.back()));
 		}
-		m_start_state = dft.start_state;
+		for (std::size_t i = 0; i < length; ++i) {
+			process_symbol(pr, begin[i], offset + i);
+			for (std::size_t k = 1; k < streams; ++k) {
+				if (!failed[k]) {
+					std::size_t at = k * length + i;
+					failed[k] = !speculate(chunks[k - 1], begin[at], offset + at);
+				}
+			}
+		}
+
+		for (std::size_t k = 1; k < streams; ++k) {
+			const unsigned char* from = begin + k * length;
+			const unsigned char* to = k + 1 == streams ? end : from + length;
+			auto& chunk = chunks[k - 1];
+			if (failed[k] || guesses[k - 1] != base_transducer::unwrap(pr)) {
+				chunk = base_transducer::identity_result(base_transducer::unwrap(pr));
+				scan(chunk, from, to, offset + k * length);
+			} else if (k + 1 == streams) {
+				scan(chunk, from + length, to, offset + k * length + length);
+			}
+			merge_results(pr, chunk);
+		}
+	}
+
+	// The number of chunks process_block() steps through together, 1 to
+	// scan blocks in one go
+	void set_streams(std::size_t streams) { m_streams = streams; }
+	std::size_t streams() const { return m_streams; }
+
+	// The right hand block was started in a known state by the splitter or
+	// buffer in front of this transducer, so its final state is the final
+	// state of the combined block.
+	void merge_results(partial_result& lhs, const partial_result& rhs) const {
+		base_transducer::unwrap(lhs) = base_transducer::unwrap(rhs);
+		base_transducer::merge_results(lhs, rhs);
 	}
 
+	finite_transducer(const Next& n, const representation::dft_description& dft):
+		base_transducer(n),
+		m_automaton(dft) {}
+
+	finite_transducer(const Next& n, representation::compiled_automaton automaton):
+		base_transducer(n),
+		m_automaton(std::move(automaton)) {}
+
 	partial_result initial_result() const {
-		return base_transducer::initial_result(m_start_state);
+		return base_transducer::initial_result(m_automaton.start_state());
 	}
 
 	partial_result identity_result() const {
-		return base_transducer::identity_result(m_start_state);
+		return base_transducer::identity_result(m_automaton.start_state());
+	}
+
+	// For a block known to start in state, such as one chosen by smart_splitter
+	partial_result identity_result(int state) const {
+		return base_transducer::identity_result(state);
 	}
+
+	const representation::compiled_automaton& automaton() const { return m_automaton; }
+
+	static const std::size_t interleave_lookback = 64;
+
 private:
-	struct transition_details {
-		int state;
-		int output = -1;
-	};
-	static int to_int(int s, int c) { return c | (s << 16); }
-	std::unordered_map<int, transition_details> m_transitions;
-	int m_start_state;
+	// Runs of bytes on which the current state loops silently are found
+	// with util::find_any and skipped without a lookup per byte
+	void scan(partial_result& pr, const unsigned char* begin,
+			const unsigned char* end, std::size_t offset) const {
+		while (begin != end) {
+			const auto& exits = m_automaton.exits(base_transducer::unwrap(pr));
+			if (exits.count != -1 && !is_exit(exits, *begin)) {
+				const unsigned char* next = ::util::find_any(begin + 1, end, exits.bytes, exits.count);
+				offset += next - begin;
+				begin = next;
+				if (begin == end) break;
+			}
+			process_symbol(pr, *begin, offset);
+			++begin;
+			++offset;
+		}
+	}
+
+	// The state the automaton reaches over [begin, end), restarting at
+	// missing transitions
+	int guess(const unsigned char* begin, const unsigned char* end) const {
+		int state = m_automaton.start_state();
+		for (; begin != end; ++begin) {
+			int next = m_automaton.lookup(state, *begin).next;
+			state = next == -1 ? m_automaton.start_state() : next;
+		}
+		return state;
+	}
+
+	// process_symbol() for a chunk started from a guess, which may lead
+	// to a missing transition
+	bool speculate(partial_result& pr, unsigned char s, std::size_t offset) const {
+		const auto& details = m_automaton.lookup(base_transducer::unwrap(pr), s);
+		if (details.next == -1) return false;
+		base_transducer::unwrap(pr) = details.next;
+		if (details.output != -1) {
+			base_transducer::output(pr, details.output, offset);
+		}
+		return true;
+	}
+
+	static bool is_exit(const representation::compiled_automaton::exit_set& exits, unsigned char c) {
+		for (int i = 0; i < exits.count; ++i) {
+			if (exits.bytes[i] == c) return true;
+		}
+		return false;
+	}
+
+	representation::compiled_automaton m_automaton;
+	std::size_t m_streams = 1;
 };
 
 }
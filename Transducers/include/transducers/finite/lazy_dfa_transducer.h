@@ -0,0 +1,58 @@
+#ifndef TRANSDUCERS_FINITE_LAZY_DFA_TRANSDUCER_H_
+#define TRANSDUCERS_FINITE_LAZY_DFA_TRANSDUCER_H_
+
+#include <memory>
+
+#include <data_structures/lazy_dfa_cache.h>
+#include <representation/transition_description.h>
+#include <transducers/base/transducer.h>
+
+namespace transducers {
+namespace finite {
+
+/** Runs an nfa_description as a DFA which is determinised lazily as the
+ * input is processed. Like finite_transducer this is not associative.
+ * Copies of the transducer share the state cache so it can be handed
+ * to several worker threads, see data_structures::lazy_dfa_cache.
+ */
+
+template <typename Next>
+class lazy_dfa_transducer :
+	public base::transducer<Next, unsigned short, int, data_structures::lazy_dfa_cache::position>
+{
+public:
+	using base_transducer = base::transducer<Next, unsigned short, int,
+		data_structures::lazy_dfa_cache::position>;
+	using partial_result = typename base_transducer::partial_result;
+	using input_symbol = typename base_transducer::input_symbol;
+	using output_symbol = typename base_transducer::output_symbol;
+
+	void process_symbol(partial_result& pr, const input_symbol& s, std::size_t offset) const {
+		const auto* state = m_cache->step(base_transducer::unwrap(pr), s);
+		for (int o: state->outputs) {
+			base_transducer::output(pr, o, offset);
+		}
+	}
+
+	lazy_dfa_transducer(const Next& n, const representation::nfa_description& nfa,
+			std::size_t max_states = 4096):
+		base_transducer(n),
+		m_cache(std::make_shared<data_structures::lazy_dfa_cache>(nfa, max_states)) {}
+
+	partial_result initial_result() const {
+		return base_transducer::initial_result(m_cache->start());
+	}
+
+	partial_result identity_result() const {
+		return base_transducer::identity_result(m_cache->start());
+	}
+
+	const data_structures::lazy_dfa_cache& cache() const { return *m_cache; }
+private:
+	std::shared_ptr<data_structures::lazy_dfa_cache> m_cache;
+};
+
+}
+}
+
+#endif
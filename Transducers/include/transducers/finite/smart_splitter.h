@@ -0,0 +1,191 @@
+#ifndef TRANSDUCERS_FINITE_SMART_SPLITTER_H_
+#define TRANSDUCERS_FINITE_SMART_SPLITTER_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <representation/compiled_automaton.h>
+#include <transducers/finite/finite_transducer.h>
+#include <transducers/parallel.h>
+
+namespace transducers {
+namespace finite {
+
+/** class smart_splitter
+ *
+ * Chooses block boundaries for a finite_transducer at which the state of
+ * the automaton is known whatever came before: just after a synchronising
+ * word of up to max_word_length symbols, which takes every state that
+ * can read it to one single state, such as a line break for a line based
+ * format. On construction the images of the set of all states under
+ * every such sequence of symbol classes are found, which tells whether
+ * the automaton has synchronising words and which classes end them. At
+ * a candidate position whose last byte is in such a class, the set of
+ * all states is run over the bytes before it. split() places each
+ * boundary just after the first synchronising word at or past its
+ * nominal position, so every block can be started in one state instead
+ * of being buffered or run speculatively from each state.
+ *
+ * Automata in which some state loops on every symbol, like the quoted
+ * values and comments of xml_tokenizer, have no synchronising word. For
+ * those synchronising() is false and split() returns a single block.
+ */
+class smart_splitter {
+public:
+	static const std::size_t max_word_length = 3;
+
+	// The symbols [begin, end) of the input, to be started in state
+	struct chunk {
+		std::size_t begin;
+		std::size_t end;
+		int state;
+	};
+
+	explicit smart_splitter(const representation::compiled_automaton& automaton):
+		m_automaton(automaton),
+		m_states(automaton.states().begin(), automaton.states().end()),
+		m_ends_word(automaton.num_classes(), false) {
+		std::sort(m_states.begin(), m_states.end());
+		m_states.erase(std::unique(m_states.begin(), m_states.end()), m_states.end());
+		find_words(automaton.over_classes());
+	}
+
+	bool synchronising() const { return !m_words.empty(); }
+	// The shortest synchronising words, one for each set of states the
+	// symbols before their last one lead to
+	std::size_t num_words() const { return m_words.size(); }
+
+	// The state after [begin, end) if it ends with a synchronising word, or -1
+	int synchronised_state(const unsigned char* begin, const unsigned char* end) const {
+		if (begin == end || !m_ends_word[m_automaton.symbol_class(end[-1])]) return -1;
+		std::size_t length = static_cast<std::size_t>(end - begin);
+		if (length > max_word_length) length = max_word_length;
+		std::vector<int> image;
+		for (std::size_t k = 1; k <= length; ++k) {
+			image = m_states;
+			for (const unsigned char* at = end - k; at != end && !image.empty(); ++at) {
+				step(image, *at);
+			}
+			if (image.size() == 1) return image.front();
+		}
+		return -1;
+	}
+
+	// Splits [begin, end) into at most blocks chunks of about equal size.
+	// The first chunk starts in the start state, and a nominal boundary for
+	// which no synchronising word is found before the next one is dropped.
+	std::vector<chunk> split(const unsigned char* begin, const unsigned char* end,
+			std::size_t blocks) const {
+		std::size_t size = end - begin;
+		if (blocks == 0) blocks = 1;
+		std::vector<chunk> ret{ chunk{ 0, size, m_automaton.start_state() } };
+		if (!synchronising()) return ret;
+		for (std::size_t b = 1; b < blocks; ++b) {
+			std::size_t limit = size * (b + 1) / blocks;
+			for (std::size_t at = std::max(size * b / blocks, ret.back().begin + 1); at < limit; ++at) {
+				int state = synchronised_state(begin, begin + at);
+				if (state != -1) {
+					ret.back().end = at;
+					ret.push_back(chunk{ at, size, state });
+					break;
+				}
+			}
+		}
+		return ret;
+	}
+
+private:
+	struct word {
+		std::vector<uint16_t> classes;
+		int state;
+	};
+
+	// The states the automaton reaches from image on symbol
+	void step(std::vector<int>& image, unsigned int symbol) const {
+		std::size_t kept = 0;
+		for (int s: image) {
+			int to = m_automaton.lookup(s, symbol).next;
+			if (to != -1) image[kept++] = to;
+		}
+		image.resize(kept);
+		std::sort(image.begin(), image.end());
+		image.erase(std::unique(image.begin(), image.end()), image.end());
+	}
+
+	// Breadth first over the images of the set of all states. Words with
+	// the same image behave the same from then on, so one word is extended
+	// for each image. Those first reaching a single state are kept, and the
+	// last class of every word ending in a single state, including longer
+	// ones extending a synchronising word, is marked as one synchronising
+	// words may end with.
+	void find_words(const representation::compiled_automaton& classes) {
+		std::vector<std::pair<std::vector<uint16_t>, std::vector<int>>> frontier{ { {}, m_states } };
+		for (std::size_t length = 1; length <= max_word_length && !frontier.empty(); ++length) {
+			std::map<std::vector<int>, std::vector<uint16_t>> next;
+			for (const auto& f: frontier) {
+				for (uint16_t c = 0; c < classes.num_classes(); ++c) {
+					std::vector<int> image;
+					for (int s: f.second) {
+						int to = classes.lookup(s, c).next;
+						if (to != -1) image.push_back(to);
+					}
+					std::sort(image.begin(), image.end());
+					image.erase(std::unique(image.begin(), image.end()), image.end());
+					if (image.empty()) continue;
+					std::vector<uint16_t> w = f.first;
+					w.push_back(c);
+					if (image.size() == 1) {
+						m_ends_word[c] = true;
+						if (f.first.empty() || f.second.size() > 1) add_word(w, image.front());
+					}
+					next.emplace(std::move(image), std::move(w));
+				}
+			}
+			frontier.clear();
+			for (auto& n: next) frontier.emplace_back(std::move(n.second), std::move(n.first));
+		}
+	}
+
+	// Words with a shorter synchronising suffix are never needed
+	void add_word(std::vector<uint16_t> classes, int state) {
+		for (const auto& w: m_words) {
+			if (w.classes.size() < classes.size() &&
+					std::equal(w.classes.rbegin(), w.classes.rend(), classes.rbegin())) {
+				return;
+			}
+		}
+		m_words.push_back(word{ std::move(classes), state });
+	}
+
+	representation::compiled_automaton m_automaton;
+	std::vector<int> m_states;
+	std::vector<bool> m_ends_word;
+	std::vector<word> m_words;
+};
+
+/** Runs trans over [begin, end) in the chunks chosen by splitter, one
+ * thread per chunk, each started in the state the splitter found for
+ * it, and merges the results like run_parallel.
+ */
+template <typename Next>
+typename finite_transducer<Next>::partial_result run_split(const finite_transducer<Next>& trans,
+		const smart_splitter& splitter, const unsigned char* begin, const unsigned char* end,
+		std::size_t blocks) {
+	std::vector<std::size_t> bounds;
+	std::vector<typename finite_transducer<Next>::partial_result> results;
+	for (const auto& c: splitter.split(begin, end, blocks)) {
+		bounds.push_back(c.begin);
+		results.push_back(bounds.size() == 1 ? trans.initial_result() : trans.identity_result(c.state));
+	}
+	bounds.push_back(end - begin);
+	return transducers::detail::run_chunks(trans, begin, bounds, 0, std::move(results));
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef TRANSDUCERS_PARALLEL_H_
+#define TRANSDUCERS_PARALLEL_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <transducers/process_block.h>
+
+namespace transducers {
+
+namespace detail {
+
+// Calls fn(i) for every i in [0, count), each on a thread of its own, and
+// once all have finished rethrows the first exception any of them threw
+template <typename Fn>
+void run_threads(std::size_t count, const Fn& fn) {
+	std::vector<std::exception_ptr> errors(count);
+	std::vector<std::thread> threads;
+	threads.reserve(count);
+	try {
+		for (std::size_t i = 0; i < count; ++i) {
+			threads.emplace_back([&, i]() {
+				try {
+					fn(i);
+				} catch (...) {
+					errors[i] = std::current_exception();
+				}
+			});
+		}
+	} catch (...) {
+		for (auto& t: threads) t.join();
+		throw;
+	}
+	for (auto& t: threads) t.join();
+	for (const auto& e: errors) {
+		if (e) std::rethrow_exception(e);
+	}
+}
+
+// Runs the chunks [begin + bounds[b], begin + bounds[b + 1]) in parallel,
+// chunk b into results[b]
+template <typename Transducer, typename Iterator>
+void process_chunks(const Transducer& trans, Iterator begin, const std::vector<std::size_t>& bounds,
+		std::size_t offset, std::vector<typename Transducer::partial_result>& results) {
+	run_threads(results.size(), [&](std::size_t b) {
+		Iterator from = begin, to = begin;
+		std::advance(from, bounds[b]);
+		std::advance(to, bounds[b + 1]);
+		transducers::process_block(trans, results[b], from, to, offset + bounds[b]);
+	});
+}
+
+// Merges results as a balanced tree, the merges of a level in parallel
+template <typename Transducer>
+typename Transducer::partial_result merge_chunks(const Transducer& trans,
+		std::vector<typename Transducer::partial_result> results) {
+	for (std::size_t stride = 1; stride < results.size(); stride *= 2) {
+		std::size_t pairs = (results.size() - stride + 2 * stride - 1) / (2 * stride);
+		run_threads(pairs, [&](std::size_t p) {
+			std::size_t b = 2 * stride * p;
+			trans.merge_results(results[b], results[b + stride]);
+		});
+	}
+	return std::move(results.front());
+}
+
+// Runs the chunks [begin + bounds[b], begin + bounds[b + 1]) in parallel,
+// chunk b from results[b], and merges them into results.front()
+template <typename Transducer, typename Iterator>
+typename Transducer::partial_result run_chunks(const Transducer& trans, Iterator begin,
+		const std::vector<std::size_t>& bounds, std::size_t offset,
+		std::vector<typename Transducer::partial_result> results) {
+	process_chunks(trans, begin, bounds, offset, results);
+	return merge_chunks(trans, std::move(results));
+}
+
+// Runs [begin, begin + size) as blocks starting at offset, the first block
+// from first and the others from identity_result(), and merges them
+template <typename Transducer, typename Iterator>
+typename Transducer::partial_result run_blocks(const Transducer& trans, Iterator begin,
+		std::size_t size, std::size_t offset, std::size_t blocks,
+		typename Transducer::partial_result first) {
+	if (blocks == 0) blocks = 1;
+	if (blocks > size) blocks = size > 0 ? size : 1;
+
+	std::vector<std::size_t> bounds;
+	std::vector<typename Transducer::partial_result> results;
+	results.reserve(blocks);
+	results.push_back(std::move(first));
+	for (std::size_t b = 0; b <= blocks; ++b) {
+		bounds.push_back(size * b / blocks);
+		if (b > 0 && b < blocks) results.push_back(trans.identity_result());
+	}
+	return run_chunks(trans, begin, bounds, offset, std::move(results));
+}
+
+}
+
+/** Runs a transducer over [begin, end) split into equal blocks, one
+ * thread per block, each fed through process_block(). The first block
+ * starts from initial_result() and the others from identity_result().
+ * The blocks are then merged as a balanced tree, with the merges of
+ * each level running in parallel, and the combined partial result is
+ * returned. An exception thrown on any of the threads is rethrown here
+ * once they have all finished.
+ */
+template <typename Transducer, typename Iterator>
+typename Transducer::partial_result run_parallel(const Transducer& trans,
+		Iterator begin, Iterator end, std::size_t blocks) {
+	return detail::run_blocks(trans, begin, std::distance(begin, end), 0, blocks, trans.initial_result());
+}
+
+/** Like run_parallel, but over consecutive windows of at most window
+ * symbols, each run in parallel blocks and merged into the result of
+ * the windows before it before the next one starts. Only one window of
+ * output is held back at a time, so a sink such as stream_sink, which
+ * hands on the output of the leftmost result as soon as it is merged,
+ * needs memory for one window rather than for the whole input.
+ */
+template <typename Transducer, typename Iterator>
+typename Transducer::partial_result run_windowed(const Transducer& trans,
+		Iterator begin, Iterator end, std::size_t blocks, std::size_t window) {
+	std::size_t size = std::distance(begin, end);
+	if (window == 0 || window > size) window = size;
+	auto ret = detail::run_blocks(trans, begin, window, 0, blocks, trans.initial_result());
+	for (std::size_t offset = window; offset < size; offset += window) {
+		std::advance(begin, window);
+		std::size_t length = std::min(window, size - offset);
+		trans.merge_results(ret, detail::run_blocks(trans, begin, length, offset, blocks,
+			trans.identity_result()));
+	}
+	return ret;
+}
+
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef TRANSDUCERS_PROCESS_BLOCK_H_
+#define TRANSDUCERS_PROCESS_BLOCK_H_
+
+#include <cstddef>
+#include <iterator>
+
+namespace transducers {
+
+namespace detail {
+
+template <typename Transducer, typename Iterator>
+auto process_block(const Transducer& trans, typename Transducer::partial_result& pr,
+		Iterator begin, Iterator end, std::size_t offset, int)
+	-> decltype(trans.process_block(pr, begin, end, offset), void()) {
+	trans.process_block(pr, begin, end, offset);
+}
+
+template <typename Transducer, typename Iterator>
+void process_block(const Transducer& trans, typename Transducer::partial_result& pr,
+		Iterator begin, Iterator end, std::size_t offset, long) {
+	for (; begin != end; ++begin, ++offset) {
+		trans.process_symbol(pr, *begin, offset);
+	}
+}
+
+}
+
+/** Feeds the symbols of [begin, end) to trans, the first at offset.
+ * Transducers which can scan many symbols at once provide a member
+ * process_block(pr, begin, end, offset) with the same meaning, and get
+ * the whole range in one call. The others get one process_symbol call
+ * per symbol.
+ */
+template <typename Transducer, typename Iterator>
+void process_block(const Transducer& trans, typename Transducer::partial_result& pr,
+		Iterator begin, Iterator end, std::size_t offset) {
+	detail::process_block(trans, pr, begin, end, offset, 0);
+}
+
+}
+
+#endif
@@ -1,10 +1,12 @@
 #ifndef TRANSDUCERS_STATE_MAP_PUSHDOWN_TRANSDUCER_H_
 #define TRANSDUCERS_STATE_MAP_PUSHDOWN_TRANSDUCER_H_
 
-#include <unordered_map>
+#include <cassert>
+#include <functional>
+#include <vector>
 
 #include <data_structures/pushdown_state_map.h>
-#include <representation/transition_description.h>
+#include <representation/compiled_automaton.h>
 
 namespace transducers {
 namespace pushdown {
@@ -12,28 +14,13 @@ namespace pushdown {
 template <typename Next, template <typename> class MapType>
 class state_map_pushdown_transducer {
 public:
-	explicit state_map_pushdown_transducer(const Next& next, const representation::dft_description& dft) {
-		for (const auto& p: dft.transitions) {
-			m_transitions[to_int(p.first.first, p.first.second)].next = p.second;
-			m_states.insert(p.first.first);
-			m_states.insert(p.second);
-		}
-		for (const auto& p: dft.push) {
-			m_transitions[to_int(p.first.first, p.first.second)].push = p.second;
-		}
-		for (const auto& p: dft.pop) {
-			int output = -1;
-			auto lookup = dft.output.find(p.first);
-			if (lookup != dft.output.end()) output = lookup->second;
-			m_transitions[to_int(p.first.first, p.first.second)].pop.emplace_back(
-					p.second.first, p.second.second, output);
-		}
-		for (const auto& p: dft.output) {
-			m_transitions[to_int(p.first.first, p.first.second)].output = p.second;
-		}
-		m_start_state = dft.start_state;
-		m_next = &next;
-	}
+	explicit state_map_pushdown_transducer(const Next& next, const representation::dft_description& dft):
+		m_automaton(dft),
+		m_next(&next) {}
+
+	explicit state_map_pushdown_transducer(const Next& next, representation::compiled_automaton automaton):
+		m_automaton(std::move(automaton)),
+		m_next(&next) {}
 
 	typedef unsigned int input_symbol;
 	typedef unsigned int output_symbol;
@@ -42,7 +29,7 @@ public:
 	typedef MapType<typename Next::partial_result> map_type;
 	class partial_result {
 	public:
-		const map_type& map() { return m_map; }
+		const map_type& map() const { return m_map; }
 	private:
 		map_type m_map;
 		friend class state_map_pushdown_transducer;
@@ -57,10 +44,10 @@ public:
 
 	const terminal_result& last_stage_result(const partial_result& pr) const {
 		assert (pr.m_map.size() == 1);
-		return pr.m_map.entry_begin()->value();
+		return m_next->last_stage_result(pr.m_map.entries_begin()->value());
 	};
 
-	void process_symbol(partial_result& pr, const input_symbol& s, std::size_t offset) {
+	void process_symbol(partial_result& pr, const input_symbol& s, std::size_t offset) const {
 		auto layer_begin = pr.m_map.layer_begin();
 		auto layer_end = pr.m_map.layer_end();
 
@@ -68,28 +55,25 @@ public:
 		for (auto iter = layer_begin; iter != layer_end; iter = next_iter) {
 			++next_iter;
 
-			const auto& find_iter = m_transitions.find(to_int(iter->state(), s));
-			if (find_iter == m_transitions.end()) {
-				continue;
-			}
-			const auto& details = find_iter->second;
-			if (!details.pop.empty()) {
+			const auto& details = m_automaton.lookup(iter->state(), s);
+			const auto& pops = m_automaton.pops(details);
+			if (pops.begin() != pops.end()) {
 				if (iter->has_values()) {
-					for (const auto& p: details.pop) {
-						if (p.output == -1) {
+					for (const auto& p: pops) {
+						if (details.output == -1) {
 							pr.m_map.pop_unknown_state(iter, p.state, p.state);
 						} else {
-							pr.m_map.pop_unknown_state(iter, p.state, p.state, update_value(p.output, offset));
+							pr.m_map.pop_unknown_state(iter, p.state, p.state, update_value(details.output, offset));
 						}
 					}
 				}
-				for (const auto& p: details.pop) {
+				for (const auto& p: pops) {
 					const auto& child_iter = iter->find_child(p.label);
 					if (child_iter != iter->children_end()) {
-						if (p.output == -1) {
+						if (details.output == -1) {
 							pr.m_map.pop_state(child_iter, p.state);
 						} else {
-							pr.m_map.pop_state(child_iter, p.state, update_value(p.output, offset));
+							pr.m_map.pop_state(child_iter, p.state, update_value(details.output, offset));
 						}
 					}
 				}
@@ -110,34 +94,68 @@ public:
 			}
 		}
 		pr.m_map.finalise(false);
+		if (m_sampler && offset % m_sample_period == 0) {
+			m_sampler(offset, pr.m_map);
+		}
+	}
+
+	typedef std::function<void(std::size_t, const map_type&)> sampler_type;
+
+	// Installs a hook called with the offset and the state map after every
+	// sample_period-th symbol so the growth of the map over a chunk can be
+	// recorded. Pass an empty function to remove it.
+	void set_sampler(sampler_type sampler, std::size_t sample_period = 1) {
+		assert(sample_period > 0);
+		m_sampler = std::move(sampler);
+		m_sample_period = sample_period;
 	}
 
-	partial_result initial_result() {
+	partial_result initial_result() const {
 		partial_result ret;
-		std::vector<int> stack(1, m_start_state);
+		std::vector<int> stack(1, m_automaton.start_state());
 		ret.m_map.add_entry(stack.begin(), stack.end(), stack.begin(), stack.end(), m_next->initial_result());
 		return ret;
 	}
 
-	partial_result identity_result() {
+	partial_result identity_result() const {
 		partial_result ret;
 		std::vector<int> stack(1);
-		for (int s: m_states) {
+		for (int s: m_automaton.states()) {
 			stack[0] = s;
 			ret.m_map.add_entry(stack.begin(), stack.end(), stack.begin(), stack.end(), m_next->identity_result());
 		}
 		return ret;
 	}
 
+	// For a block known to start with stack [begin, end), the current state
+	// first and the bottom of the stack last
+	template <typename Iterator>
+	partial_result stack_result(Iterator begin, Iterator end) const {
+		partial_result ret;
+		ret.m_map.add_entry(begin, end, begin, end, m_next->identity_result());
+		return ret;
+	}
+
+	const representation::compiled_automaton& automaton() const { return m_automaton; }
+
+	// Bytes used by the state map and the later stage results it holds
+	std::size_t memory_usage(const partial_result& pr) const {
+		std::size_t ret = sizeof(partial_result) - sizeof(map_type) + pr.m_map.statistics().bytes;
+		for (const auto& e: pr.m_map.entries()) {
+			ret += m_next->memory_usage(e.value()) - sizeof(typename Next::partial_result);
+		}
+		return ret;
+	}
+
 	// This is a function primarily designed for testing purposes so that the internal state map
 	// can be set prior to testing the operation of a transition
-	partial_result map_to_result(map_type m) {
+	partial_result map_to_result(map_type m) const {
 		partial_result ret;
 		ret.m_map = std::move(m);
 		return ret;
 	}
 
-	void merge_results(partial_result& lhs, const partial_result& rhs) {
+	void merge_results(partial_result& lhs, const partial_result& rhs) const {
 		auto old = std::move(lhs.m_map);
 		rhs.m_map.start_stack_finalise();
 		lhs.m_map.clear();
@@ -161,12 +179,12 @@ private:
 			next(next), symbol(symbol), offset(offset) {}
 	};
 
-	update_value_function update_value(const typename Next::input_symbol& symbol, std::size_t offset) {
+	update_value_function update_value(const typename Next::input_symbol& symbol, std::size_t offset) const {
 		return update_value_function(m_next, symbol, offset);
 	}
 
 	typedef typename map_type::entry map_entry;
-	void unify_entries(map_entry lhs, const map_entry& rhs, map_type& the_map) {
+	void unify_entries(map_entry lhs, const map_entry& rhs, map_type& the_map) const {
 		std::vector<int> new_start(lhs.start_stack_begin(), lhs.start_stack_end());
 		std::vector<int> new_finish(rhs.finish_stack_begin(), rhs.finish_stack_end());
 
@@ -187,26 +205,10 @@ private:
 		m_next->merge_results(r, rhs.value());
 		the_map.add_entry(new_start.begin(), new_start.end(), new_finish.begin(), new_finish.end(), std::move(r));
 	}
-	struct transition_details {
-		int output = -1;
-		int next = -1;
-		int push = -1;
-		// Pops are stored in a <stored state, new state> pairs
-		struct pop_details {
-			pop_details(int label, int state, int output):
-				label(label), state(state), output(output) {}
-			int label;
-			int state;
-			int output;
-		};
-		std::vector<pop_details> pop;
-	};
-
-	static int to_int(int c, int s) { return c | (s << 16); }
-	std::unordered_map<int, transition_details> m_transitions;
-	int m_start_state;
-	std::set<int> m_states;
+	representation::compiled_automaton m_automaton;
 	const Next* m_next;
+	sampler_type m_sampler;
+	std::size_t m_sample_period = 1;
 };
 
 
@@ -1,28 +1,106 @@
 #ifndef TRANSDUCERS_UTIL_BUFFER_TRANSDUCER_H_
 #define TRANSDUCERS_UTIL_BUFFER_TRANSDUCER_H_
 
-#include <transducers/base/transducer.h>
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
 #include <vector>
 
+#include <transducers/base/transducer.h>
+
 namespace transducers {
 namespace util {
 
+/** Symbols held back by buffer_transducer. The symbols are stored
+ * contiguously and their offsets as runs of consecutive offsets, so a
+ * block of input costs one symbol each plus one run, rather than a
+ * symbol and an offset each.
+ */
+template <typename Symbol>
+class pending_symbols {
+public:
+	void push_back(const Symbol& s, std::size_t offset) {
+		extend(offset, 1);
+		m_symbols.push_back(s);
+	}
+
+	template <typename Iterator>
+	void append(Iterator begin, Iterator end, std::size_t offset) {
+		if (begin == end) return;
+		std::size_t count = m_symbols.size();
+		m_symbols.insert(m_symbols.end(), begin, end);
+		extend(offset, m_symbols.size() - count);
+	}
+
+	void append(const pending_symbols& other) {
+		auto iter = other.m_runs.begin();
+		if (iter == other.m_runs.end()) return;
+		extend(iter->offset, iter->length);
+		m_runs.insert(m_runs.end(), ++iter, other.m_runs.end());
+		m_symbols.insert(m_symbols.end(), other.m_symbols.begin(), other.m_symbols.end());
+	}
+
+	// Calls fn(begin, end, offset) for every run of consecutive offsets
+	template <typename Fn>
+	void for_each_run(const Fn& fn) const {
+		const Symbol* symbols = m_symbols.data();
+		for (const auto& r: m_runs) {
+			fn(symbols, symbols + r.length, r.offset);
+			symbols += r.length;
+		}
+	}
+
+	std::size_t size() const { return m_symbols.size(); }
+	bool empty() const { return m_symbols.empty(); }
+	std::size_t num_runs() const { return m_runs.size(); }
+
+	// Bytes owned outside of the object itself
+	std::size_t heap_usage() const {
+		return m_symbols.capacity() * sizeof(Symbol) + m_runs.capacity() * sizeof(run);
+	}
+
+private:
+	struct run {
+		std::size_t offset;
+		std::size_t length;
+	};
+
+	void extend(std::size_t offset, std::size_t length) {
+		if (m_runs.empty() || m_runs.back().offset + m_runs.back().length != offset) {
+			m_runs.push_back(run{ offset, 0 });
+		}
+		m_runs.back().length += length;
+	}
+
+	std::vector<Symbol> m_symbols;
+	std::vector<run> m_runs;
+};
+
+template <typename Symbol>
+std::size_t heap_usage(const pending_symbols<Symbol>& p) {
+	return p.heap_usage();
+}
+
 /** This transducer buffers all symbols until a particular symbol is seen
  *
- * The main use for this transducer is to wrap a non-associative transducer
+ * The main use for this transducer is to wrap a non-associative transducer.
+ * Blocks are scanned for the trigger symbol and everything after it is
+ * passed on with a single block call, and buffered symbols are replayed
+ * the same way a run at a time.
  */
 template <typename Next>
-class buffer_transducer : 
+class buffer_transducer :
 	public base::transducer<Next,
 		typename Next::input_symbol,
 		typename Next::input_symbol,
-		std::pair<bool, std::vector<std::pair<std::size_t, typename Next::input_symbol>>>>
+		std::pair<bool, pending_symbols<typename Next::input_symbol>>>
 {
 public:
 	typedef base::transducer<Next,
 		typename Next::input_symbol,
 		typename Next::input_symbol,
-		std::pair<bool, std::vector<std::pair<std::size_t, typename Next::input_symbol>>>> base_transducer;
+		std::pair<bool, pending_symbols<typename Next::input_symbol>>> base_transducer;
 
 	typedef typename base_transducer::input_symbol input_symbol;
 	typedef typename base_transducer::partial_result partial_result;
@@ -31,7 +109,7 @@ public:
 		base_transducer(next),
 		m_trigger_symbol(trigger_symbol) { }
 
-	void process_symbol(partial_result& raw_pr, const input_symbol& s, std::size_t offset) {
+	void process_symbol(partial_result& raw_pr, const input_symbol& s, std::size_t offset) const {
 		auto& pr = base_transducer::unwrap(raw_pr);
 		if (pr.first) {
 			base_transducer::output(raw_pr, s, offset);
@@ -39,34 +117,44 @@ public:
 			pr.first = true;
 			base_transducer::output(raw_pr, s, offset);
 		} else {
-			pr.second.emplace_back(s, offset);
+			pr.second.push_back(s, offset);
+		}
+	}
+
+	template <typename Iterator>
+	void process_block(partial_result& raw_pr, Iterator begin, Iterator end, std::size_t offset) const {
+		auto& pr = base_transducer::unwrap(raw_pr);
+		if (!pr.first) {
+			Iterator trigger = std::find(begin, end, m_trigger_symbol);
+			pr.second.append(begin, trigger, offset);
+			if (trigger == end) return;
+			offset += std::distance(begin, trigger);
+			begin = trigger;
+			pr.first = true;
 		}
+		base_transducer::output_block(raw_pr, begin, end, offset);
 	}
 
-	void merge_results(partial_result& r_lhs, const partial_result& r_rhs) {
+	void merge_results(partial_result& r_lhs, const partial_result& r_rhs) const {
 		auto& lhs = base_transducer::unwrap(r_lhs);
 		const auto& rhs = base_transducer::unwrap(r_rhs);
+		if (lhs.first) {
+			replay(r_lhs, rhs.second);
+		} else {
+			lhs.second.append(rhs.second);
+			lhs.first = rhs.first;
+		}
 		if (rhs.first) {
-			if (lhs.first) {
-				for (const auto& p: rhs.second) {
-					base_transducer::output(r_lhs, p.first, p.second);
-				}
-			} else {
-				lhs.second.insert(lhs.second.end(), rhs.second.begin(), rhs.second.end());
-				lhs.first = true;
-			}
 			base_transducer::merge_next(r_lhs, r_rhs);
-		} else {
-			if (lhs.first) {
-				for (const auto& p: rhs.second) {
-					base_transducer::output(r_lhs, p.first, p.second);
-				}
-			} else {
-				lhs.second.insert(lhs.second.end(), rhs.second.begin(), rhs.second.end());
-			}
 		}
 	}
 private:
+	void replay(partial_result& r, const pending_symbols<input_symbol>& pending) const {
+		pending.for_each_run([&](const input_symbol* begin, const input_symbol* end, std::size_t offset) {
+			base_transducer::output_block(r, begin, end, offset);
+		});
+	}
+
 	input_symbol m_trigger_symbol;
 };
 }
@@ -0,0 +1,89 @@
+#ifndef TRANSDUCERS_UTIL_BYTE_CLASSIFIER_H_
+#define TRANSDUCERS_UTIL_BYTE_CLASSIFIER_H_
+
+#include <array>
+#include <cstddef>
+
+#include <representation/compiled_automaton.h>
+#include <transducers/base/transducer.h>
+#include <util/simd.h>
+
+namespace transducers {
+namespace util {
+
+/** class byte_classifier
+ *
+ * Maps each byte to its alphabet class in a compiled automaton and
+ * outputs the class id at the same offset. The stage after it reads the
+ * automaton returned by compiled_automaton::over_classes(), so its loop
+ * over states no longer looks up the class of each symbol.
+ *
+ * process_block() classifies 64 bytes at a time with util::byte_table
+ * before passing any of them on, which keeps the classification out of
+ * the chain of dependent state lookups. Automata with more than 256
+ * classes are classified one byte at a time.
+ */
+template <typename Next>
+class byte_classifier :
+	public base::transducer<Next, unsigned char, unsigned short>
+{
+public:
+	using base_transducer = base::transducer<Next, unsigned char, unsigned short>;
+	using partial_result = typename base_transducer::partial_result;
+	using input_symbol = typename base_transducer::input_symbol;
+	using output_symbol = typename base_transducer::output_symbol;
+
+	byte_classifier(const Next& n, const representation::compiled_automaton& automaton):
+		base_transducer(n),
+		m_classes(classes(automaton)),
+		m_narrow(automaton.num_classes() <= 256),
+		m_table(narrow(m_classes)) {}
+
+	void process_symbol(partial_result& pr, const input_symbol& s, std::size_t offset) const {
+		base_transducer::output(pr, m_classes[s], offset);
+	}
+
+	void process_block(partial_result& pr, const unsigned char* begin,
+			const unsigned char* end, std::size_t offset) const {
+		if (m_narrow) {
+			unsigned char window[::util::simd_window];
+			for (; end - begin >= static_cast<std::ptrdiff_t>(::util::simd_window);
+					begin += ::util::simd_window, offset += ::util::simd_window) {
+				m_table.lookup(begin, window);
+				for (std::size_t i = 0; i < ::util::simd_window; ++i) {
+					base_transducer::output(pr, window[i], offset + i);
+				}
+			}
+		}
+		for (; begin != end; ++begin, ++offset) {
+			process_symbol(pr, *begin, offset);
+		}
+	}
+
+private:
+	static std::array<unsigned short, 256> classes(const representation::compiled_automaton& automaton) {
+		std::array<unsigned short, 256> ret;
+		for (unsigned int c = 0; c < 256; ++c) {
+			ret[c] = automaton.symbol_class(c);
+		}
+		return ret;
+	}
+
+	// Only used when every class fits in a byte
+	static std::array<unsigned char, 256> narrow(const std::array<unsigned short, 256>& classes) {
+		std::array<unsigned char, 256> ret;
+		for (std::size_t c = 0; c < 256; ++c) {
+			ret[c] = static_cast<unsigned char>(classes[c]);
+		}
+		return ret;
+	}
+
+	std::array<unsigned short, 256> m_classes;
+	bool m_narrow;
+	::util::byte_table m_table;
+};
+
+}
+}
+
+#endif
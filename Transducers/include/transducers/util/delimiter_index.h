@@ -0,0 +1,75 @@
+#ifndef TRANSDUCERS_UTIL_DELIMITER_INDEX_H_
+#define TRANSDUCERS_UTIL_DELIMITER_INDEX_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include <transducers/base/transducer.h>
+#include <util/simd.h>
+
+namespace transducers {
+namespace util {
+
+/** class delimiter_index
+ *
+ * Outputs the offset of every byte in a set of delimiters, by default
+ * only the newline, to build an index of line or record starts for
+ * splitting later work. It keeps no state, so blocks merge by simply
+ * concatenating their outputs, which offset_buffer stores compactly.
+ *
+ * process_block() compares 64 bytes at a time against each delimiter,
+ * so it is meant for small sets.
+ */
+template <typename Next>
+class delimiter_index :
+	public base::transducer<Next, unsigned char, std::size_t>
+{
+public:
+	using base_transducer = base::transducer<Next, unsigned char, std::size_t>;
+	using partial_result = typename base_transducer::partial_result;
+	using input_symbol = typename base_transducer::input_symbol;
+	using output_symbol = typename base_transducer::output_symbol;
+
+	delimiter_index(const Next& n, const std::string& delimiters = "\n"):
+		base_transducer(n),
+		m_delimiters(delimiters) {
+		if (m_delimiters.empty()) {
+			throw std::invalid_argument("At least one delimiter is needed");
+		}
+		m_table.fill(false);
+		for (unsigned char c: m_delimiters) m_table[c] = true;
+	}
+
+	void process_symbol(partial_result& pr, const input_symbol& s, std::size_t offset) const {
+		if (m_table[s]) base_transducer::output(pr, offset, offset);
+	}
+
+	void process_block(partial_result& pr, const unsigned char* begin,
+			const unsigned char* end, std::size_t offset) const {
+		for (; end - begin >= static_cast<std::ptrdiff_t>(::util::simd_window);
+				begin += ::util::simd_window, offset += ::util::simd_window) {
+			uint64_t found = 0;
+			for (unsigned char c: m_delimiters) {
+				found |= ::util::byte_mask(begin, c);
+			}
+			::util::for_each_bit(found, [&](std::size_t i) {
+				base_transducer::output(pr, offset + i, offset + i);
+			});
+		}
+		for (; begin != end; ++begin, ++offset) {
+			process_symbol(pr, *begin, offset);
+		}
+	}
+
+private:
+	std::string m_delimiters;
+	std::array<bool, 256> m_table;
+};
+
+}
+}
+
+#endif
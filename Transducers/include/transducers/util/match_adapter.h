@@ -2,7 +2,7 @@
 #define TRANSDUCERS_UTIL_MATCH_ADAPTER_H_
 
 #include <cassert>
-#include <deque>
+#include <data_structures/match_stack.h>
 #include <symbols/match.h>
 #include <transducers/base/transducer.h>
 
@@ -18,17 +18,22 @@ namespace util {
  * reordering may occur when the data is processed in multiple 
  * blocks. This is not a problem at present as the only user of
  * this class is the tree_pushdown_transucer which internally
- * corrects the order.
+ * corrects the order. ordered_match_adapter keeps the order in any
+ * merge tree, at the cost of holding back matches.
+ *
+ * The partial result is a data_structures::match_stack holding only the
+ * open side of each incomplete match, so the steady state of a block
+ * reuses pooled storage instead of allocating.
  */
 
 template <typename Next>
 class match_adapter : 
 	public base::transducer<Next, uint32_t, symbols::match,
-		std::deque<symbols::match>>
+		data_structures::match_stack>
 {
 public:
 	using base_transducer = base::transducer<Next, uint32_t,
-		symbols::match, std::deque<symbols::match>>;
+		symbols::match, data_structures::match_stack>;
 	using partial_result = typename base_transducer::partial_result;
 	using input_symbol = typename base_transducer::input_symbol;
 	using output_symbol = typename base_transducer::output_symbol;
@@ -39,39 +44,40 @@ public:
 		base_transducer(next) {}
 
 	void process_symbol(partial_result& r, const input_symbol& is, 
-			std::size_t offset) {
+			std::size_t offset) const {
 		auto& partial = this->unwrap(r);
-		int value = is & ~match::MATCH_FLAGS_MASK;
+		uint32_t value = is & ~match::MATCH_FLAGS_MASK;
 		if (is & match::MATCH_FLAGS_START) {
-			partial.emplace_back(value, offset, static_cast<std::size_t>(match::npos));
+			partial.push_start(value, offset);
 		}
 		if (is & match::MATCH_FLAGS_END) {
-			if (!partial.empty() && partial.back().end_offset == match::npos) {
-				partial.back().end_offset = offset;
-				this->output(r, partial.back(), offset);
+			if (!partial.empty() && partial.back().is_start()) {
+				const auto& open = partial.back();
+				this->output(r, match(open.rule, open.offset, offset), offset);
 				partial.pop_back();
 			} else {
-				partial.emplace_back(value, static_cast<std::size_t>(match::npos), offset);
+				partial.push_end(value, offset);
 			}
 		}
 	}
 
-	void merge_results(partial_result& lhs, const partial_result& rhs) {
+	void merge_results(partial_result& lhs, const partial_result& rhs) const {
 		auto& lhs_partial = this->unwrap(lhs);
 		const auto& rhs_partial = this->unwrap(rhs);
-		auto front_iter = lhs_partial.rbegin();
-		auto back_iter = rhs_partial.begin();
-		while (front_iter != lhs_partial.rend() && back_iter != rhs_partial.end()) {
-			if (front_iter->end_offset == match::npos && back_iter->start_offset == match::npos) {
-				assert(front_iter->rule == back_iter->rule);
-				this->output(lhs, match(front_iter->rule,
-					front_iter->start_offset, back_iter->end_offset), back_iter->end_offset);
-			}
-			++front_iter;
-			++back_iter;
+		std::size_t front = lhs_partial.size();
+		std::size_t back = 0;
+		// Each side holds its unmatched ends followed by its unmatched
+		// starts, so the starts on the left close with the ends on the right
+		while (front > 0 && back < rhs_partial.size() &&
+				lhs_partial[front - 1].is_start() && !rhs_partial[back].is_start()) {
+			const auto& start = lhs_partial[front - 1];
+			const auto& end = rhs_partial[back];
+			assert(start.rule == end.rule);
+			this->output(lhs, match(start.rule, start.offset, end.offset), end.offset);
+			--front;
+			++back;
 		}
-		lhs_partial.erase(front_iter.base(), lhs_partial.end());
-		lhs_partial.insert(lhs_partial.end(), back_iter, rhs_partial.end());
+		lhs_partial.splice(front, rhs_partial, back);
 		this->merge_next(lhs, rhs);
 	}
 };
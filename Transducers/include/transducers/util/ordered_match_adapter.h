@@ -0,0 +1,138 @@
+#ifndef TRANSDUCERS_UTIL_ORDERED_MATCH_ADAPTER_H_
+#define TRANSDUCERS_UTIL_ORDERED_MATCH_ADAPTER_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+#include <data_structures/match_stack.h>
+#include <symbols/match.h>
+#include <transducers/base/transducer.h>
+#include <util/memory_usage.h>
+
+namespace transducers {
+namespace util {
+
+/** Partial state of ordered_match_adapter. open holds the unmatched ends
+ * followed by the unmatched starts, as in match_adapter, and held the
+ * complete matches which may not be output yet. In the leftmost result
+ * held is a heap with the lowest start on top.
+ */
+struct ordered_matches {
+	bool leftmost = false;
+	data_structures::match_stack open;
+	std::vector<symbols::match> held;
+};
+
+inline std::size_t heap_usage(const ordered_matches& m) {
+	return m.open.heap_usage() + ::util::heap_usage(m.held);
+}
+
+/** class ordered_match_adapter
+ *
+ * Converts begin and end events into matches like match_adapter, but
+ * outputs them in order of their start offsets whatever the blocks and
+ * merge order. A match starting inside any block but the leftmost may
+ * still be preceded by one closing further right, so only the leftmost
+ * result, the one started from initial_result(), outputs matches: those
+ * starting before its outermost open start. Everything else is held and
+ * passed on as merges into the leftmost result close the matches before
+ * it. No sort over the whole output is needed, and the stream can feed
+ * a sink such as stream_sink directly.
+ */
+template <typename Next>
+class ordered_match_adapter :
+	public base::transducer<Next, uint32_t, symbols::match, ordered_matches>
+{
+public:
+	using base_transducer = base::transducer<Next, uint32_t, symbols::match, ordered_matches>;
+	using partial_result = typename base_transducer::partial_result;
+	using input_symbol = typename base_transducer::input_symbol;
+	using output_symbol = typename base_transducer::output_symbol;
+
+	using match = symbols::match;
+
+	ordered_match_adapter(const Next& next):
+		base_transducer(next) {}
+
+	void process_symbol(partial_result& r, const input_symbol& is, std::size_t offset) const {
+		auto& partial = this->unwrap(r);
+		uint32_t value = is & ~match::MATCH_FLAGS_MASK;
+		if (is & match::MATCH_FLAGS_START) {
+			partial.open.push_start(value, offset);
+		}
+		if (is & match::MATCH_FLAGS_END) {
+			if (!partial.open.empty() && partial.open.back().is_start()) {
+				const auto& open = partial.open.back();
+				hold(partial, match(open.rule, open.offset, offset));
+				partial.open.pop_back();
+				release(r);
+			} else {
+				partial.open.push_end(value, offset);
+			}
+		}
+	}
+
+	void merge_results(partial_result& lhs, const partial_result& rhs) const {
+		auto& lhs_partial = this->unwrap(lhs);
+		const auto& rhs_partial = this->unwrap(rhs);
+		std::size_t front = lhs_partial.open.size();
+		std::size_t back = 0;
+		while (front > 0 && back < rhs_partial.open.size() &&
+				lhs_partial.open[front - 1].is_start() && !rhs_partial.open[back].is_start()) {
+			const auto& start = lhs_partial.open[front - 1];
+			assert(start.rule == rhs_partial.open[back].rule);
+			hold(lhs_partial, match(start.rule, start.offset, rhs_partial.open[back].offset));
+			--front;
+			++back;
+		}
+		lhs_partial.open.splice(front, rhs_partial.open, back);
+		for (const auto& m: rhs_partial.held) hold(lhs_partial, m);
+		release(lhs);
+		this->merge_next(lhs, rhs);
+	}
+
+	partial_result initial_result() const {
+		ordered_matches m;
+		m.leftmost = true;
+		return base_transducer::initial_result(std::move(m));
+	}
+
+private:
+	static bool later_start(const match& lhs, const match& rhs) {
+		return rhs.start_offset < lhs.start_offset ||
+			(rhs.start_offset == lhs.start_offset && rhs.end_offset < lhs.end_offset);
+	}
+
+	static void hold(ordered_matches& partial, const match& m) {
+		partial.held.push_back(m);
+		if (partial.leftmost) {
+			std::push_heap(partial.held.begin(), partial.held.end(), later_start);
+		}
+	}
+
+	// Outputs the held matches of the leftmost result which start before
+	// its outermost open start
+	void release(partial_result& r) const {
+		auto& partial = this->unwrap(r);
+		if (!partial.leftmost) return;
+		std::size_t bound = match::npos;
+		for (const auto& m: partial.open) {
+			if (m.is_start()) {
+				bound = m.offset;
+				break;
+			}
+		}
+		while (!partial.held.empty() && partial.held.front().start_offset < bound) {
+			std::pop_heap(partial.held.begin(), partial.held.end(), later_start);
+			this->output(r, partial.held.back(), partial.held.back().end_offset);
+			partial.held.pop_back();
+		}
+	}
+};
+
+}
+}
+
+#endif
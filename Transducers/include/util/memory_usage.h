@@ -0,0 +1,61 @@
+#ifndef UTIL_MEMORY_USAGE_H_
+#define UTIL_MEMORY_USAGE_H_
+
+#include <cstddef>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+/** heap_usage returns the number of bytes a value owns outside of its
+ * own footprint, memory_usage adds sizeof the value itself. Containers
+ * are costed by capacity where the standard exposes it, deques by size
+ * as their block layout is implementation defined.
+ */
+
+template <typename T>
+std::size_t heap_usage(const T&);
+template <typename T1, typename T2>
+std::size_t heap_usage(const std::pair<T1, T2>& p);
+template <typename T, typename A>
+std::size_t heap_usage(const std::vector<T, A>& v);
+template <typename T, typename A>
+std::size_t heap_usage(const std::deque<T, A>& d);
+
+template <typename T>
+std::size_t heap_usage(const T&) {
+	return 0;
+}
+
+template <typename T1, typename T2>
+std::size_t heap_usage(const std::pair<T1, T2>& p) {
+	return heap_usage(p.first) + heap_usage(p.second);
+}
+
+template <typename T, typename A>
+std::size_t heap_usage(const std::vector<T, A>& v) {
+	std::size_t ret = v.capacity() * sizeof(T);
+	for (const auto& e: v) {
+		ret += heap_usage(e);
+	}
+	return ret;
+}
+
+template <typename T, typename A>
+std::size_t heap_usage(const std::deque<T, A>& d) {
+	std::size_t ret = d.size() * sizeof(T);
+	for (const auto& e: d) {
+		ret += heap_usage(e);
+	}
+	return ret;
+}
+
+template <typename T>
+std::size_t memory_usage(const T& t) {
+	return sizeof(T) + heap_usage(t);
+}
+
+}
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef UTIL_SIMD_H_
+#define UTIL_SIMD_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+#ifdef __PCLMUL__
+#include <wmmintrin.h>
+#endif
+
+namespace util {
+
+/** Helpers for scanning bytes 64 at a time. Bit i of a mask stands for
+ * byte i of the 64 byte window it was computed from. The SSE2, SSSE3 and
+ * carry-less multiply paths are used when the compiler targets them,
+ * otherwise portable code gives the same results. SSE2 is part of every
+ * x86-64 target, the others are opt-in with the ENABLE_SIMD build option.
+ */
+
+const std::size_t simd_window = 64;
+
+// Bytes of p[0, 64) equal to c
+inline uint64_t byte_mask(const unsigned char* p, unsigned char c) {
+#ifdef __SSE2__
+	const __m128i needle = _mm_set1_epi8(static_cast<char>(c));
+	uint64_t ret = 0;
+	for (int i = 0; i < 4; ++i) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+		uint64_t m = static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle)));
+		ret |= m << (16 * i);
+	}
+	return ret;
+#else
+	uint64_t ret = 0;
+	for (std::size_t i = 0; i < simd_window; ++i) {
+		ret |= static_cast<uint64_t>(p[i] == c) << i;
+	}
+	return ret;
+#endif
+}
+
+// Bit i of the result is the parity of bits [0, i] of m, with a single
+// carry-less multiply by all ones in ENABLE_SIMD builds
+inline uint64_t prefix_xor(uint64_t m) {
+#ifdef __PCLMUL__
+	__m128i product = _mm_clmulepi64_si128(_mm_set_epi64x(0, m), _mm_set1_epi8(static_cast<char>(0xff)), 0);
+	return static_cast<uint64_t>(_mm_cvtsi128_si64(product));
+#else
+	m ^= m << 1;
+	m ^= m << 2;
+	m ^= m << 4;
+	m ^= m << 8;
+	m ^= m << 16;
+	m ^= m << 32;
+	return m;
+#endif
+}
+
+// The first byte of [begin, end) equal to one of bytes[0, count), or end
+inline const unsigned char* find_any(const unsigned char* begin, const unsigned char* end,
+		const unsigned char* bytes, int count) {
+	if (count == 0) return end;
+	if (count == 1) {
+		const void* found = std::memchr(begin, bytes[0], end - begin);
+		return found ? static_cast<const unsigned char*>(found) : end;
+	}
+	for (; end - begin >= static_cast<std::ptrdiff_t>(simd_window); begin += simd_window) {
+		uint64_t found = 0;
+		for (int i = 0; i < count; ++i) {
+			found |= byte_mask(begin, bytes[i]);
+		}
+		if (found != 0) return begin + __builtin_ctzll(found);
+	}
+	for (; begin != end; ++begin) {
+		for (int i = 0; i < count; ++i) {
+			if (*begin == bytes[i]) return begin;
+		}
+	}
+	return end;
+}
+
+/** A 256 entry byte table looked up 64 bytes at a time. With SSSE3,
+ * which only ENABLE_SIMD builds target, the low nibble of each byte
+ * selects its entry from a row of 16 with PSHUFB, and the high nibble,
+ * mapped to the row it uses, picks the row. Rows are shared between high
+ * nibbles with equal entries and rows of zeros are never looked up, so
+ * tables with few distinct rows are cheapest.
+ */
+class byte_table {
+public:
+	explicit byte_table(const std::array<unsigned char, 256>& table):
+		m_table(table) {
+		m_row_of.fill(0);
+		for (int hi = 0; hi < 16; ++hi) {
+			std::array<unsigned char, 16> row;
+			std::memcpy(row.data(), table.data() + 16 * hi, 16);
+			if (row == std::array<unsigned char, 16>()) continue;
+			std::size_t r = 0;
+			while (r < m_rows.size() && m_rows[r] != row) ++r;
+			if (r == m_rows.size()) m_rows.push_back(row);
+			m_row_of[hi] = r + 1;
+		}
+	}
+
+	unsigned char operator[](unsigned char c) const { return m_table[c]; }
+
+	// Writes the entries of p[0, 64) to out[0, 64)
+	void lookup(const unsigned char* p, unsigned char* out) const {
+#ifdef __SSSE3__
+		const __m128i low_nibble = _mm_set1_epi8(0x0f);
+		const __m128i row_of = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_row_of.data()));
+		for (int i = 0; i < 4; ++i) {
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+			__m128i lo = _mm_and_si128(v, low_nibble);
+			__m128i row = _mm_shuffle_epi8(row_of, _mm_and_si128(_mm_srli_epi16(v, 4), low_nibble));
+			__m128i ret = _mm_setzero_si128();
+			for (std::size_t r = 0; r < m_rows.size(); ++r) {
+				__m128i entries = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_rows[r].data()));
+				__m128i selected = _mm_cmpeq_epi8(row, _mm_set1_epi8(static_cast<char>(r + 1)));
+				ret = _mm_or_si128(ret, _mm_and_si128(_mm_shuffle_epi8(entries, lo), selected));
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16 * i), ret);
+		}
+#else
+		for (std::size_t i = 0; i < simd_window; ++i) {
+			out[i] = m_table[p[i]];
+		}
+#endif
+	}
+
+	std::size_t num_rows() const { return m_rows.size(); }
+
+private:
+	std::array<unsigned char, 256> m_table;
+	std::vector<std::array<unsigned char, 16>> m_rows;
+	// One more than the index in m_rows of each high nibble's row, 0 for zeros
+	std::array<unsigned char, 16> m_row_of;
+};
+
+// Calls fn with the index of every set bit of m in increasing order
+template <typename Fn>
+inline void for_each_bit(uint64_t m, const Fn& fn) {
+	while (m != 0) {
+		fn(static_cast<std::size_t>(__builtin_ctzll(m)));
+		m &= m - 1;
+	}
+}
+
+}
+
+#endif
@@ -0,0 +1,111 @@
+#include "data_structures/match_stack.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <thread>
+#include <vector>
+
+using namespace data_structures;
+
+class match_stack_test: public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(match_stack_test);
+	CPPUNIT_TEST(push_pop_test);
+	CPPUNIT_TEST(splice_test);
+	CPPUNIT_TEST(pool_test);
+	CPPUNIT_TEST(pool_capacity_test);
+	CPPUNIT_TEST(thread_pool_test);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void setUp() {}
+	void tearDown() {}
+
+	void push_pop_test() {
+		CPPUNIT_ASSERT_EQUAL(std::size_t(16), sizeof(open_match));
+		match_stack s;
+		s.push_end(1, 3);
+		s.push_start(2, 5);
+		s.push_start(3, 7);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(3), s.size());
+		CPPUNIT_ASSERT(!s[0].is_start());
+		CPPUNIT_ASSERT(s.back().is_start());
+		CPPUNIT_ASSERT_EQUAL(uint32_t(3), s.back().rule);
+		CPPUNIT_ASSERT_EQUAL(uint64_t(7), s.back().offset);
+		s.pop_back();
+		CPPUNIT_ASSERT_EQUAL(uint64_t(5), s.back().offset);
+
+		match_stack copy = s;
+		CPPUNIT_ASSERT_EQUAL(std::size_t(2), copy.size());
+		CPPUNIT_ASSERT_EQUAL(uint32_t(1), copy[0].rule);
+	}
+
+	void splice_test() {
+		match_stack lhs;
+		lhs.push_end(1, 0);
+		lhs.push_start(2, 1);
+		lhs.push_start(3, 2);
+		match_stack rhs;
+		rhs.push_end(3, 4);
+		rhs.push_start(4, 5);
+		// The start of rule 3 closes with the first end on the right
+		lhs.splice(2, rhs, 1);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(3), lhs.size());
+		CPPUNIT_ASSERT_EQUAL(uint32_t(2), lhs[1].rule);
+		CPPUNIT_ASSERT_EQUAL(uint32_t(4), lhs[2].rule);
+		CPPUNIT_ASSERT_EQUAL(uint64_t(5), lhs[2].offset);
+
+		match_stack empty;
+		empty.splice(0, lhs, 0);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(3), empty.size());
+	}
+
+	void pool_test() {
+		// Take whatever earlier tests left in the pool of this thread
+		std::vector<match_stack> drained(match_stack::pool_size);
+		for (auto& d: drained) d.push_start(0, 0);
+		const open_match* storage;
+		{
+			match_stack s;
+			for (int i = 0; i < 100; ++i) s.push_start(i, i);
+			storage = s.begin();
+		}
+		// A stack dropped on this thread hands its array to the next one
+		match_stack t;
+		t.push_start(0, 0);
+		CPPUNIT_ASSERT(t.begin() == storage);
+		CPPUNIT_ASSERT(t.heap_usage() >= 100 * sizeof(open_match));
+	}
+
+	void pool_capacity_test() {
+		std::vector<match_stack> drained(match_stack::pool_size);
+		for (auto& d: drained) d.push_start(0, 0);
+		{
+			match_stack s;
+			for (std::size_t i = 0; i <= match_stack::max_pooled_capacity; ++i) s.push_start(i, i);
+		}
+		// Arrays above the limit are freed rather than kept in the pool
+		match_stack t;
+		t.push_start(0, 0);
+		CPPUNIT_ASSERT(t.heap_usage() <= match_stack::max_pooled_capacity * sizeof(open_match));
+	}
+
+	// Arrays dropped on a thread which has ended are reused by later threads
+	void thread_pool_test() {
+		const open_match* storage = nullptr;
+		std::thread([&]() {
+			match_stack s;
+			for (int i = 0; i < 100; ++i) s.push_start(i, i);
+			storage = s.begin();
+		}).join();
+		bool reused = false;
+		std::thread([&]() {
+			std::vector<match_stack> stacks(match_stack::pool_size);
+			for (auto& s: stacks) {
+				s.push_start(0, 0);
+				reused = reused || s.begin() == storage;
+			}
+		}).join();
+		CPPUNIT_ASSERT(reused);
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(match_stack_test);
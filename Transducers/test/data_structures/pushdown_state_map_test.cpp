@@ -12,6 +12,7 @@ public:
 	CPPUNIT_TEST(push_test);
 	CPPUNIT_TEST(pop_test);
 	CPPUNIT_TEST(unknown_pop_test);
+	CPPUNIT_TEST(statistics_test);
 	CPPUNIT_TEST_SUITE_END();
 public:
 	typedef data_structures::pushdown_state_map<int> state_map;
@@ -140,6 +141,28 @@ public:
 		exp.start_stack_finalise();
 		CPPUNIT_ASSERT_EQUAL(ssize_t(3), std::distance(exp.start_layer_begin(), exp.start_layer_end()));
 	}
+
+	void statistics_test() {
+		state_map m1;
+		int stack[3] = {0, 1, 2};
+		for (int i = 0; i < 3; ++i) {
+			m1.add_entry(stack, stack + 1, stack, stack + i + 1, i);
+		}
+		m1.finalise();
+
+		CPPUNIT_ASSERT_EQUAL(std::size_t(3), m1.size());
+		const auto stats = m1.statistics();
+		CPPUNIT_ASSERT_EQUAL(std::size_t(3), stats.entries);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(3), stats.start_nodes);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(6), stats.finish_nodes);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), stats.max_start_depth());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(3), stats.max_finish_depth());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(3), stats.start_depths[1]);
+		for (int i = 1; i <= 3; ++i) {
+			CPPUNIT_ASSERT_EQUAL(std::size_t(1), stats.finish_depths[i]);
+		}
+		CPPUNIT_ASSERT(stats.bytes >= 3 * sizeof(state_map::entry));
+	}
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(pushdown_state_map_test);
@@ -0,0 +1,123 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "pipelines/json_query.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using symbols::match;
+
+class json_query_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(json_query_test);
+	CPPUNIT_TEST(document_test);
+	CPPUNIT_TEST(records_test);
+	CPPUNIT_TEST(block_test);
+	CPPUNIT_TEST(malformed_test);
+	CPPUNIT_TEST(overlap_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	const std::vector<std::string> paths = {
+		"$.store.book[*].title", "$..price", "$.store.book[*]", "$.store.*"
+	};
+	const std::string book1 =
+		"{\"title\": \"A \\\"}]\\\\\", \"price\": 8.95, \"tags\": [\"price\", {\"x\": \"[\"}]}";
+	const std::string book2 = "{ \"title\" : \"B\",\"price\":12 , \"isbn\": null }";
+	const std::string bicycle = "{\"price\": 19.95, \"title\": true}";
+	const std::string books = "[ " + book1 + ",\n  " + book2 + " ]";
+	const std::string doc =
+		"{\n \"store\": {\"book\": " + books + ",\n  \"bicycle\": " + bicycle + "},\n"
+		" \"price\": -1e3\n}\n";
+
+	void setUp() {}
+	void tearDown() {}
+
+	static match value(const std::string& doc, const std::string& text,
+			std::size_t rule, std::size_t from = 0) {
+		std::size_t start = doc.find(text, from);
+		return match(rule, start, start + text.size() - 1);
+	}
+
+	void document_test() {
+		std::size_t b2 = doc.find(book2);
+		std::vector<match> expected = {
+			value(doc, books, 3),
+			value(doc, book1, 2),
+			value(doc, "\"A \\\"}]\\\\\"", 0),
+			value(doc, "8.95", 1),
+			value(doc, book2, 2),
+			value(doc, "\"B\"", 0, b2),
+			value(doc, "12", 1, b2),
+			value(doc, bicycle, 3),
+			value(doc, "19.95", 1),
+			value(doc, "-1e3", 1),
+		};
+		pipelines::json_query query(paths);
+		auto result = query.run(doc, 1);
+		CPPUNIT_ASSERT_EQUAL(expected.size(), result.size());
+		for (std::size_t i = 0; i < expected.size(); ++i) {
+			CPPUNIT_ASSERT_EQUAL(expected[i], result[i]);
+		}
+	}
+
+	// Newline delimited records, each matched as a whole by $
+	void records_test() {
+		const std::string records = "{\"a\":1}\n[2]\n\"three\"\n4\n";
+		pipelines::json_query query({ "$", "$.a" });
+		std::vector<match> expected = {
+			match(0, 0, 6), match(1, 5, 5),
+			match(0, 8, 10),
+			match(0, 12, 18),
+			match(0, 20, 20),
+		};
+		for (std::size_t blocks = 1; blocks <= records.size(); ++blocks) {
+			CPPUNIT_ASSERT(expected == query.run(records, blocks));
+		}
+	}
+
+	void block_test() {
+		std::string big = "[\n";
+		for (int i = 0; i < 8; ++i) big += doc + ",\n";
+		big += doc + "]\n";
+		std::vector<std::string> all = paths;
+		for (auto& p: all) p.replace(0, 1, "$[*]");
+		pipelines::json_query query(all);
+		auto expected = query.run(big, 1);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(90), expected.size());
+		for (std::size_t blocks: { 2, 3, 5, 8, 13, 21, 34, 64 }) {
+			CPPUNIT_ASSERT(expected == query.run(big, blocks));
+		}
+	}
+
+	void malformed_test() {
+		pipelines::json_query query(paths);
+		for (std::string doc: { "{\"a\": 1]", "[1 : 2]", "}", "{\"a\" 1}" }) {
+			CPPUNIT_ASSERT_THROW(query.run(doc, 1), std::runtime_error);
+			CPPUNIT_ASSERT_THROW(query.run(doc, 3), std::runtime_error);
+		}
+	}
+
+	// Values matched by several selectors are reported for each of them
+	void overlap_test() {
+		const std::string doc = "{\"store\":{\"book\":[{\"price\":1},{\"price\":2}],\"price\":3}}";
+		std::vector<match> expected = {
+			match(0, 27, 27), match(1, 27, 27),
+			match(0, 39, 39), match(1, 39, 39),
+			match(0, 51, 51),
+		};
+		for (std::size_t blocks: { 1, 3, 7 }) {
+			CPPUNIT_ASSERT(expected == pipelines::json_query({ "$..price", "$.store.book[*].price" }).run(doc, blocks));
+		}
+		for (auto& m: expected) m.rule = 1 - m.rule;
+		std::sort(expected.begin(), expected.end(), [](const match& lhs, const match& rhs) {
+			return lhs.start_offset < rhs.start_offset ||
+				(lhs.start_offset == rhs.start_offset && lhs.rule < rhs.rule);
+		});
+		CPPUNIT_ASSERT(expected == pipelines::json_query({ "$.store.book[*].price", "$..price" }).run(doc, 1));
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(json_query_test);
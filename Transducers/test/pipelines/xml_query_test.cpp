@@ -0,0 +1,146 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "pipelines/xml_query.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using symbols::match;
+
+class xml_query_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(xml_query_test);
+	CPPUNIT_TEST(document_test);
+	CPPUNIT_TEST(block_test);
+	CPPUNIT_TEST(markup_block_test);
+	CPPUNIT_TEST(overlap_test);
+	CPPUNIT_TEST(stream_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	const std::vector<std::string> paths = { "/a/b//c", "//d", "/a/*", "//c" };
+	const std::string body =
+		" <b x=\"1/2\" y='>'>\n"
+		"  <c>one</c>\n"
+		"  <d><c/></d>\n"
+		" </b>\n"
+		" <bb><c>two</c></bb>\n"
+		" <b><e><c id=\"3\" /></e></b>\n";
+
+	void setUp() {}
+	void tearDown() {}
+
+	static match element(const std::string& doc, const std::string& start_tag,
+			const std::string& end_tag, std::size_t rule) {
+		std::size_t start = doc.find(start_tag);
+		std::size_t end = doc.find(end_tag, start) + end_tag.size() - 1;
+		return match(rule, start, end);
+	}
+
+	void document_test() {
+		const std::string doc =
+			"<?xml version=\"1.0\"?>\n"
+			"<!DOCTYPE a [ <!ELEMENT a ANY> ]>\n"
+			"<a>\n"
+			"<!-- <c>not</c> --><![CDATA[ <c>not</c> ]]>\n" +
+			body +
+			"</a>\n";
+		std::vector<match> expected = {
+			element(doc, "<b x", "</b>", 2),
+			element(doc, "<c>one", "</c>", 0),
+			element(doc, "<c>one", "</c>", 3),
+			element(doc, "<d>", "</d>", 1),
+			element(doc, "<c/>", "/>", 0),
+			element(doc, "<c/>", "/>", 3),
+			element(doc, "<bb>", "</bb>", 2),
+			element(doc, "<c>two", "</c>", 3),
+			element(doc, "<b><e>", "</b>", 2),
+			element(doc, "<c id", "/>", 0),
+			element(doc, "<c id", "/>", 3),
+		};
+		pipelines::xml_query query(paths);
+		auto result = query.run(doc, 1);
+		CPPUNIT_ASSERT_EQUAL(expected.size(), result.size());
+		for (std::size_t i = 0; i < expected.size(); ++i) {
+			CPPUNIT_ASSERT_EQUAL(expected[i], result[i]);
+		}
+	}
+
+	void block_test() {
+		std::string doc = "<a>\n";
+		for (int i = 0; i < 8; ++i) doc += body;
+		doc += "</a>\n";
+		pipelines::xml_query query(paths);
+		auto expected = query.run(doc, 1);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(88), expected.size());
+		for (std::size_t blocks = 2; blocks <= 64; ++blocks) {
+			CPPUNIT_ASSERT(expected == query.run(doc, blocks));
+		}
+	}
+
+	// Blocks starting at a '<' inside markup are run again from the right state
+	void markup_block_test() {
+		std::string doc = "<a>\n";
+		for (int i = 0; i < 16; ++i) {
+			doc += " <b t=\"<c>x</c>\" u='<d>'><![CDATA[ <c>y</c> <d> ]]></b>\n";
+			doc += " <!-- <c>z</c> <d> --><d><c/></d>\n";
+			doc += " <?pi <c> ?><c>w</c>\n";
+		}
+		doc += "</a>\n";
+		pipelines::xml_query query(paths);
+		auto expected = query.run(doc, 1);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(16 * 6), expected.size());
+		for (std::size_t blocks = 2; blocks <= 128; ++blocks) {
+			CPPUNIT_ASSERT(expected == query.run(doc, blocks));
+		}
+		// Interleaved chunks starting inside markup are run again too
+		for (std::size_t streams = 2; streams <= 8; ++streams) {
+			query.set_streams(streams);
+			CPPUNIT_ASSERT(expected == query.run(doc, 1));
+			CPPUNIT_ASSERT(expected == query.run(doc, 3));
+		}
+	}
+
+	void overlap_test() {
+		const std::string doc = "<a><c/><b><c/></b></a>";
+		pipelines::xml_query query({ "//c", "/a/c" });
+		std::vector<match> expected = {
+			match(0, 3, 6),
+			match(1, 3, 6),
+			match(0, 10, 13),
+		};
+		CPPUNIT_ASSERT(expected == query.run(doc, 1));
+		CPPUNIT_ASSERT(expected == query.run(doc, 4));
+	}
+
+	// Streamed matches come in document order whatever the windows
+	void stream_test() {
+		std::string doc = "<a>\n";
+		for (int i = 0; i < 8; ++i) doc += body;
+		doc += " <!-- <c>z</c> --><b t=\"<c>\"><c/></b>\n</a>\n";
+		pipelines::xml_query query(paths);
+		auto expected = query.run(doc, 1);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(91), expected.size());
+		for (std::size_t window: { std::size_t(0), std::size_t(1), std::size_t(10), std::size_t(97), doc.size() }) {
+			for (std::size_t blocks: { 1, 3, 8 }) {
+				std::vector<match> out;
+				CPPUNIT_ASSERT_EQUAL(expected.size(), query.run(doc.data(), doc.size(), blocks, window,
+					[&](const match& m) { out.push_back(m); }));
+				CPPUNIT_ASSERT(expected == out);
+			}
+		}
+
+		// Matches are handed on before an unbalanced end tag further on is read
+		const std::string malformed = doc + "</a>\n";
+		std::vector<match> out;
+		CPPUNIT_ASSERT_THROW(query.run(malformed.data(), malformed.size(), 2, 64, [&](const match& m) {
+			out.push_back(m);
+		}), std::runtime_error);
+		CPPUNIT_ASSERT(!out.empty());
+		CPPUNIT_ASSERT(std::equal(out.begin(), out.end(), expected.begin()));
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(xml_query_test);
@@ -0,0 +1,156 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <cstdio>
+#include <fstream>
+
+#include "representation/compiled_automaton.h"
+#include "transducers/finite/finite_transducer.h"
+#include "transducers/aggregation/symbol_buffer.h"
+#include "transducers/compose.h"
+
+using representation::compiled_automaton;
+
+class compiled_automaton_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(compiled_automaton_test);
+	CPPUNIT_TEST(class_test);
+	CPPUNIT_TEST(lookup_test);
+	CPPUNIT_TEST(pop_test);
+	CPPUNIT_TEST(save_load_test);
+	CPPUNIT_TEST(bad_file_test);
+	CPPUNIT_TEST(corrupt_file_test);
+	CPPUNIT_TEST(negative_state_test);
+	CPPUNIT_TEST(exits_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	representation::dft_description description;
+	const std::string filename = "compiled_automaton_test.bin";
+
+	void setUp() {
+		description = representation::dft_description{};
+		description.transitions.insert(std::make_pair(std::make_pair(1, 'a'), 2));
+		description.transitions.insert(std::make_pair(std::make_pair(1, 'x'), 2));
+		description.transitions.insert(std::make_pair(std::make_pair(2, 'b'), 3));
+		description.transitions.insert(std::make_pair(std::make_pair(3, 'c'), 1));
+		description.output.insert(std::make_pair(std::make_pair(3, 'c'), 20));
+		description.push.insert(std::make_pair(std::make_pair(2, 'b'), 2));
+		description.pop.insert(std::make_pair(std::make_pair(3, 'd'), std::make_pair(2, 1)));
+		description.pop.insert(std::make_pair(std::make_pair(3, 'd'), std::make_pair(1, 3)));
+		description.start_state = 1;
+	}
+	void tearDown() {
+		std::remove(filename.c_str());
+	}
+
+	void class_test() {
+		compiled_automaton a(description);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(4), a.num_states());
+		CPPUNIT_ASSERT_EQUAL(std::size_t('x' + 1), a.alphabet_size());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(5), a.num_classes());
+		CPPUNIT_ASSERT_EQUAL(a.symbol_class('a'), a.symbol_class('x'));
+		CPPUNIT_ASSERT(a.symbol_class('a') != a.symbol_class('b'));
+		CPPUNIT_ASSERT_EQUAL(0u, a.symbol_class('z'));
+		CPPUNIT_ASSERT_EQUAL(0u, a.symbol_class('e'));
+		CPPUNIT_ASSERT_EQUAL(0u, a.symbol_class(0x10000));
+	}
+
+	void lookup_test() {
+		compiled_automaton a(description);
+		CPPUNIT_ASSERT_EQUAL(1, a.start_state());
+		CPPUNIT_ASSERT_EQUAL(2, a.lookup(1, 'x').next);
+		CPPUNIT_ASSERT_EQUAL(-1, a.lookup(1, 'x').output);
+		CPPUNIT_ASSERT_EQUAL(3, a.lookup(2, 'b').next);
+		CPPUNIT_ASSERT_EQUAL(2, a.lookup(2, 'b').push);
+		CPPUNIT_ASSERT_EQUAL(20, a.lookup(3, 'c').output);
+		CPPUNIT_ASSERT_EQUAL(-1, a.lookup(2, 'c').next);
+		CPPUNIT_ASSERT_EQUAL(-1, a.lookup(0, 'a').next);
+		std::vector<int> states(a.states().begin(), a.states().end());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(3), states.size());
+		CPPUNIT_ASSERT_EQUAL(1, states[0]);
+		CPPUNIT_ASSERT_EQUAL(3, states[2]);
+	}
+
+	void pop_test() {
+		compiled_automaton a(description);
+		const auto& pops = a.pops(a.lookup(3, 'd'));
+		CPPUNIT_ASSERT_EQUAL(2l, pops.end() - pops.begin());
+		CPPUNIT_ASSERT_EQUAL(2, pops.begin()[0].label);
+		CPPUNIT_ASSERT_EQUAL(1, pops.begin()[0].state);
+		CPPUNIT_ASSERT_EQUAL(1, pops.begin()[1].label);
+		CPPUNIT_ASSERT_EQUAL(3, pops.begin()[1].state);
+		const auto& none = a.pops(a.lookup(1, 'a'));
+		CPPUNIT_ASSERT(none.begin() == none.end());
+	}
+
+	void save_load_test() {
+		compiled_automaton(description).save(filename);
+		compiled_automaton a(filename);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(5), a.num_classes());
+		CPPUNIT_ASSERT_EQUAL(3, a.lookup(2, 'b').next);
+		CPPUNIT_ASSERT_EQUAL(2l, a.pops(a.lookup(3, 'd')).end() - a.pops(a.lookup(3, 'd')).begin());
+
+		transducers::aggregation::symbol_buffer<int> b;
+		auto trans = transducers::compose<transducers::finite::finite_transducer>(b, a);
+		auto pr1 = trans.initial_result();
+		trans.process_symbol(pr1, 'x', 0);
+		trans.process_symbol(pr1, 'b', 1);
+		trans.process_symbol(pr1, 'c', 2);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), trans.last_stage_result(pr1).size());
+		CPPUNIT_ASSERT_EQUAL(20, trans.last_stage_result(pr1).at(0));
+	}
+
+	void bad_file_test() {
+		CPPUNIT_ASSERT_THROW(compiled_automaton("no_such_automaton.bin"), std::runtime_error);
+		std::ofstream out(filename);
+		out << "this is not a compiled automaton at all, honest";
+		out.close();
+		CPPUNIT_ASSERT_THROW(compiled_automaton{filename}, std::runtime_error);
+	}
+
+	// Overwrites four bytes at offset of a saved automaton and loads it
+	void load_patched(std::size_t offset, uint32_t value) {
+		compiled_automaton(description).save(filename);
+		std::fstream f(filename, std::ios::in | std::ios::out | std::ios::binary);
+		f.seekp(offset);
+		f.write(reinterpret_cast<const char*>(&value), sizeof(value));
+		f.close();
+		compiled_automaton{filename};
+	}
+
+	void corrupt_file_test() {
+		const std::size_t classes = 48;
+		const std::size_t alphabet_size = 'x' + 1;
+		const std::size_t transitions = (classes + alphabet_size * sizeof(uint16_t) + 7) & ~std::size_t(7);
+		CPPUNIT_ASSERT_NO_THROW(load_patched(transitions, 3));
+		CPPUNIT_ASSERT_THROW(load_patched(classes, 0xffffffff), std::runtime_error);
+		CPPUNIT_ASSERT_THROW(load_patched(transitions, 1000000), std::runtime_error);
+		CPPUNIT_ASSERT_THROW(load_patched(transitions + 8, 1000000), std::runtime_error);
+		CPPUNIT_ASSERT_THROW(load_patched(12, 1000000), std::runtime_error);
+	}
+
+	void negative_state_test() {
+		description.transitions.insert(std::make_pair(std::make_pair(-1, 'a'), 2));
+		CPPUNIT_ASSERT_THROW(compiled_automaton{description}, std::invalid_argument);
+	}
+
+	void exits_test() {
+		representation::dft_description loops;
+		for (int c = 0; c < 256; ++c) {
+			loops.transitions.insert(std::make_pair(std::make_pair(1, c), c == '<' ? 2 : 1));
+			loops.transitions.insert(std::make_pair(std::make_pair(2, c), c == '>' ? 1 : 2));
+		}
+		loops.output.insert(std::make_pair(std::make_pair(1, '<'), 5));
+		loops.push.insert(std::make_pair(std::make_pair(2, '"'), 2));
+		loops.start_state = 1;
+		compiled_automaton a(loops);
+		CPPUNIT_ASSERT_EQUAL(1, a.exits(1).count);
+		CPPUNIT_ASSERT_EQUAL((unsigned char)'<', a.exits(1).bytes[0]);
+		CPPUNIT_ASSERT_EQUAL(2, a.exits(2).count);
+		CPPUNIT_ASSERT_EQUAL((unsigned char)'"', a.exits(2).bytes[0]);
+		CPPUNIT_ASSERT_EQUAL((unsigned char)'>', a.exits(2).bytes[1]);
+		// Every byte leaves state 0, which has no transitions
+		CPPUNIT_ASSERT_EQUAL(-1, a.exits(0).count);
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(compiled_automaton_test);
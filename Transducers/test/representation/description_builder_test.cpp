@@ -0,0 +1,109 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "representation/description_builder.h"
+#include "transducers/pushdown/state_map_pushdown_transducer.h"
+#include "transducers/aggregation/symbol_buffer.h"
+#include "transducers/compose.h"
+#include "data_structures/tree_state_map.h"
+
+using representation::description_builder;
+
+class description_builder_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(description_builder_test);
+	CPPUNIT_TEST(description_test);
+	CPPUNIT_TEST(add_transition_test);
+	CPPUNIT_TEST(conflict_test);
+	CPPUNIT_TEST(compile_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	representation::dft_description expected;
+	description_builder builder;
+
+	void setUp() {
+		expected = representation::dft_description{};
+		expected.pop.insert(std::make_pair(std::make_pair(4, 'f'), std::make_pair(1, 1)));
+		expected.pop.insert(std::make_pair(std::make_pair(4, 'f'), std::make_pair(2, 2)));
+		expected.push.insert(std::make_pair(std::make_pair(1, 'b'), 4));
+		expected.push.insert(std::make_pair(std::make_pair(2, 'b'), 2));
+		expected.transitions.insert(std::make_pair(std::make_pair(1, 'a'), 2));
+		expected.transitions.insert(std::make_pair(std::make_pair(1, 'b'), 3));
+		expected.transitions.insert(std::make_pair(std::make_pair(2, 'b'), 3));
+		expected.transitions.insert(std::make_pair(std::make_pair(3, 'c'), 4));
+		expected.transitions.insert(std::make_pair(std::make_pair(2, 'e'), 1));
+		expected.output.insert(std::make_pair(std::make_pair(1,'b'), 1));
+		expected.output.insert(std::make_pair(std::make_pair(2,'b'), 1));
+		expected.output.insert(std::make_pair(std::make_pair(4,'f'), 2));
+		expected.start_state = 1;
+
+		builder = description_builder{};
+		builder.set_start_state(1);
+		builder.add_pop(4, 'f', 2, 2);
+		builder.add_transition(2, 'e', 1);
+		builder.add_transition(3, 'c', 4);
+		builder.add_transition(2, 'b', 3, 2, 1);
+		builder.add_transition(1, 'b', 3, 4, 1);
+		builder.add_pop(4, 'f', 1, 1);
+		builder.add_transition(1, 'a', 2);
+		builder.add_output(4, 'f', 2);
+		builder.add_transition(1, 'a', 2);
+		builder.add_pop(4, 'f', 2, 2);
+	}
+	void tearDown() {}
+
+	void description_test() {
+		auto d = builder.description();
+		CPPUNIT_ASSERT(expected.transitions == d.transitions);
+		CPPUNIT_ASSERT(expected.push == d.push);
+		CPPUNIT_ASSERT(expected.pop == d.pop);
+		CPPUNIT_ASSERT(expected.output == d.output);
+		CPPUNIT_ASSERT_EQUAL(1, d.start_state);
+		CPPUNIT_ASSERT_EQUAL(5, d.num_states);
+	}
+
+	void add_transition_test() {
+		representation::dft_description d;
+		d.add_transition(1, 'a', 2);
+		d.add_transition(1, 'b', 3, 4, 1);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(2), d.transitions.size());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), d.push.size());
+		CPPUNIT_ASSERT_EQUAL(1, d.output.at(std::make_pair(1, 'b')));
+	}
+
+	void conflict_test() {
+		description_builder b1;
+		b1.add_transition(1, 'a', 2);
+		b1.add_transition(1, 'a', 3);
+		CPPUNIT_ASSERT_THROW(b1.description(), std::invalid_argument);
+
+		description_builder b2;
+		b2.add_transition(1, 'a', 2, -1, 5);
+		b2.add_output(1, 'a', 6);
+		CPPUNIT_ASSERT_THROW(b2.compile(), std::invalid_argument);
+	}
+
+	void compile_test() {
+		template_compile_test<data_structures::tree_state_map>();
+		template_compile_test<data_structures::pushdown_state_map>();
+	}
+
+	template <template <typename> class MapType>
+	void template_compile_test() {
+		typedef transducers::aggregation::symbol_buffer<uint32_t> buffer;
+		typedef transducers::pushdown::state_map_pushdown_transducer<buffer, MapType> transducer_type;
+		buffer b;
+		transducer_type t1(b, expected);
+		transducer_type t2(b, builder.compile());
+		auto pr1 = t1.identity_result();
+		auto pr2 = t2.identity_result();
+		CPPUNIT_ASSERT(pr1 == pr2);
+		for (char c: std::string("abfcefbf")) {
+			t1.process_symbol(pr1, c, 0);
+			t2.process_symbol(pr2, c, 0);
+			CPPUNIT_ASSERT(pr1 == pr2);
+		}
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(description_builder_test);
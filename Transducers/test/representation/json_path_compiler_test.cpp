@@ -0,0 +1,121 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "representation/json_path_compiler.h"
+#include "transducers/finite/finite_transducer.h"
+#include "transducers/aggregation/symbol_buffer.h"
+#include "transducers/compose.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using representation::json_path_compiler;
+
+class json_path_compiler_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(json_path_compiler_test);
+	CPPUNIT_TEST(tokenizer_test);
+	CPPUNIT_TEST(syntax_test);
+	CPPUNIT_TEST(automaton_test);
+	CPPUNIT_TEST(group_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp() {}
+	void tearDown() {}
+
+	void tokenizer_test() {
+		json_path_compiler c;
+		c.add("$.a['ab']", 0);
+		auto tok = c.tokenizer();
+		CPPUNIT_ASSERT_EQUAL(std::size_t(2), tok.names().size());
+
+		const std::string doc = "{\"a\": [12, \"{\\\"]\"], \"ab\" :true, \"a\\b\":null}";
+		std::vector<int> expected = {
+			tok.open_object_symbol(),
+			tok.quote_symbol(), tok.string_symbol(0), tok.colon_symbol(),
+			tok.open_array_symbol(), tok.scalar_symbol(), tok.comma_symbol(),
+			tok.quote_symbol(), tok.other_string_symbol(), tok.close_array_symbol(),
+			tok.comma_symbol(),
+			tok.quote_symbol(), tok.string_symbol(1), tok.colon_symbol(), tok.scalar_symbol(),
+			tok.comma_symbol(),
+			tok.quote_symbol(), tok.other_string_symbol(), tok.colon_symbol(), tok.scalar_symbol(),
+			tok.close_object_symbol()
+		};
+		transducers::aggregation::symbol_buffer<int> b;
+		auto trans = transducers::compose<transducers::finite::finite_transducer>(b, tok.description());
+		auto pr = trans.initial_result();
+		for (std::size_t i = 0; i < doc.size(); ++i) {
+			trans.process_symbol(pr, static_cast<unsigned char>(doc[i]), i);
+		}
+		CPPUNIT_ASSERT(expected == trans.last_stage_result(pr));
+	}
+
+	void syntax_test() {
+		json_path_compiler c;
+		CPPUNIT_ASSERT_NO_THROW(c.add("$", 0));
+		CPPUNIT_ASSERT_NO_THROW(c.add("$..a.*[*]['b c'][\"*\"]", 0));
+		CPPUNIT_ASSERT_THROW(c.add("", 0), std::invalid_argument);
+		CPPUNIT_ASSERT_THROW(c.add("a.b", 0), std::invalid_argument);
+		CPPUNIT_ASSERT_THROW(c.add("$.a.", 0), std::invalid_argument);
+		CPPUNIT_ASSERT_THROW(c.add("$a", 0), std::invalid_argument);
+		CPPUNIT_ASSERT_THROW(c.add("$.a[0]", 0), std::invalid_argument);
+		CPPUNIT_ASSERT_THROW(c.add("$.a['b]", 0), std::invalid_argument);
+		CPPUNIT_ASSERT_THROW(c.add("$.a[?(@.b)]", 0), std::invalid_argument);
+		CPPUNIT_ASSERT_THROW(c.add("$.a", -1), std::invalid_argument);
+		CPPUNIT_ASSERT_THROW(c.add("$.a", 0x40000000), std::invalid_argument);
+	}
+
+	void automaton_test() {
+		json_path_compiler c;
+		c.add("$.a", 7);
+		auto tok = c.tokenizer();
+		auto d = c.compile();
+		auto next = [&](int state, int symbol) {
+			return d.transitions.at(std::make_pair(state, symbol));
+		};
+		int root = d.start_state;
+		int object = next(root, tok.open_object_symbol());
+		int ret = d.push.at(std::make_pair(root, tok.open_object_symbol()));
+		int a = next(next(next(object, tok.quote_symbol()), tok.string_symbol(0)), tok.colon_symbol());
+		int other = next(next(next(object, tok.quote_symbol()), tok.other_string_symbol()), tok.colon_symbol());
+
+		const int value = symbols::match::MATCH_FLAGS_START | symbols::match::MATCH_FLAGS_END | 7;
+		CPPUNIT_ASSERT_EQUAL(value, d.output.at(std::make_pair(a, tok.scalar_symbol())));
+		CPPUNIT_ASSERT_EQUAL(value, d.output.at(std::make_pair(a, tok.quote_symbol())));
+		CPPUNIT_ASSERT(d.output.count(std::make_pair(other, tok.scalar_symbol())) == 0);
+		int inner = next(a, tok.open_array_symbol());
+		CPPUNIT_ASSERT_EQUAL(static_cast<int>(symbols::match::MATCH_FLAGS_START | 7),
+			d.output.at(std::make_pair(a, tok.open_array_symbol())));
+		CPPUNIT_ASSERT_EQUAL(static_cast<int>(symbols::match::MATCH_FLAGS_END | 7),
+			d.output.at(std::make_pair(inner, tok.close_array_symbol())));
+
+		// Closing the object returns to the state pushed when it was opened
+		int after = next(a, tok.scalar_symbol());
+		auto pops = d.pop.equal_range(std::make_pair(after, tok.close_object_symbol()));
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), std::size_t(std::distance(pops.first, pops.second)));
+		CPPUNIT_ASSERT(pops.first->second == std::make_pair(ret, ret));
+		CPPUNIT_ASSERT_THROW(c.compile(4), std::length_error);
+	}
+
+	void group_test() {
+		json_path_compiler c;
+		c.add("$..a", 0);
+		c.add("$.a", 1);
+		auto tok = c.tokenizer();
+		CPPUNIT_ASSERT_THROW(c.compile(), std::invalid_argument);
+		json_path_compiler::rule_groups groups;
+		auto d = c.compile(groups);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), groups.size());
+		CPPUNIT_ASSERT_EQUAL(2, groups.begin()->first);
+		CPPUNIT_ASSERT(groups.begin()->second == std::vector<int>({ 0, 1 }));
+		int object = d.transitions.at(std::make_pair(d.start_state, tok.open_object_symbol()));
+		int a = d.transitions.at(std::make_pair(object, tok.quote_symbol()));
+		a = d.transitions.at(std::make_pair(a, tok.string_symbol(0)));
+		a = d.transitions.at(std::make_pair(a, tok.colon_symbol()));
+		CPPUNIT_ASSERT_EQUAL(static_cast<int>(symbols::match::MATCH_FLAGS_START | symbols::match::MATCH_FLAGS_END | 2),
+			d.output.at(std::make_pair(a, tok.scalar_symbol())));
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(json_path_compiler_test);
@@ -0,0 +1,96 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "representation/path_query_compiler.h"
+#include "transducers/finite/finite_transducer.h"
+#include "transducers/aggregation/symbol_buffer.h"
+#include "transducers/compose.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using representation::path_query_compiler;
+
+class path_query_compiler_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(path_query_compiler_test);
+	CPPUNIT_TEST(tokenizer_test);
+	CPPUNIT_TEST(syntax_test);
+	CPPUNIT_TEST(automaton_test);
+	CPPUNIT_TEST(group_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp() {}
+	void tearDown() {}
+
+	void tokenizer_test() {
+		path_query_compiler c;
+		c.add("/a/ab", 0);
+		auto tok = c.tokenizer();
+		CPPUNIT_ASSERT_EQUAL(std::size_t(2), tok.names().size());
+
+		const std::string doc = "<?x <a>?><a><!-- <a> --><ab/><abc x='/>'></abc><![CDATA[<a>]]></a>";
+		std::vector<int> expected = {
+			tok.open_symbol(0),
+			tok.open_symbol(1), tok.self_close_symbol(),
+			tok.other_open_symbol(), tok.close_symbol(),
+			tok.close_symbol()
+		};
+		transducers::aggregation::symbol_buffer<int> b;
+		auto trans = transducers::compose<transducers::finite::finite_transducer>(b, tok.description());
+		auto pr = trans.initial_result();
+		for (std::size_t i = 0; i < doc.size(); ++i) {
+			trans.process_symbol(pr, static_cast<unsigned char>(doc[i]), i);
+		}
+		CPPUNIT_ASSERT(expected == trans.last_stage_result(pr));
+	}
+
+	void syntax_test() {
+		path_query_compiler c;
+		CPPUNIT_ASSERT_THROW(c.add("", 0), std::invalid_argument);
+		CPPUNIT_ASSERT_THROW(c.add("a/b", 0), std::invalid_argument);
+		CPPUNIT_ASSERT_THROW(c.add("/a//", 0), std::invalid_argument);
+		CPPUNIT_ASSERT_THROW(c.add("/a[1]", 0), std::invalid_argument);
+		CPPUNIT_ASSERT_THROW(c.add("/a", -1), std::invalid_argument);
+		CPPUNIT_ASSERT_THROW(c.add("/a", 0x40000000), std::invalid_argument);
+	}
+
+	void automaton_test() {
+		path_query_compiler c;
+		c.add("/a/b", 7);
+		auto tok = c.tokenizer();
+		auto d = c.compile();
+		// Document level, inside a, inside a/b and anywhere else
+		CPPUNIT_ASSERT_EQUAL(4, d.num_states);
+		int a = d.transitions.at(std::make_pair(d.start_state, tok.open_symbol(0)));
+		int b = d.transitions.at(std::make_pair(a, tok.open_symbol(1)));
+		CPPUNIT_ASSERT_EQUAL(a, d.push.at(std::make_pair(a, tok.open_symbol(1))));
+		CPPUNIT_ASSERT_EQUAL(static_cast<int>(symbols::match::MATCH_FLAGS_START | 7),
+			d.output.at(std::make_pair(a, tok.open_symbol(1))));
+		CPPUNIT_ASSERT_EQUAL(static_cast<int>(symbols::match::MATCH_FLAGS_END | 7),
+			d.output.at(std::make_pair(b, tok.close_symbol())));
+		auto pops = d.pop.equal_range(std::make_pair(b, tok.close_symbol()));
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), std::size_t(std::distance(pops.first, pops.second)));
+		CPPUNIT_ASSERT(pops.first->second == std::make_pair(a, a));
+		CPPUNIT_ASSERT_THROW(c.compile(2), std::length_error);
+	}
+
+	void group_test() {
+		path_query_compiler c;
+		c.add("//c", 0);
+		c.add("/a/c", 1);
+		auto tok = c.tokenizer();
+		CPPUNIT_ASSERT_THROW(c.compile(), std::invalid_argument);
+		path_query_compiler::rule_groups groups;
+		auto d = c.compile(groups);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), groups.size());
+		CPPUNIT_ASSERT_EQUAL(2, groups.begin()->first);
+		CPPUNIT_ASSERT(groups.begin()->second == std::vector<int>({ 0, 1 }));
+		int a = d.transitions.at(std::make_pair(d.start_state, tok.open_symbol(1)));
+		CPPUNIT_ASSERT_EQUAL(static_cast<int>(symbols::match::MATCH_FLAGS_START | 2),
+			d.output.at(std::make_pair(a, tok.open_symbol(0))));
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(path_query_compiler_test);
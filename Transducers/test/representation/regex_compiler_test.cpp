@@ -0,0 +1,132 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "representation/regex_compiler.h"
+#include "transducers/finite/finite_transducer.h"
+#include "transducers/finite/lazy_dfa_transducer.h"
+#include "transducers/finite/bit_parallel_transducer.h"
+#include "transducers/aggregation/symbol_buffer.h"
+#include "transducers/compose.h"
+
+#include <algorithm>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using representation::regex_compiler;
+
+class regex_compiler_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(regex_compiler_test);
+	CPPUNIT_TEST(dft_test);
+	CPPUNIT_TEST(nfa_test);
+	CPPUNIT_TEST(syntax_test);
+	CPPUNIT_TEST(backspace_test);
+	CPPUNIT_TEST(state_limit_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	typedef transducers::aggregation::symbol_buffer<int> buffer;
+	const std::vector<std::pair<std::string, int>> patterns = {
+		{ "ab", 1 },
+		{ "b+c", 2 },
+		{ "[0-9]{2,3}", 3 },
+		{ "x(y|z)*w", 4 },
+		{ "\\d\\.[^a-c\\s]?", 5 },
+		{ "(?:ab)?c", 6 },
+	};
+	const std::string input = "abbbc 1234 xyzzyw 7.d abc 9.a xw c";
+	regex_compiler compiler;
+
+	void setUp() {
+		compiler = regex_compiler();
+		for (const auto& p: patterns) {
+			compiler.add(p.first, p.second);
+		}
+	}
+	void tearDown() {}
+
+	// The rules with a match ending at each offset
+	std::vector<std::vector<int>> brute_force() {
+		std::vector<std::vector<int>> ret(input.size());
+		for (const auto& p: patterns) {
+			std::regex re(p.first);
+			for (std::size_t end = 0; end < input.size(); ++end) {
+				for (std::size_t begin = 0; begin <= end; ++begin) {
+					if (std::regex_match(input.begin() + begin, input.begin() + end + 1, re)) {
+						ret[end].push_back(p.second);
+						break;
+					}
+				}
+			}
+		}
+		return ret;
+	}
+
+	template <typename Transducer>
+	std::vector<int> run(const Transducer& trans) {
+		auto pr = trans.initial_result();
+		for (std::size_t i = 0; i < input.size(); ++i) {
+			trans.process_symbol(pr, static_cast<unsigned char>(input[i]), i);
+		}
+		return trans.last_stage_result(pr);
+	}
+
+	void dft_test() {
+		std::vector<int> expected;
+		for (auto& rules: brute_force()) {
+			if (!rules.empty()) expected.push_back(*std::min_element(rules.begin(), rules.end()));
+		}
+		buffer b;
+		auto trans = transducers::compose<transducers::finite::finite_transducer>(b, compiler.compile());
+		CPPUNIT_ASSERT(expected == run(trans));
+	}
+
+	void nfa_test() {
+		std::vector<int> expected;
+		for (auto& rules: brute_force()) {
+			std::sort(rules.begin(), rules.end());
+			expected.insert(expected.end(), rules.begin(), rules.end());
+		}
+		auto nfa = compiler.compile_nfa();
+		buffer b;
+		auto lazy = transducers::compose<transducers::finite::lazy_dfa_transducer>(b, nfa);
+		CPPUNIT_ASSERT(expected == run(lazy));
+		auto parallel = transducers::compose<transducers::finite::bit_parallel_transducer_64>(b, nfa);
+		CPPUNIT_ASSERT(expected == run(parallel));
+	}
+
+	void syntax_test() {
+		regex_compiler c;
+		CPPUNIT_ASSERT_THROW(c.add("a(b", 1), std::invalid_argument);
+		CPPUNIT_ASSERT_THROW(c.add("a)", 1), std::invalid_argument);
+		CPPUNIT_ASSERT_THROW(c.add("*a", 1), std::invalid_argument);
+		CPPUNIT_ASSERT_THROW(c.add("[a-", 1), std::invalid_argument);
+		CPPUNIT_ASSERT_THROW(c.add("a{3,2}", 1), std::invalid_argument);
+		CPPUNIT_ASSERT_THROW(c.add("^a", 1), std::invalid_argument);
+		CPPUNIT_ASSERT_THROW(c.add("(a)\\1", 1), std::invalid_argument);
+		CPPUNIT_ASSERT_THROW(c.add("a", -1), std::invalid_argument);
+	}
+
+	void backspace_test() {
+		regex_compiler c;
+		c.add("[\\b]", 7);
+		buffer b;
+		auto trans = transducers::compose<transducers::finite::finite_transducer>(b, c.compile());
+		const std::string text = "ab\bb";
+		auto pr = trans.initial_result();
+		for (std::size_t i = 0; i < text.size(); ++i) trans.process_symbol(pr, text[i], i);
+		CPPUNIT_ASSERT(std::vector<int>{ 7 } == trans.last_stage_result(pr));
+		CPPUNIT_ASSERT_THROW(regex_compiler().add("a\\b", 1), std::invalid_argument);
+	}
+
+	void state_limit_test() {
+		// Remembering the last 8 symbols needs 2^8 states
+		regex_compiler c;
+		c.add("a[ab]{7}", 1);
+		CPPUNIT_ASSERT_THROW(c.compile(64), std::length_error);
+		CPPUNIT_ASSERT(c.compile(1024).num_states >= 256);
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(regex_compiler_test);
@@ -0,0 +1,85 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <transducers/aggregation/column_buffer.h>
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using transducers::aggregation::column_buffer;
+using data_structures::match_columns_file;
+using symbols::match;
+
+class column_buffer_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(column_buffer_test);
+	CPPUNIT_TEST(column_test);
+	CPPUNIT_TEST(save_load_test);
+	CPPUNIT_TEST(bad_file_test);
+	CPPUNIT_TEST(wide_rule_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	const std::string filename = "column_buffer_test.bin";
+
+	void setUp() {}
+	void tearDown() {
+		std::remove(filename.c_str());
+	}
+
+	void column_test() {
+		column_buffer buffer;
+		auto f1 = buffer.initial_result();
+		auto f2 = buffer.identity_result();
+		buffer.process_symbol(f1, match(1, 0, 5), 5);
+		buffer.process_symbol(f2, match(2, 6, match::npos), 6);
+		buffer.merge_results(f1, f2);
+		CPPUNIT_ASSERT(f1.rules() == std::vector<uint32_t>({ 1, 2 }));
+		CPPUNIT_ASSERT(f1.starts() == std::vector<uint64_t>({ 0, 6 }));
+		CPPUNIT_ASSERT(f1[1] == match(2, 6, match::npos));
+	}
+
+	void save_load_test() {
+		column_buffer buffer;
+		auto f1 = buffer.initial_result();
+		for (std::size_t i = 0; i < 1000; ++i) {
+			buffer.process_symbol(f1, match(i % 5, i * 3, i * 3 + 2), i * 3 + 2);
+		}
+		f1.save(filename);
+		match_columns_file file(filename);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1000), file.size());
+		CPPUNIT_ASSERT(file[999] == f1[999]);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(0), reinterpret_cast<std::size_t>(file.starts()) % 64);
+		CPPUNIT_ASSERT(std::vector<uint64_t>(file.ends(), file.ends() + 1000) == f1.ends());
+
+		buffer.initial_result().save(filename);
+		CPPUNIT_ASSERT(match_columns_file(filename).empty());
+	}
+
+	void bad_file_test() {
+		CPPUNIT_ASSERT_THROW(match_columns_file("no_such_columns.bin"), std::runtime_error);
+		std::ofstream out(filename);
+		out << std::string(100, 'x');
+		out.close();
+		CPPUNIT_ASSERT_THROW(match_columns_file{filename}, std::runtime_error);
+
+		column_buffer buffer;
+		auto f1 = buffer.initial_result();
+		buffer.process_symbol(f1, match(1, 2, 3), 3);
+		f1.save(filename);
+		::truncate(filename.c_str(), 100);
+		CPPUNIT_ASSERT_THROW(match_columns_file{filename}, std::runtime_error);
+	}
+
+	void wide_rule_test() {
+		column_buffer buffer;
+		auto f1 = buffer.initial_result();
+		buffer.process_symbol(f1, match(0xffffffff, 0, 1), 1);
+		CPPUNIT_ASSERT_THROW(buffer.process_symbol(f1, match(std::size_t(1) << 32, 2, 3), 3),
+			std::out_of_range);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), f1.size());
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(column_buffer_test);
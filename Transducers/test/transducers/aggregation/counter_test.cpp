@@ -0,0 +1,43 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <transducers/aggregation/counter.h>
+#include <transducers/numeric/multiply.h>
+#include <transducers/compose.h>
+#include <transducers/parallel.h>
+
+#include <vector>
+
+using transducers::aggregation::counter;
+
+class counter_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(counter_test);
+	CPPUNIT_TEST(count_test);
+	CPPUNIT_TEST(parallel_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp() {}
+	void tearDown() {}
+
+	void count_test() {
+		counter<int> c;
+		auto f1 = c.initial_result();
+		auto f2 = c.identity_result();
+		c.process_symbol(f1, 1, 0);
+		c.process_symbol(f2, 2, 1);
+		c.process_symbol(f2, 3, 2);
+		c.merge_results(f1, f2);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(3), c.last_stage_result(f1));
+		CPPUNIT_ASSERT_EQUAL(sizeof(std::size_t), c.memory_usage(f1));
+	}
+
+	void parallel_test() {
+		std::vector<int> input(1000, 7);
+		counter<int> c;
+		auto trans = transducers::compose<transducers::numeric::multiply_int>(c, 2);
+		auto pr = transducers::run_parallel(trans, input.begin(), input.end(), 7);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1000), trans.last_stage_result(pr));
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(counter_test);
@@ -0,0 +1,49 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <transducers/aggregation/grouped.h>
+#include <transducers/aggregation/counter.h>
+#include <transducers/aggregation/min_max.h>
+#include <transducers/parallel.h>
+
+#include <vector>
+
+using transducers::aggregation::grouped;
+
+class grouped_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(grouped_test);
+	CPPUNIT_TEST(count_test);
+	CPPUNIT_TEST(longest_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp() {}
+	void tearDown() {}
+
+	void count_test() {
+		grouped<transducers::aggregation::counter<symbols::match>> g;
+		auto f1 = g.initial_result();
+		auto f2 = g.identity_result();
+		g.process_symbol(f1, symbols::match(0, 0, 1), 1);
+		g.process_symbol(f2, symbols::match(3, 2, 3), 3);
+		g.process_symbol(f2, symbols::match(0, 4, 5), 5);
+		g.merge_results(f1, f2);
+		CPPUNIT_ASSERT(f1 == std::vector<std::size_t>({ 2, 0, 0, 1 }));
+	}
+
+	void longest_test() {
+		std::vector<symbols::match> input;
+		for (std::size_t i = 0; i < 100; ++i) {
+			input.emplace_back(i % 3, i * 10, i * 10 + i);
+		}
+		grouped<transducers::aggregation::min_max<symbols::match,
+			transducers::aggregation::match_length>> g;
+		auto pr = transducers::run_parallel(g, input.begin(), input.end(), 6);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(3), pr.size());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(34), pr[0].count);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(100), pr[0].max);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(98), pr[1].max);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(3), pr[2].min);
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(grouped_test);
@@ -0,0 +1,47 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <transducers/aggregation/histogram.h>
+
+#include <stdexcept>
+#include <vector>
+
+using transducers::aggregation::histogram;
+
+class histogram_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(histogram_test);
+	CPPUNIT_TEST(bucket_test);
+	CPPUNIT_TEST(rule_test);
+	CPPUNIT_TEST(invalid_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp() {}
+	void tearDown() {}
+
+	// The last bucket also counts everything beyond it
+	void bucket_test() {
+		histogram<int> h(3, 10);
+		auto f1 = h.initial_result();
+		auto f2 = h.identity_result();
+		for (int v: { 0, 9, 10 }) h.process_symbol(f1, v, 0);
+		for (int v: { 25, 100 }) h.process_symbol(f2, v, 0);
+		h.merge_results(f1, f2);
+		CPPUNIT_ASSERT(f1 == std::vector<std::size_t>({ 2, 1, 2 }));
+	}
+
+	void rule_test() {
+		histogram<symbols::match, transducers::aggregation::match_rule> h(2);
+		auto f1 = h.initial_result();
+		h.process_symbol(f1, symbols::match(1, 0, 1), 1);
+		h.process_symbol(f1, symbols::match(1, 2, 3), 3);
+		h.process_symbol(f1, symbols::match(0, 0, 3), 3);
+		CPPUNIT_ASSERT(f1 == std::vector<std::size_t>({ 1, 2 }));
+	}
+
+	void invalid_test() {
+		CPPUNIT_ASSERT_THROW(histogram<int>(0), std::invalid_argument);
+		CPPUNIT_ASSERT_THROW(histogram<int>(4, 0), std::invalid_argument);
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(histogram_test);
@@ -0,0 +1,68 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <transducers/aggregation/match_buffer.h>
+
+#include <vector>
+
+using transducers::aggregation::match_buffer;
+using symbols::match;
+
+class match_buffer_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(match_buffer_test);
+	CPPUNIT_TEST(encode_test);
+	CPPUNIT_TEST(merge_test);
+	CPPUNIT_TEST(memory_usage_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp() {}
+	void tearDown() {}
+
+	// Starts before the segment base, open ends, offsets beyond 4GB and
+	// rules wider than 32 bits
+	void encode_test() {
+		const std::size_t far = std::size_t(3) << 32;
+		std::vector<match> input = {
+			match(1, 10, 20), match(2, 0, 30), match(3, 25, match::npos),
+			match(4, match::npos, 40), match(5, far, far + 5), match(6, 2, far + 9),
+			match(0x3fffffff, far + 100, far + 200), match(far, far + 201, far + 202)
+		};
+		match_buffer buffer;
+		auto f1 = buffer.initial_result();
+		for (const auto& m: input) buffer.process_symbol(f1, m, m.end_offset);
+		CPPUNIT_ASSERT(f1.matches() == input);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(5), f1.num_segments());
+		CPPUNIT_ASSERT(f1[5] == input[5]);
+		CPPUNIT_ASSERT(f1[7] == input[7]);
+	}
+
+	// The first segment of the right hand list joins the last one of the
+	// left hand list when its deltas fit
+	void merge_test() {
+		match_buffer buffer;
+		auto f1 = buffer.initial_result();
+		auto f2 = buffer.identity_result();
+		auto f3 = buffer.identity_result();
+		buffer.process_symbol(f1, match(0, 5, 9), 9);
+		buffer.process_symbol(f2, match(1, 1, 100), 100);
+		buffer.process_symbol(f3, match(2, std::size_t(1) << 40, (std::size_t(1) << 40) + 1), 0);
+		buffer.merge_results(f1, f2);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), f1.num_segments());
+		buffer.merge_results(f1, f3);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(2), f1.num_segments());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(3), f1.size());
+		CPPUNIT_ASSERT(f1[1] == match(1, 1, 100));
+		CPPUNIT_ASSERT(f1[2] == f3[0]);
+	}
+
+	void memory_usage_test() {
+		match_buffer buffer;
+		auto f1 = buffer.initial_result();
+		for (std::size_t i = 0; i < 1000; ++i) {
+			buffer.process_symbol(f1, match(i % 7, i * 10, i * 10 + 3), i * 10 + 3);
+		}
+		CPPUNIT_ASSERT(buffer.memory_usage(f1) < 1000 * sizeof(match) * 3 / 4);
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(match_buffer_test);
@@ -0,0 +1,44 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <transducers/aggregation/min_max.h>
+
+using transducers::aggregation::min_max;
+
+class min_max_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(min_max_test);
+	CPPUNIT_TEST(value_test);
+	CPPUNIT_TEST(empty_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp() {}
+	void tearDown() {}
+
+	void value_test() {
+		min_max<int> m;
+		auto f1 = m.initial_result();
+		auto f2 = m.identity_result();
+		for (int v: { 5, 3, 8 }) m.process_symbol(f1, v, 0);
+		for (int v: { 9, -2 }) m.process_symbol(f2, v, 0);
+		m.merge_results(f1, f2);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(5), f1.count);
+		CPPUNIT_ASSERT_EQUAL(-2, f1.min);
+		CPPUNIT_ASSERT_EQUAL(9, f1.max);
+	}
+
+	// The longest match, with empty results on either side of a merge
+	void empty_test() {
+		min_max<symbols::match, transducers::aggregation::match_length> m;
+		auto f1 = m.initial_result();
+		auto f2 = m.identity_result();
+		m.process_symbol(f2, symbols::match(0, 4, 9), 9);
+		m.process_symbol(f2, symbols::match(0, 20, 21), 21);
+		m.merge_results(f1, f2);
+		m.merge_results(f1, m.identity_result());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(2), f1.count);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(2), f1.min);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(6), f1.max);
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(min_max_test);
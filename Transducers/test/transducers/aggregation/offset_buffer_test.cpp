@@ -0,0 +1,63 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <transducers/aggregation/offset_buffer.h>
+
+#include <vector>
+
+using transducers::aggregation::offset_buffer;
+
+class offset_buffer_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(offset_buffer_test);
+	CPPUNIT_TEST(merge_test);
+	CPPUNIT_TEST(segment_test);
+	CPPUNIT_TEST(memory_usage_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp() {}
+	void tearDown() {}
+
+	void merge_test() {
+		offset_buffer buffer;
+		auto f1 = buffer.initial_result();
+		auto f2 = buffer.identity_result();
+		auto f3 = buffer.identity_result();
+		buffer.process_symbol(f1, 3, 3);
+		buffer.process_symbol(f2, 10, 10);
+		buffer.process_symbol(f2, 12, 12);
+		buffer.merge_results(f1, f3);
+		buffer.merge_results(f1, f2);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(3), f1.size());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), f1.num_segments());
+		CPPUNIT_ASSERT(std::vector<std::size_t>({ 3, 10, 12 }) == f1.offsets());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(12), f1[2]);
+	}
+
+	// Offsets more than 4GB apart need a new segment, and one block whose
+	// offsets do not fit the last segment of another is kept as it is
+	void segment_test() {
+		const std::size_t far = std::size_t(1) << 33;
+		offset_buffer buffer;
+		auto f1 = buffer.initial_result();
+		auto f2 = buffer.identity_result();
+		buffer.process_symbol(f1, 1, 1);
+		buffer.process_symbol(f1, far, far);
+		buffer.process_symbol(f2, far + 5, far + 5);
+		buffer.process_symbol(f2, 2 * far, 2 * far);
+		buffer.merge_results(f1, f2);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(3), f1.num_segments());
+		CPPUNIT_ASSERT(std::vector<std::size_t>({ 1, far, far + 5, 2 * far }) == f1.offsets());
+		CPPUNIT_ASSERT_EQUAL(far + 5, f1[2]);
+		CPPUNIT_ASSERT_EQUAL(2 * far, f1.back());
+	}
+
+	void memory_usage_test() {
+		offset_buffer buffer;
+		auto f1 = buffer.initial_result();
+		CPPUNIT_ASSERT_EQUAL(sizeof(f1), buffer.memory_usage(f1));
+		for (std::size_t i = 0; i < 100; ++i) buffer.process_symbol(f1, i, i);
+		CPPUNIT_ASSERT(buffer.memory_usage(f1) < sizeof(f1) + 100 * sizeof(std::size_t));
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(offset_buffer_test);
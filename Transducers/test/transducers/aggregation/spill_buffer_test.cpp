@@ -0,0 +1,108 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <transducers/aggregation/spill_buffer.h>
+#include <transducers/util/delimiter_index.h>
+#include <transducers/compose.h>
+#include <transducers/parallel.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using transducers::aggregation::spill_buffer;
+
+class spill_buffer_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(spill_buffer_test);
+	CPPUNIT_TEST(spill_test);
+	CPPUNIT_TEST(merge_test);
+	CPPUNIT_TEST(parallel_test);
+	CPPUNIT_TEST(file_count_test);
+	CPPUNIT_TEST(bad_directory_test);
+	CPPUNIT_TEST(parallel_error_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp() {}
+	void tearDown() {}
+
+	void spill_test() {
+		spill_buffer<int> buffer(64);
+		auto f1 = buffer.initial_result();
+		for (int i = 0; i < 10000; ++i) {
+			buffer.process_symbol(f1, i, i);
+		}
+		CPPUNIT_ASSERT_EQUAL(std::size_t(10000), f1.size());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), f1.num_files());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), f1.num_segments());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(0), f1.tail_bytes());
+
+		int expected = 0;
+		f1.for_each([&](int s) { CPPUNIT_ASSERT_EQUAL(expected++, s); });
+		CPPUNIT_ASSERT_EQUAL(10000, expected);
+	}
+
+	// Merging shares files and keeps the order of spilled and held symbols
+	void merge_test() {
+		spill_buffer<int> buffer(400);
+		std::vector<data_structures::spill_list<int>> blocks;
+		std::vector<int> expected;
+		for (int b = 0; b < 6; ++b) {
+			blocks.push_back(b == 0 ? buffer.initial_result() : buffer.identity_result());
+			for (int i = 0; i < b * 40; ++i) {
+				buffer.process_symbol(blocks.back(), expected.size(), 0);
+				expected.push_back(expected.size());
+			}
+		}
+		for (int b = 1; b < 6; ++b) {
+			buffer.merge_results(blocks[0], blocks[b]);
+		}
+		CPPUNIT_ASSERT(blocks[0].values() == expected);
+		CPPUNIT_ASSERT(blocks[0].num_files() >= 3);
+		CPPUNIT_ASSERT(blocks[0].num_files() <= 6);
+		CPPUNIT_ASSERT(blocks[0].memory_bytes() < 400);
+		CPPUNIT_ASSERT(buffer.memory_usage(blocks[0]) < 1000);
+	}
+
+	void parallel_test() {
+		std::string input;
+		std::vector<std::size_t> expected;
+		for (int i = 0; i < 2000; ++i) {
+			input += std::string(i % 5, 'x');
+			expected.push_back(input.size());
+			input += '\n';
+		}
+		spill_buffer<std::size_t> buffer(1024);
+		auto index = transducers::compose<transducers::util::delimiter_index>(buffer);
+		auto pr = transducers::run_parallel(index, input.begin(), input.end(), 4);
+		CPPUNIT_ASSERT(index.last_stage_result(pr).values() == expected);
+		CPPUNIT_ASSERT(index.last_stage_result(pr).num_files() > 0);
+	}
+
+	// Every block spills to a file of its own however often it spills
+	void file_count_test() {
+		std::vector<int> input(1 << 20);
+		for (std::size_t i = 0; i < input.size(); ++i) input[i] = i;
+		spill_buffer<int> buffer(4096);
+		auto pr = transducers::run_parallel(buffer, input.begin(), input.end(), 4);
+		CPPUNIT_ASSERT(pr.num_files() <= 4);
+		CPPUNIT_ASSERT(pr.num_segments() <= 8);
+		CPPUNIT_ASSERT(pr.values() == input);
+	}
+
+	void bad_directory_test() {
+		spill_buffer<int> buffer(4, "/nonexistent/spill");
+		auto f1 = buffer.initial_result();
+		CPPUNIT_ASSERT_THROW(buffer.process_symbol(f1, 1, 0), std::runtime_error);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), f1.size());
+	}
+
+	// Errors on the threads of run_parallel reach the caller
+	void parallel_error_test() {
+		std::vector<int> input(1000, 1);
+		spill_buffer<int> buffer(4, "/nonexistent/spill");
+		CPPUNIT_ASSERT_THROW(transducers::run_parallel(buffer, input.begin(), input.end(), 4),
+			std::runtime_error);
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(spill_buffer_test);
@@ -0,0 +1,85 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <transducers/aggregation/stream_sink.h>
+#include <transducers/aggregation/symbol_buffer.h>
+#include <transducers/util/delimiter_index.h>
+#include <transducers/compose.h>
+#include <transducers/parallel.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using transducers::aggregation::stream_sink;
+
+class stream_sink_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(stream_sink_test);
+	CPPUNIT_TEST(merge_test);
+	CPPUNIT_TEST(ostream_test);
+	CPPUNIT_TEST(windowed_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp() {}
+	void tearDown() {}
+
+	void merge_test() {
+		std::vector<int> out;
+		stream_sink<int> sink([&](int s) { out.push_back(s); });
+		auto f1 = sink.initial_result();
+		auto f2 = sink.identity_result();
+		auto f3 = sink.identity_result();
+		sink.process_symbol(f1, 1, 0);
+		sink.process_symbol(f2, 2, 1);
+		sink.process_symbol(f3, 3, 2);
+		CPPUNIT_ASSERT(out == std::vector<int>({ 1 }));
+
+		sink.merge_results(f2, f3);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(2), f2.pending.size());
+		CPPUNIT_ASSERT(out == std::vector<int>({ 1 }));
+		sink.merge_results(f1, f2);
+		CPPUNIT_ASSERT(out == std::vector<int>({ 1, 2, 3 }));
+		CPPUNIT_ASSERT_EQUAL(std::size_t(3), f1.emitted);
+		CPPUNIT_ASSERT(f1.pending.empty());
+
+		sink.process_symbol(f1, 4, 3);
+		CPPUNIT_ASSERT(out == std::vector<int>({ 1, 2, 3, 4 }));
+	}
+
+	void ostream_test() {
+		std::ostringstream stream;
+		stream_sink<int> sink(stream, ' ');
+		auto f1 = sink.initial_result();
+		auto f2 = sink.identity_result();
+		sink.process_symbol(f2, 7, 1);
+		sink.process_symbol(f1, 5, 0);
+		sink.merge_results(f1, f2);
+		CPPUNIT_ASSERT_EQUAL(std::string("5 7 "), stream.str());
+	}
+
+	// run_windowed streams the same offsets run_parallel collects
+	void windowed_test() {
+		std::string input;
+		for (int i = 0; i < 300; ++i) {
+			input += std::string(i % 13, 'x') + "\n";
+		}
+
+		transducers::aggregation::symbol_buffer<std::size_t> buffer;
+		auto collect = transducers::compose<transducers::util::delimiter_index>(buffer);
+		auto expected = collect.last_stage_result(
+			transducers::run_parallel(collect, input.begin(), input.end(), 4));
+		CPPUNIT_ASSERT_EQUAL(std::size_t(300), expected.size());
+
+		for (std::size_t window: { std::size_t(0), std::size_t(1), std::size_t(100), std::size_t(999) }) {
+			std::vector<std::size_t> out;
+			stream_sink<std::size_t> sink([&](std::size_t s) { out.push_back(s); });
+			auto stream = transducers::compose<transducers::util::delimiter_index>(sink);
+			auto pr = transducers::run_windowed(stream, input.begin(), input.end(), 3, window);
+			CPPUNIT_ASSERT(out == expected);
+			CPPUNIT_ASSERT_EQUAL(expected.size(), pr.second.emitted);
+			CPPUNIT_ASSERT(pr.second.pending.empty());
+		}
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(stream_sink_test);
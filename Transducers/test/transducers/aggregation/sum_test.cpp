@@ -0,0 +1,42 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <transducers/aggregation/sum.h>
+#include <transducers/numeric/multiply.h>
+#include <transducers/compose.h>
+#include <transducers/parallel.h>
+
+#include <vector>
+
+using transducers::aggregation::sum;
+
+class sum_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(sum_test);
+	CPPUNIT_TEST(multiply_test);
+	CPPUNIT_TEST(match_length_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp() {}
+	void tearDown() {}
+
+	void multiply_test() {
+		std::vector<int> input;
+		for (int i = 1; i <= 100; ++i) input.push_back(i);
+		sum<int> s;
+		auto trans = transducers::compose<transducers::numeric::multiply_int>(s, 3);
+		auto pr = transducers::run_parallel(trans, input.begin(), input.end(), 5);
+		CPPUNIT_ASSERT_EQUAL(3 * 5050, trans.last_stage_result(pr));
+	}
+
+	void match_length_test() {
+		sum<symbols::match, transducers::aggregation::match_length> s;
+		auto f1 = s.initial_result();
+		auto f2 = s.identity_result();
+		s.process_symbol(f1, symbols::match(0, 10, 19), 19);
+		s.process_symbol(f2, symbols::match(1, 30, 30), 30);
+		s.merge_results(f1, f2);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(11), f1);
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(sum_test);
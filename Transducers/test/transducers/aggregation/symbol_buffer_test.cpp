@@ -1,12 +1,18 @@
 #include <cppunit/extensions/HelperMacros.h>
 #include <transducers/aggregation/symbol_buffer.h>
 
+#include <vector>
+
 using transducers::aggregation::symbol_buffer;
+using data_structures::chunk_list;
 
 class symbol_buffer_test : public CppUnit::TestFixture {
 public:
 	CPPUNIT_TEST_SUITE(symbol_buffer_test);
 	CPPUNIT_TEST(int_test);
+	CPPUNIT_TEST(memory_usage_test);
+	CPPUNIT_TEST(chunk_list_test);
+	CPPUNIT_TEST(small_chunk_test);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -24,6 +30,64 @@ public:
 		CPPUNIT_ASSERT_EQUAL(1, f1[0]);
 		CPPUNIT_ASSERT_EQUAL(2, f1[1]);
 	};
+
+	void memory_usage_test() {
+		symbol_buffer<int> buffer;
+		auto f1 = buffer.initial_result();
+		CPPUNIT_ASSERT_EQUAL(sizeof(f1), buffer.memory_usage(f1));
+		f1.reserve(10);
+		buffer.process_symbol(f1, 1, 0);
+		CPPUNIT_ASSERT_EQUAL(sizeof(f1) + f1.capacity() * sizeof(int), buffer.memory_usage(f1));
+	}
+
+	// Large results are merged by sharing their segments
+	void chunk_list_test() {
+		symbol_buffer<int, chunk_list<int>> buffer;
+		std::vector<chunk_list<int>> blocks;
+		for (int b = 0; b < 8; ++b) {
+			blocks.push_back(b == 0 ? buffer.initial_result() : buffer.identity_result());
+			for (int i = 0; i < 100; ++i) {
+				buffer.process_symbol(blocks.back(), b * 100 + i, 0);
+			}
+		}
+		for (std::size_t step = 1; step < blocks.size(); step *= 2) {
+			for (std::size_t b = 0; b + step < blocks.size(); b += 2 * step) {
+				buffer.merge_results(blocks[b], blocks[b + step]);
+			}
+		}
+		const auto& result = buffer.last_stage_result(blocks[0]);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(800), result.size());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(8), result.num_segments());
+		std::vector<int> expected;
+		for (int i = 0; i < 800; ++i) expected.push_back(i);
+		CPPUNIT_ASSERT(std::vector<int>(result.begin(), result.end()) == expected);
+		CPPUNIT_ASSERT(result.flatten() == expected);
+
+		// A shared segment is left alone by later writes to either list
+		buffer.process_symbol(blocks[0], 800, 0);
+		buffer.process_symbol(blocks[4], -1, 0);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(9), blocks[0].num_segments());
+		CPPUNIT_ASSERT_EQUAL(800, blocks[0].flatten().back());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(401), blocks[4].size());
+		CPPUNIT_ASSERT(buffer.memory_usage(blocks[0]) > 801 * sizeof(int));
+	}
+
+	// Results below the copy limit are copied, and empty ones vanish
+	void small_chunk_test() {
+		symbol_buffer<int, chunk_list<int>> buffer;
+		auto f1 = buffer.initial_result();
+		CPPUNIT_ASSERT(f1.begin() == f1.end());
+		for (int i = 0; i < 10; ++i) {
+			auto f2 = buffer.identity_result();
+			buffer.process_symbol(f2, i, i);
+			buffer.merge_results(f1, f2);
+			buffer.merge_results(f1, buffer.identity_result());
+		}
+		CPPUNIT_ASSERT_EQUAL(std::size_t(10), f1.size());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), f1.num_segments());
+		int expected = 0;
+		for (int s: f1) CPPUNIT_ASSERT_EQUAL(expected++, s);
+	}
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(symbol_buffer_test);
@@ -0,0 +1,55 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <transducers/aggregation/top_k.h>
+#include <transducers/numeric/multiply.h>
+#include <transducers/compose.h>
+#include <transducers/parallel.h>
+
+#include <vector>
+
+using transducers::aggregation::top_k;
+
+class top_k_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(top_k_test);
+	CPPUNIT_TEST(simple_test);
+	CPPUNIT_TEST(tie_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp() {}
+	void tearDown() {}
+
+	void simple_test() {
+		top_k<int> t(3);
+		auto f1 = t.initial_result();
+		auto f2 = t.identity_result();
+		for (int v: { 4, 1, 7, 3 }) t.process_symbol(f1, v, 0);
+		for (int v: { 6, 2 }) t.process_symbol(f2, v, 0);
+		t.merge_results(f1, f2);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(3), f1.size());
+		CPPUNIT_ASSERT(t.sorted(f1) == std::vector<int>({ 7, 6, 4 }));
+
+		top_k<int> none(0);
+		auto f3 = none.initial_result();
+		none.process_symbol(f3, 1, 0);
+		CPPUNIT_ASSERT(f3.empty());
+	}
+
+	// Equal matches are kept by offset, however the input is split
+	void tie_test() {
+		std::vector<symbols::match> input;
+		for (std::size_t i = 0; i < 200; ++i) {
+			input.emplace_back(i, i * 10, i * 10 + i % 4);
+		}
+		top_k<symbols::match, transducers::aggregation::match_length> t(5);
+		std::vector<std::size_t> expected = { 3, 7, 11, 15, 19 };
+		for (std::size_t blocks: { 1, 3, 8 }) {
+			auto pr = transducers::run_parallel(t, input.begin(), input.end(), blocks);
+			std::vector<std::size_t> rules;
+			for (const auto& m: t.sorted(pr)) rules.push_back(m.rule);
+			CPPUNIT_ASSERT(rules == expected);
+		}
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(top_k_test);
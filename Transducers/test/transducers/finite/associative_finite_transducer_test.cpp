@@ -0,0 +1,102 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "transducers/finite/associative_finite_transducer.h"
+#include "transducers/finite/finite_transducer.h"
+#include "transducers/aggregation/symbol_buffer.h"
+#include "transducers/compose.h"
+
+#include <string>
+#include <vector>
+
+using namespace transducers::finite;
+
+class associative_finite_transducer_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(associative_finite_transducer_test);
+	CPPUNIT_TEST(simple_test);
+	CPPUNIT_TEST(merge_test);
+	CPPUNIT_TEST(three_block_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp() {}
+	void tearDown() {}
+
+	// Reports 1 for an 'x' outside quotes and 2 and 3 for opening and
+	// closing quotes, with '\' escaping the next symbol inside quotes
+	associative_finite_transducer_test() {
+		const std::string alphabet = "xy\"\\";
+		for (char c: alphabet) {
+			add(0, c, 0);
+			add(1, c, 1);
+			add(2, c, 1);
+		}
+		add(0, 'x', 0, 1);
+		add(0, '"', 1, 2);
+		add(1, '"', 0, 3);
+		add(1, '\\', 2);
+		description.start_state = 0;
+
+		auto reference = transducers::compose<finite_transducer>(b, description);
+		auto pr = reference.initial_result();
+		for (std::size_t i = 0; i < input.size(); ++i) {
+			reference.process_symbol(pr, input[i], i);
+		}
+		expected = reference.last_stage_result(pr);
+	}
+
+	void add(int from, char c, int to, int output = -1) {
+		auto key = std::make_pair(from, static_cast<unsigned short>(c));
+		description.transitions[key] = to;
+		if (output != -1) description.output[key] = output;
+	}
+
+	typedef transducers::aggregation::symbol_buffer<int> buffer;
+	buffer b;
+	representation::dft_description description;
+	const std::string input = "x\"x\\\"x\"yx\"\\\\\"x\"\\\\x\\\"\"xx";
+	std::vector<int> expected;
+
+	void simple_test() {
+		auto trans = transducers::compose<associative_finite_transducer>(b, description);
+		auto pr = trans.initial_result();
+		for (std::size_t i = 0; i < input.size(); ++i) {
+			trans.process_symbol(pr, input[i], i);
+		}
+		CPPUNIT_ASSERT_EQUAL(std::size_t(11), expected.size());
+		CPPUNIT_ASSERT(expected == trans.last_stage_result(pr));
+	}
+
+	void merge_test() {
+		auto trans = transducers::compose<associative_finite_transducer>(b, description);
+		for (std::size_t split = 0; split <= input.size(); ++split) {
+			auto pr1 = trans.initial_result();
+			auto pr2 = trans.identity_result();
+			auto pr3 = trans.identity_result();
+			for (std::size_t i = 0; i < input.size(); ++i) {
+				trans.process_symbol(i < split ? pr2 : pr3, input[i], i);
+			}
+			trans.merge_results(pr2, pr3);
+			trans.merge_results(pr1, pr2);
+			CPPUNIT_ASSERT(expected == trans.last_stage_result(pr1));
+		}
+	}
+
+	void three_block_test() {
+		auto trans = transducers::compose<associative_finite_transducer>(b, description);
+		for (std::size_t s1 = 0; s1 <= input.size(); ++s1) {
+			for (std::size_t s2 = s1; s2 <= input.size(); ++s2) {
+				auto pr1 = trans.initial_result();
+				auto pr2 = trans.identity_result();
+				auto pr3 = trans.identity_result();
+				for (std::size_t i = 0; i < input.size(); ++i) {
+					trans.process_symbol(i < s1 ? pr1 : i < s2 ? pr2 : pr3, input[i], i);
+				}
+				trans.merge_results(pr1, pr2);
+				trans.merge_results(pr1, pr3);
+				CPPUNIT_ASSERT(expected == trans.last_stage_result(pr1));
+			}
+		}
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(associative_finite_transducer_test);
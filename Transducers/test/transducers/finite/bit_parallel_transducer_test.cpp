@@ -0,0 +1,122 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "transducers/finite/bit_parallel_transducer.h"
+#include "transducers/aggregation/symbol_buffer.h"
+#include "transducers/compose.h"
+
+#include <string>
+
+using namespace transducers::finite;
+
+class bit_parallel_transducer_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(bit_parallel_transducer_test);
+	CPPUNIT_TEST(simple_test);
+	CPPUNIT_TEST(wide_test);
+	CPPUNIT_TEST(too_many_states_test);
+	CPPUNIT_TEST(merge_test);
+	CPPUNIT_TEST(three_block_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp() {}
+	void tearDown() {}
+
+	// Unanchored matcher for "ab" (rule 1), "b" (rule 2) and "ca*c" (rule 3)
+	bit_parallel_transducer_test() {
+		for (char c = 'a'; c <= 'c'; ++c) {
+			description.transitions.insert(std::make_pair(std::make_pair(0, c), 0));
+		}
+		description.transitions.insert(std::make_pair(std::make_pair(0, 'a'), 1));
+		description.transitions.insert(std::make_pair(std::make_pair(1, 'b'), 2));
+		description.transitions.insert(std::make_pair(std::make_pair(0, 'b'), 3));
+		description.transitions.insert(std::make_pair(std::make_pair(0, 'c'), 4));
+		description.transitions.insert(std::make_pair(std::make_pair(4, 'a'), 4));
+		description.transitions.insert(std::make_pair(std::make_pair(4, 'c'), 5));
+		description.output.insert(std::make_pair(2, 1));
+		description.output.insert(std::make_pair(3, 2));
+		description.output.insert(std::make_pair(5, 3));
+		description.start_state = 0;
+	}
+
+	typedef transducers::aggregation::symbol_buffer<int> buffer;
+	representation::nfa_description description;
+	const std::string input = "abcaacbbcab";
+	const std::vector<int> expected = { 1, 2, 3, 2, 2, 1, 2 };
+
+	void simple_test() {
+		buffer b;
+		auto trans = transducers::compose<bit_parallel_transducer_64>(b, description);
+		auto pr = trans.initial_result();
+		for (std::size_t i = 0; i < input.size(); ++i) {
+			trans.process_symbol(pr, input[i], i);
+		}
+		CPPUNIT_ASSERT(expected == trans.last_stage_result(pr));
+	}
+
+	// A single pattern of 100 'a's followed by 'b' spans two mask words
+	void wide_test() {
+		representation::nfa_description d;
+		d.transitions.insert(std::make_pair(std::make_pair(0, 'a'), 0));
+		d.transitions.insert(std::make_pair(std::make_pair(0, 'b'), 0));
+		for (int i = 0; i < 100; ++i) {
+			d.transitions.insert(std::make_pair(std::make_pair(i, 'a'), i + 1));
+		}
+		d.transitions.insert(std::make_pair(std::make_pair(100, 'b'), 101));
+		d.output.insert(std::make_pair(101, 7));
+		d.start_state = 0;
+
+		buffer b;
+		auto trans = transducers::compose<bit_parallel_transducer_256>(b, d);
+		auto pr = trans.initial_result();
+		std::string text = std::string(99, 'a') + "b" + std::string(101, 'a') + "b";
+		for (std::size_t i = 0; i < text.size(); ++i) {
+			trans.process_symbol(pr, text[i], i);
+		}
+		const auto& result = trans.last_stage_result(pr);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), result.size());
+		CPPUNIT_ASSERT_EQUAL(7, result[0]);
+	}
+
+	void too_many_states_test() {
+		representation::nfa_description d = description;
+		d.transitions.insert(std::make_pair(std::make_pair(5, 'a'), 64));
+		buffer b;
+		CPPUNIT_ASSERT_THROW(transducers::compose<bit_parallel_transducer_64>(b, d), std::length_error);
+	}
+
+	void merge_test() {
+		buffer b;
+		auto trans = transducers::compose<associative_bit_parallel_transducer_64>(b, description);
+		for (std::size_t split = 0; split <= input.size(); ++split) {
+			auto pr1 = trans.initial_result();
+			auto pr2 = trans.identity_result();
+			auto pr3 = trans.identity_result();
+			for (std::size_t i = 0; i < input.size(); ++i) {
+				trans.process_symbol(i < split ? pr2 : pr3, input[i], i);
+			}
+			trans.merge_results(pr2, pr3);
+			trans.merge_results(pr1, pr2);
+			CPPUNIT_ASSERT(expected == trans.last_stage_result(pr1));
+		}
+	}
+
+	void three_block_test() {
+		buffer b;
+		auto trans = transducers::compose<associative_bit_parallel_transducer_64>(b, description);
+		for (std::size_t s1 = 0; s1 <= input.size(); ++s1) {
+			for (std::size_t s2 = s1; s2 <= input.size(); ++s2) {
+				auto pr1 = trans.initial_result();
+				auto pr2 = trans.identity_result();
+				auto pr3 = trans.identity_result();
+				for (std::size_t i = 0; i < input.size(); ++i) {
+					trans.process_symbol(i < s1 ? pr1 : i < s2 ? pr2 : pr3, input[i], i);
+				}
+				trans.merge_results(pr1, pr2);
+				trans.merge_results(pr1, pr3);
+				CPPUNIT_ASSERT(expected == trans.last_stage_result(pr1));
+			}
+		}
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(bit_parallel_transducer_test);
@@ -0,0 +1,126 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "transducers/finite/csv_transducer.h"
+#include "transducers/aggregation/symbol_buffer.h"
+#include "transducers/compose.h"
+#include "transducers/parallel.h"
+#include "util/simd.h"
+
+#include <string>
+#include <vector>
+
+using namespace transducers::finite;
+using symbols::boundary;
+
+class csv_transducer_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(csv_transducer_test);
+	CPPUNIT_TEST(simple_test);
+	CPPUNIT_TEST(prefix_xor_test);
+	CPPUNIT_TEST(block_test);
+	CPPUNIT_TEST(merge_test);
+	CPPUNIT_TEST(parallel_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp() {}
+	void tearDown() {}
+
+	typedef transducers::aggregation::symbol_buffer<boundary> buffer;
+
+	// The boundaries found by following the quotes byte by byte
+	static std::vector<boundary> reference(const std::string& input, char delimiter = ',') {
+		std::vector<boundary> ret;
+		bool quoted = false;
+		for (std::size_t i = 0; i < input.size(); ++i) {
+			if (input[i] == '"') quoted = !quoted;
+			if (!quoted && (input[i] == delimiter || input[i] == '\n')) {
+				ret.emplace_back(i, input[i] == '\n');
+			}
+		}
+		return ret;
+	}
+
+	static std::string document() {
+		std::string ret = "id,name,notes\n";
+		for (int i = 0; i < 40; ++i) {
+			ret += std::to_string(i) + ",\"Name, " + std::to_string(i) + "\",";
+			ret += i % 3 == 0 ? "\"said \"\"hi,\n there\"\"\"\n" : "plain\n";
+		}
+		return ret;
+	}
+
+	void simple_test() {
+		buffer b;
+		auto trans = transducers::compose<csv_transducer>(b, ';');
+		const std::string input = "a;\"b;\n\";c\n\"\"\"\";d";
+		auto pr = trans.initial_result();
+		for (std::size_t i = 0; i < input.size(); ++i) {
+			trans.process_symbol(pr, input[i], i);
+		}
+		std::vector<boundary> expected = {
+			boundary(1), boundary(7), boundary(9, true), boundary(14)
+		};
+		CPPUNIT_ASSERT(expected == trans.last_stage_result(pr));
+		CPPUNIT_ASSERT(reference(input, ';') == trans.last_stage_result(pr));
+	}
+
+	void prefix_xor_test() {
+		for (uint64_t m: { uint64_t(0), uint64_t(1), uint64_t(0x8000000000000001ull),
+				uint64_t(0x0123456789abcdefull), ~uint64_t(0) }) {
+			uint64_t expected = 0;
+			bool parity = false;
+			for (int i = 0; i < 64; ++i) {
+				parity = parity != ((m >> i) & 1);
+				expected |= uint64_t(parity) << i;
+			}
+			CPPUNIT_ASSERT_EQUAL(expected, util::prefix_xor(m));
+		}
+	}
+
+	void block_test() {
+		buffer b;
+		auto trans = transducers::compose<csv_transducer>(b);
+		const std::string input = document();
+		const auto* data = reinterpret_cast<const unsigned char*>(input.data());
+		auto pr = trans.initial_result();
+		trans.process_block(pr, data, data + input.size(), 0);
+		CPPUNIT_ASSERT(reference(input) == trans.last_stage_result(pr));
+	}
+
+	void merge_test() {
+		buffer b;
+		auto trans = transducers::compose<csv_transducer>(b);
+		const std::string input = document();
+		const auto* data = reinterpret_cast<const unsigned char*>(input.data());
+		const auto expected = reference(input);
+		for (std::size_t s1 = 0; s1 <= input.size(); s1 += 7) {
+			for (std::size_t s2 = s1; s2 <= input.size(); s2 += 61) {
+				auto pr1 = trans.initial_result();
+				auto pr2 = trans.identity_result();
+				auto pr3 = trans.identity_result();
+				trans.process_block(pr1, data, data + s1, 0);
+				trans.process_block(pr2, data + s1, data + s2, s1);
+				trans.process_block(pr3, data + s2, data + input.size(), s2);
+				trans.merge_results(pr2, pr3);
+				trans.merge_results(pr1, pr2);
+				CPPUNIT_ASSERT(expected == trans.last_stage_result(pr1));
+			}
+		}
+	}
+
+	void parallel_test() {
+		buffer b;
+		auto trans = transducers::compose<csv_transducer>(b);
+		const std::string input = document();
+		const auto expected = reference(input);
+		for (std::size_t blocks = 1; blocks <= 32; ++blocks) {
+			auto pr = transducers::run_parallel(trans, input.begin(), input.end(), blocks);
+			CPPUNIT_ASSERT(expected == trans.last_stage_result(pr));
+			const auto* data = reinterpret_cast<const unsigned char*>(input.data());
+			pr = transducers::run_parallel(trans, data, data + input.size(), blocks);
+			CPPUNIT_ASSERT(expected == trans.last_stage_result(pr));
+		}
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(csv_transducer_test);
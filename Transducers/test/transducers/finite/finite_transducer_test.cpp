@@ -2,12 +2,18 @@
 #include "transducers/finite/finite_transducer.h"
 #include "transducers/aggregation/symbol_buffer.h"
 #include "transducers/compose.h"
+#include "transducers/process_block.h"
+#include "representation/xml_tokenizer.h"
+
+#include <string>
 
 class finite_transducer_test : public CppUnit::TestFixture {
 public:
 	CPPUNIT_TEST_SUITE(finite_transducer_test);
 	CPPUNIT_TEST(simple_test);
 	CPPUNIT_TEST(merge_test);
+	CPPUNIT_TEST(block_test);
+	CPPUNIT_TEST(interleaved_test);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -51,12 +57,81 @@ public:
 		trans.process_symbol(pr2, 'c', 5);
 
 		trans.merge_results(pr1, pr2);
+		CPPUNIT_ASSERT_EQUAL(pr2.first, pr1.first);
 
 		const auto& result = trans.last_stage_result(pr1);
 		CPPUNIT_ASSERT_EQUAL((size_t)2, result.size());
 		CPPUNIT_ASSERT_EQUAL(20, result.at(0));
 		CPPUNIT_ASSERT_EQUAL(20, result.at(1));
 	}
+
+	// process_block skips the bytes of comments, text and attribute values
+	// but must output the same as process_symbol
+	void block_test() {
+		std::string text = "<?xml version=\"1.0\"?><root>";
+		for (int i = 0; i < 40; ++i) {
+			text += "<item id=\"" + std::to_string(i) + " with a long attribute value\">";
+			text += std::string(i * 7, 'x') + "<!-- a comment that runs for a while -->";
+			text += "</item>";
+		}
+		text += "</root>";
+		const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
+		auto dft = representation::xml_tokenizer({ "item" }).description();
+
+		buffer b1;
+		auto bytes = transducers::compose<transducers::finite::finite_transducer>(b1, dft);
+		auto pr1 = bytes.initial_result();
+		for (std::size_t i = 0; i < text.size(); ++i) {
+			bytes.process_symbol(pr1, data[i], i);
+		}
+
+		for (std::size_t split: { std::size_t(1), std::size_t(63), text.size() / 2, text.size() }) {
+			buffer b2;
+			auto blocks = transducers::compose<transducers::finite::finite_transducer>(b2, dft);
+			auto pr2 = blocks.initial_result();
+			blocks.process_block(pr2, data, data + split, 0);
+			blocks.process_block(pr2, data + split, data + text.size(), split);
+			CPPUNIT_ASSERT_EQUAL(pr1.first, pr2.first);
+			CPPUNIT_ASSERT(bytes.last_stage_result(pr1) == blocks.last_stage_result(pr2));
+		}
+	}
+
+	// Chunks starting inside the long comments are guessed wrong and rerun
+	void interleaved_test() {
+		std::string text = "<root>";
+		for (int i = 0; i < 60; ++i) {
+			text += "<item>" + std::string(i * 5, 'x') + "<!--";
+			for (int j = 0; j < i % 3 * 20; ++j) text += "<item/>";
+			text += "--></item>";
+		}
+		text += "</root>";
+		const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
+		auto dft = representation::xml_tokenizer({ "item" }).description();
+
+		buffer b1;
+		auto bytes = transducers::compose<transducers::finite::finite_transducer>(b1, dft);
+		auto pr1 = bytes.initial_result();
+		for (std::size_t i = 0; i < text.size(); ++i) {
+			bytes.process_symbol(pr1, data[i], i);
+		}
+
+		for (std::size_t streams = 0; streams <= 9; ++streams) {
+			buffer b2;
+			auto chunks = transducers::compose<transducers::finite::finite_transducer>(b2, dft);
+			auto pr2 = chunks.initial_result();
+			chunks.process_interleaved(pr2, data, data + text.size(), 0, streams);
+			CPPUNIT_ASSERT_EQUAL(pr1.first, pr2.first);
+			CPPUNIT_ASSERT(bytes.last_stage_result(pr1) == chunks.last_stage_result(pr2));
+
+			// The same through process_block() with the streams set
+			buffer b3;
+			auto blocks = transducers::compose<transducers::finite::finite_transducer>(b3, dft);
+			blocks.set_streams(streams);
+			auto pr3 = blocks.initial_result();
+			transducers::process_block(blocks, pr3, data, data + text.size(), 0);
+			CPPUNIT_ASSERT(bytes.last_stage_result(pr1) == blocks.last_stage_result(pr3));
+		}
+	}
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(finite_transducer_test);
@@ -0,0 +1,91 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "transducers/finite/lazy_dfa_transducer.h"
+#include "transducers/aggregation/symbol_buffer.h"
+#include "transducers/compose.h"
+
+#include <string>
+#include <thread>
+
+class lazy_dfa_transducer_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(lazy_dfa_transducer_test);
+	CPPUNIT_TEST(simple_test);
+	CPPUNIT_TEST(eviction_test);
+	CPPUNIT_TEST(thread_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp() {}
+	void tearDown() {}
+
+	// Unanchored matcher for "ab" (rule 1), "b" (rule 2) and "ca*c" (rule 3)
+	lazy_dfa_transducer_test() {
+		for (char c = 'a'; c <= 'c'; ++c) {
+			description.transitions.insert(std::make_pair(std::make_pair(0, c), 0));
+		}
+		description.transitions.insert(std::make_pair(std::make_pair(0, 'a'), 1));
+		description.transitions.insert(std::make_pair(std::make_pair(1, 'b'), 2));
+		description.transitions.insert(std::make_pair(std::make_pair(0, 'b'), 3));
+		description.transitions.insert(std::make_pair(std::make_pair(0, 'c'), 4));
+		description.transitions.insert(std::make_pair(std::make_pair(4, 'a'), 4));
+		description.transitions.insert(std::make_pair(std::make_pair(4, 'c'), 5));
+		description.output.insert(std::make_pair(2, 1));
+		description.output.insert(std::make_pair(3, 2));
+		description.output.insert(std::make_pair(5, 3));
+		description.start_state = 0;
+	}
+
+	typedef transducers::aggregation::symbol_buffer<int> buffer;
+	representation::nfa_description description;
+	const std::string input = "abcaacbbcab";
+	const std::vector<int> expected = { 1, 2, 3, 2, 2, 1, 2 };
+
+	template <typename Transducer>
+	std::vector<int> run(const Transducer& trans) {
+		auto pr = trans.initial_result();
+		for (std::size_t i = 0; i < input.size(); ++i) {
+			trans.process_symbol(pr, input[i], i);
+		}
+		return trans.last_stage_result(pr);
+	}
+
+	void simple_test() {
+		buffer b;
+		auto trans = transducers::compose<transducers::finite::lazy_dfa_transducer>(b, description);
+		CPPUNIT_ASSERT(expected == run(trans));
+		auto states = trans.cache().size();
+		CPPUNIT_ASSERT(expected == run(trans));
+		CPPUNIT_ASSERT_EQUAL(states, trans.cache().size());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(0), trans.cache().flushes());
+	}
+
+	void eviction_test() {
+		buffer b;
+		auto trans = transducers::compose<transducers::finite::lazy_dfa_transducer>(b, description, 3);
+		CPPUNIT_ASSERT(expected == run(trans));
+		CPPUNIT_ASSERT(trans.cache().flushes() > 0);
+		CPPUNIT_ASSERT(trans.cache().size() <= 3);
+	}
+
+	void thread_test() {
+		buffer b;
+		auto trans = transducers::compose<transducers::finite::lazy_dfa_transducer>(b, description, 4);
+		std::vector<std::vector<int>> results(4);
+		std::vector<std::thread> threads;
+		for (std::size_t t = 0; t < results.size(); ++t) {
+			threads.emplace_back([&, t]() {
+				for (int i = 0; i < 100; ++i) {
+					results[t] = run(trans);
+				}
+			});
+		}
+		for (auto& t: threads) {
+			t.join();
+		}
+		for (const auto& r: results) {
+			CPPUNIT_ASSERT(expected == r);
+		}
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(lazy_dfa_transducer_test);
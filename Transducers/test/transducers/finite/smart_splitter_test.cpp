@@ -0,0 +1,130 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "transducers/finite/smart_splitter.h"
+#include "transducers/aggregation/symbol_buffer.h"
+#include "transducers/compose.h"
+#include "representation/xml_tokenizer.h"
+
+#include <random>
+#include <string>
+
+class smart_splitter_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(smart_splitter_test);
+	CPPUNIT_TEST(words_test);
+	CPPUNIT_TEST(shared_image_test);
+	CPPUNIT_TEST(split_test);
+	CPPUNIT_TEST(run_test);
+	CPPUNIT_TEST(xml_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp() {}
+	void tearDown() {}
+
+	// No single symbol synchronises, but "aa" always ends in state 2 and
+	// "bb" in state 0. Every transition outputs its source state.
+	smart_splitter_test() {
+		const int on_a[] = { 1, 2, 2 };
+		const int on_b[] = { 0, 0, 1 };
+		for (int s = 0; s < 3; ++s) {
+			description.transitions.insert(std::make_pair(std::make_pair(s, 'a'), on_a[s]));
+			description.transitions.insert(std::make_pair(std::make_pair(s, 'b'), on_b[s]));
+			description.output.insert(std::make_pair(std::make_pair(s, 'a'), s));
+			description.output.insert(std::make_pair(std::make_pair(s, 'b'), s));
+		}
+		description.start_state = 0;
+	}
+
+	typedef transducers::aggregation::symbol_buffer<int> buffer;
+	representation::dft_description description;
+
+	static const unsigned char* bytes(const std::string& s) {
+		return reinterpret_cast<const unsigned char*>(s.data());
+	}
+
+	void words_test() {
+		transducers::finite::smart_splitter splitter{ representation::compiled_automaton(description) };
+		CPPUNIT_ASSERT(splitter.synchronising());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(2), splitter.num_words());
+		const std::string input = "babaab";
+		CPPUNIT_ASSERT_EQUAL(-1, splitter.synchronised_state(bytes(input), bytes(input) + 1));
+		CPPUNIT_ASSERT_EQUAL(-1, splitter.synchronised_state(bytes(input), bytes(input) + 3));
+		CPPUNIT_ASSERT_EQUAL(2, splitter.synchronised_state(bytes(input), bytes(input) + 5));
+		// "aab" extends "aa", so it synchronises too
+		CPPUNIT_ASSERT_EQUAL(1, splitter.synchronised_state(bytes(input), bytes(input) + 6));
+	}
+
+	// "ad" and "bd" both end in state 0, though "a" and "b" lead to the
+	// same set of states and only one of them is kept as a word
+	void shared_image_test() {
+		representation::dft_description shared;
+		const int on_a[] = { 1, 2, 2 };
+		const int on_b[] = { 2, 1, 1 };
+		const int on_d[] = { 1, 0, 0 };
+		for (int s = 0; s < 3; ++s) {
+			shared.transitions.insert(std::make_pair(std::make_pair(s, 'a'), on_a[s]));
+			shared.transitions.insert(std::make_pair(std::make_pair(s, 'b'), on_b[s]));
+			shared.transitions.insert(std::make_pair(std::make_pair(s, 'd'), on_d[s]));
+		}
+		shared.start_state = 0;
+		transducers::finite::smart_splitter splitter{ representation::compiled_automaton(shared) };
+		CPPUNIT_ASSERT(splitter.synchronising());
+		for (std::string input: { "ad", "bd", "dbd", "aabd" }) {
+			CPPUNIT_ASSERT_EQUAL(0, splitter.synchronised_state(bytes(input), bytes(input) + input.size()));
+		}
+		const std::string d = "d";
+		CPPUNIT_ASSERT_EQUAL(-1, splitter.synchronised_state(bytes(d), bytes(d) + 1));
+
+		const std::string input = "ddddbdaaaa";
+		auto chunks = splitter.split(bytes(input), bytes(input) + input.size(), 2);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(2), chunks.size());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(6), chunks[1].begin);
+		CPPUNIT_ASSERT_EQUAL(0, chunks[1].state);
+	}
+
+	void split_test() {
+		transducers::finite::smart_splitter splitter{ representation::compiled_automaton(description) };
+		const std::string input = "abababbababaababab";
+		auto chunks = splitter.split(bytes(input), bytes(input) + input.size(), 3);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(3), chunks.size());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(0), chunks[0].begin);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(7), chunks[1].begin);
+		CPPUNIT_ASSERT_EQUAL(0, chunks[1].state);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(13), chunks[2].begin);
+		CPPUNIT_ASSERT_EQUAL(2, chunks[2].state);
+		CPPUNIT_ASSERT_EQUAL(input.size(), chunks[2].end);
+
+		// No synchronising word before the last nominal boundary
+		chunks = splitter.split(bytes(input), bytes(input) + 8, 4);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(2), chunks.size());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(7), chunks[0].end);
+	}
+
+	void run_test() {
+		std::mt19937 gen(42);
+		std::string input;
+		for (int i = 0; i < 10000; ++i) input.push_back(gen() % 2 ? 'a' : 'b');
+
+		buffer b;
+		auto trans = transducers::compose<transducers::finite::finite_transducer>(b, description);
+		transducers::finite::smart_splitter splitter(trans.automaton());
+		auto expected = trans.initial_result();
+		trans.process_block(expected, bytes(input), bytes(input) + input.size(), 0);
+		for (std::size_t blocks = 1; blocks <= 8; ++blocks) {
+			CPPUNIT_ASSERT_EQUAL(blocks, splitter.split(bytes(input), bytes(input) + input.size(), blocks).size());
+			auto pr = transducers::finite::run_split(trans, splitter, bytes(input),
+				bytes(input) + input.size(), blocks);
+			CPPUNIT_ASSERT(trans.last_stage_result(expected) == trans.last_stage_result(pr));
+		}
+	}
+
+	void xml_test() {
+		representation::xml_tokenizer tokenizer({ "item" });
+		transducers::finite::smart_splitter splitter{ representation::compiled_automaton(tokenizer.description()) };
+		CPPUNIT_ASSERT(!splitter.synchronising());
+		const std::string input = "<a><item/></a><b>text</b>";
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), splitter.split(bytes(input), bytes(input) + input.size(), 4).size());
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(smart_splitter_test);
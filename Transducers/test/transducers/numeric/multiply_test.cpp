@@ -9,6 +9,7 @@ public:
 	CPPUNIT_TEST(simple_test);
 	CPPUNIT_TEST(compose_test);
 	CPPUNIT_TEST(merge_test);
+	CPPUNIT_TEST(memory_usage_test);
 	CPPUNIT_TEST_SUITE_END();
 public:
 	void setUp() {}
@@ -45,6 +46,17 @@ public:
 		CPPUNIT_ASSERT_EQUAL(6, mult.last_stage_result(f).at(0));
 		CPPUNIT_ASSERT_EQUAL(8, mult.last_stage_result(f).at(1));
 	}
+
+	void memory_usage_test() {
+		transducers::aggregation::symbol_buffer<int> buffer;
+		auto mult1 = transducers::compose<transducers::numeric::multiply_int>(buffer, 2);
+		auto mult2 = transducers::compose<transducers::numeric::multiply_int>(mult1, 3);
+		auto f = mult2.initial_result();
+		mult2.process_symbol(f, 3, 0);
+		mult2.process_symbol(f, 4, 1);
+		const auto& result = mult2.last_stage_result(f);
+		CPPUNIT_ASSERT_EQUAL(sizeof(f) + result.capacity() * sizeof(int), mult2.memory_usage(f));
+	}
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(multiply_test);
@@ -4,6 +4,8 @@
 #include "transducers/compose.h"
 #include "data_structures/tree_state_map.h"
 
+#include <set>
+
 namespace std {
 	std::ostream& operator<<(std::ostream& s, const std::vector<uint32_t> & v) {
 		for (auto i: v) {
@@ -22,6 +24,7 @@ public:
 	CPPUNIT_TEST(transition_test);
 	CPPUNIT_TEST(discard_test);
 	CPPUNIT_TEST(simple_pop_test);
+	CPPUNIT_TEST(deep_pop_test);
 	CPPUNIT_TEST(unknown_pop_test);
 	CPPUNIT_TEST(pop_and_plain_test);
 	CPPUNIT_TEST(simple_push_test);
@@ -35,6 +38,9 @@ public:
 	CPPUNIT_TEST(simple_merge_test);
 	CPPUNIT_TEST(pop_merge_test);
 	CPPUNIT_TEST(merge_all_3_test);
+	CPPUNIT_TEST(statistics_test);
+	CPPUNIT_TEST(sampler_test);
+	CPPUNIT_TEST(memory_usage_test);
 	CPPUNIT_TEST_SUITE_END();
 public:
 	representation::dft_description description;
@@ -141,6 +147,17 @@ public:
 		CPPUNIT_ASSERT_EQUAL(t, pr1.map());
 	}
 
+	void deep_pop_test() {
+		map_type s,t;
+		add_map_entry(s, {1}, {4,1,2});
+		add_map_entry(t, {1}, {1,2}, {2});
+		buffer b;
+		auto trans = transducers::compose<TransducerType>(b, description);
+		auto pr1 = trans.map_to_result(s);
+		trans.process_symbol(pr1, 'f', 0);
+		CPPUNIT_ASSERT_EQUAL(t, pr1.map());
+	}
+
 	void unknown_pop_test() {
 		map_type s,t;
 		add_map_entry(s, {4}, {4});
@@ -339,6 +356,71 @@ public:
 			}
 		}
 	}
+
+	void statistics_test() {
+		map_type s;
+		add_map_entry(s, {1}, {1});
+		add_map_entry(s, {2}, {3,2});
+		add_map_entry(s, {3}, {3,4});
+		add_map_entry(s, {4,1}, {2});
+
+		buffer b;
+		auto trans = transducers::compose<TransducerType>(b, description);
+		auto pr1 = trans.map_to_result(s);
+		const auto stats = pr1.map().statistics();
+		CPPUNIT_ASSERT_EQUAL(std::size_t(4), pr1.map().size());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(4), stats.entries);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(2), stats.max_start_depth());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(3), stats.start_depths[1]);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), stats.start_depths[2]);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(2), stats.max_finish_depth());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(2), stats.finish_depths[1]);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(2), stats.finish_depths[2]);
+		CPPUNIT_ASSERT(stats.start_nodes >= 4);
+		CPPUNIT_ASSERT(stats.finish_nodes >= 4);
+		CPPUNIT_ASSERT(stats.bytes > 0);
+	}
+
+	void sampler_test() {
+		buffer b;
+		auto trans = transducers::compose<TransducerType>(b, description);
+		std::vector<std::size_t> offsets;
+		std::vector<std::size_t> sizes;
+		trans.set_sampler([&](std::size_t offset, const map_type& m) {
+			offsets.push_back(offset);
+			sizes.push_back(m.size());
+		}, 2);
+
+		auto pr1 = trans.identity_result();
+		const char* input = "fafe";
+		for (std::size_t i = 0; i < 4; ++i) {
+			trans.process_symbol(pr1, input[i], i);
+		}
+		CPPUNIT_ASSERT_EQUAL(std::size_t(2), offsets.size());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(0), offsets[0]);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(2), offsets[1]);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(3), sizes[0]);
+		CPPUNIT_ASSERT_EQUAL(pr1.map().statistics().entries, pr1.map().size());
+
+		trans.set_sampler(nullptr);
+		trans.process_symbol(pr1, 'a', 4);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(2), offsets.size());
+	}
+
+	void memory_usage_test() {
+		map_type s, t;
+		add_map_entry(s, {1}, {1});
+		add_map_entry(s, {2}, {3,2});
+		add_map_entry(t, {1}, {1}, {1, 2, 3, 4});
+		add_map_entry(t, {2}, {3,2}, {5, 6, 7, 8});
+
+		buffer b;
+		auto trans = transducers::compose<TransducerType>(b, description);
+		auto pr1 = trans.map_to_result(s);
+		auto pr2 = trans.map_to_result(t);
+		CPPUNIT_ASSERT(trans.memory_usage(pr1) >= pr1.map().statistics().bytes);
+		CPPUNIT_ASSERT_EQUAL(trans.memory_usage(pr1) + 8 * sizeof(uint32_t), trans.memory_usage(pr2));
+	}
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(state_map_pushdown_transducer_test<data_structures::pushdown_state_map>);
@@ -3,6 +3,9 @@
 #include "transducers/finite/finite_transducer.h"
 #include "transducers/aggregation/symbol_buffer.h"
 #include "transducers/compose.h"
+#include "transducers/process_block.h"
+
+#include <string>
 
 class buffer_transducer_test : public CppUnit::TestFixture {
 public:
@@ -10,6 +13,8 @@ public:
 	CPPUNIT_TEST(buffer_simple_test);
 	CPPUNIT_TEST(transducer_test);
 	CPPUNIT_TEST(double_transducer_test);
+	CPPUNIT_TEST(pending_test);
+	CPPUNIT_TEST(block_test);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -97,6 +102,47 @@ public:
 		CPPUNIT_ASSERT_EQUAL(20, terms[0]);
 		CPPUNIT_ASSERT_EQUAL(20, terms[1]);
 	}
+
+	void pending_test() {
+		transducers::util::pending_symbols<unsigned short> lhs;
+		const unsigned short block[] = { 1, 2, 3, 4 };
+		lhs.append(block, block + 4, 1000);
+		lhs.push_back(5, 1004);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), lhs.num_runs());
+
+		transducers::util::pending_symbols<unsigned short> rhs;
+		rhs.push_back(6, 1005);
+		rhs.push_back(7, 2000);
+		lhs.append(rhs);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(7), lhs.size());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(2), lhs.num_runs());
+
+		std::vector<std::pair<unsigned short, std::size_t>> replayed;
+		lhs.for_each_run([&](const unsigned short* b, const unsigned short* e, std::size_t offset) {
+			for (; b != e; ++b, ++offset) replayed.emplace_back(*b, offset);
+		});
+		CPPUNIT_ASSERT_EQUAL(std::size_t(7), replayed.size());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1005), replayed[5].second);
+		CPPUNIT_ASSERT_EQUAL((unsigned short)7, replayed[6].first);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(2000), replayed[6].second);
+	}
+
+	void block_test() {
+		agg_buffer b;
+		auto buffer = transducers::compose<transducers::util::buffer_transducer>(b, 'a');
+		const std::string input = "xbcabcyabcz";
+		for (std::size_t split = 0; split <= input.size(); ++split) {
+			auto lhs = buffer.initial_result();
+			auto rhs = buffer.identity_result();
+			transducers::process_block(buffer, lhs, input.begin(), input.begin() + split, 0);
+			transducers::process_block(buffer, rhs, input.begin() + split, input.end(), split);
+			buffer.merge_results(lhs, rhs);
+			const auto& terms = buffer.last_stage_result(lhs);
+			// Symbols before the first trigger stay pending in the leftmost result
+			CPPUNIT_ASSERT_EQUAL(std::size_t(3), buffer.unwrap(lhs).second.size());
+			CPPUNIT_ASSERT_EQUAL(std::string("abcyabcz"), std::string(terms.begin(), terms.end()));
+		}
+	}
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(buffer_transducer_test);
@@ -0,0 +1,101 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "transducers/util/byte_classifier.h"
+#include "transducers/finite/finite_transducer.h"
+#include "transducers/aggregation/symbol_buffer.h"
+#include "transducers/compose.h"
+#include "representation/xml_tokenizer.h"
+
+#include <string>
+#include <vector>
+
+using transducers::util::byte_classifier;
+using transducers::finite::finite_transducer;
+
+class byte_classifier_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(byte_classifier_test);
+	CPPUNIT_TEST(table_test);
+	CPPUNIT_TEST(classify_test);
+	CPPUNIT_TEST(tokenizer_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp() {}
+	void tearDown() {}
+
+	byte_classifier_test():
+		automaton(representation::xml_tokenizer({ "a", "item" }).description()) {
+		text = "<?xml version=\"1.0\"?><root>";
+		for (int i = 0; i < 30; ++i) {
+			text += "<item id=\"" + std::to_string(i) + "\"><a/>" + std::string(i * 3, 'x');
+			text += "<!-- \xe2\x82\xac -->\t</item>\n";
+		}
+		text += "</root>";
+	}
+
+	typedef transducers::aggregation::symbol_buffer<unsigned short> class_buffer;
+	typedef transducers::aggregation::symbol_buffer<int> buffer;
+	representation::compiled_automaton automaton;
+	std::string text;
+
+	const unsigned char* data() const {
+		return reinterpret_cast<const unsigned char*>(text.data());
+	}
+
+	void table_test() {
+		std::array<unsigned char, 256> entries;
+		for (int c = 0; c < 256; ++c) {
+			entries[c] = c < 0x80 ? c % 5 : (c >= 0xf0 ? 7 : 0);
+		}
+		::util::byte_table table(entries);
+		// Rows 0-7 repeat every fifth row, rows 8-e are zero and row f is 7s
+		CPPUNIT_ASSERT_EQUAL(std::size_t(6), table.num_rows());
+
+		unsigned char input[256], output[256];
+		for (int c = 0; c < 256; ++c) input[c] = (c * 37 + 11) & 0xff;
+		for (int i = 0; i < 256; i += 64) table.lookup(input + i, output + i);
+		for (int c = 0; c < 256; ++c) {
+			CPPUNIT_ASSERT_EQUAL(entries[input[c]], output[c]);
+			CPPUNIT_ASSERT_EQUAL(entries[input[c]], table[input[c]]);
+		}
+	}
+
+	void classify_test() {
+		class_buffer b;
+		byte_classifier<class_buffer> classifier(b, automaton);
+		auto pr = classifier.initial_result();
+		classifier.process_block(pr, data(), data() + text.size(), 0);
+		const auto& result = classifier.last_stage_result(pr);
+		CPPUNIT_ASSERT_EQUAL(text.size(), result.size());
+		for (std::size_t i = 0; i < text.size(); ++i) {
+			CPPUNIT_ASSERT_EQUAL(static_cast<unsigned short>(automaton.symbol_class(data()[i])), result[i]);
+		}
+	}
+
+	// The tokenizer over classes outputs what it does over bytes, for
+	// blocks classified both 64 bytes and one byte at a time
+	void tokenizer_test() {
+		buffer b1;
+		finite_transducer<buffer> bytes(b1, automaton);
+		auto pr1 = bytes.initial_result();
+		for (std::size_t i = 0; i < text.size(); ++i) {
+			bytes.process_symbol(pr1, data()[i], i);
+		}
+		CPPUNIT_ASSERT(!bytes.last_stage_result(pr1).empty());
+
+		for (std::size_t split: { std::size_t(0), std::size_t(100), text.size() - 5 }) {
+			buffer b2;
+			finite_transducer<buffer> tokenizer(b2, automaton.over_classes());
+			auto classifier = transducers::compose<byte_classifier>(tokenizer, automaton);
+			auto pr2 = classifier.initial_result();
+			for (std::size_t i = 0; i < split; ++i) {
+				classifier.process_symbol(pr2, data()[i], i);
+			}
+			classifier.process_block(pr2, data() + split, data() + text.size(), split);
+			CPPUNIT_ASSERT_EQUAL(pr1.first, pr2.second.first);
+			CPPUNIT_ASSERT(bytes.last_stage_result(pr1) == classifier.last_stage_result(pr2));
+		}
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(byte_classifier_test);
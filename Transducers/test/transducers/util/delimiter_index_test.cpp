@@ -0,0 +1,76 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "transducers/util/delimiter_index.h"
+#include "transducers/aggregation/offset_buffer.h"
+#include "transducers/aggregation/symbol_buffer.h"
+#include "transducers/compose.h"
+#include "transducers/parallel.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using transducers::util::delimiter_index;
+
+class delimiter_index_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(delimiter_index_test);
+	CPPUNIT_TEST(simple_test);
+	CPPUNIT_TEST(block_test);
+	CPPUNIT_TEST(parallel_test);
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp() {}
+	void tearDown() {}
+
+	delimiter_index_test() {
+		for (int i = 0; i < 50; ++i) {
+			input += "line " + std::to_string(i) + std::string(i % 7 * 5, 'x') + (i % 4 ? "\n" : "\r\n");
+		}
+		for (std::size_t i = 0; i < input.size(); ++i) {
+			if (input[i] == '\n') newlines.push_back(i);
+			if (input[i] == '\n' || input[i] == '\r') line_ends.push_back(i);
+		}
+	}
+
+	std::string input;
+	std::vector<std::size_t> newlines;
+	std::vector<std::size_t> line_ends;
+
+	void simple_test() {
+		transducers::aggregation::symbol_buffer<std::size_t> b;
+		auto trans = transducers::compose<delimiter_index>(b);
+		auto pr = trans.initial_result();
+		for (std::size_t i = 0; i < input.size(); ++i) {
+			trans.process_symbol(pr, input[i], i);
+		}
+		CPPUNIT_ASSERT(newlines == trans.last_stage_result(pr));
+		CPPUNIT_ASSERT_THROW(transducers::compose<delimiter_index>(b, ""), std::invalid_argument);
+	}
+
+	void block_test() {
+		transducers::aggregation::offset_buffer b;
+		auto trans = transducers::compose<delimiter_index>(b, "\r\n");
+		const auto* data = reinterpret_cast<const unsigned char*>(input.data());
+		for (std::size_t start = 0; start < 70; ++start) {
+			auto pr = trans.identity_result();
+			trans.process_block(pr, data + start, data + input.size(), start);
+			std::vector<std::size_t> expected(std::lower_bound(line_ends.begin(), line_ends.end(), start),
+				line_ends.end());
+			CPPUNIT_ASSERT(expected == trans.last_stage_result(pr).offsets());
+		}
+	}
+
+	void parallel_test() {
+		transducers::aggregation::offset_buffer b;
+		auto trans = transducers::compose<delimiter_index>(b);
+		const auto* data = reinterpret_cast<const unsigned char*>(input.data());
+		for (std::size_t blocks = 1; blocks <= 16; ++blocks) {
+			auto pr = transducers::run_parallel(trans, data, data + input.size(), blocks);
+			CPPUNIT_ASSERT(newlines == trans.last_stage_result(pr).offsets());
+		}
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(delimiter_index_test);
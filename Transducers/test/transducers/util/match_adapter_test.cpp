@@ -44,6 +44,7 @@ public:
 	CPPUNIT_TEST_SUITE(match_adapter_test);
 	CPPUNIT_TEST(simple_test);
 	CPPUNIT_TEST(two_fragment_test);
+	CPPUNIT_TEST(three_fragment_test);
 	CPPUNIT_TEST_SUITE_END();
 public:
 	void setUp() {}
@@ -90,6 +91,35 @@ public:
 			}
 		}
 	}
+
+	void three_fragment_test() {
+		match_buffer matches;
+		auto adapter = compose<match_adapter>(matches);
+
+		for (std::size_t first = 0; first <= test_input.size(); ++first) {
+			for (std::size_t second = first; second <= test_input.size(); ++second) {
+				auto f = adapter.initial_result();
+				auto f1 = adapter.identity_result();
+				auto f2 = adapter.identity_result();
+				auto f3 = adapter.identity_result();
+
+				std::size_t offset = 0;
+				for (const auto& i: test_input) {
+					adapter.process_symbol(offset < first ? f1 : offset < second ? f2 : f3, i, offset);
+					++offset;
+				}
+				adapter.merge_results(f2, f3);
+				adapter.merge_results(f1, f2);
+				adapter.merge_results(f, f1);
+				auto matches = adapter.last_stage_result(f);
+				sort_matches(matches);
+				CPPUNIT_ASSERT_EQUAL(test_output.size(), matches.size());
+				for (std::size_t i = 0; i != test_output.size(); ++i) {
+					CPPUNIT_ASSERT_EQUAL(test_output[i], matches[i]);
+				}
+			}
+		}
+	}
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(match_adapter_test);
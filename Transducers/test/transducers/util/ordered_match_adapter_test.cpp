@@ -0,0 +1,106 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <transducers/util/ordered_match_adapter.h>
+#include <transducers/aggregation/stream_sink.h>
+#include <transducers/aggregation/symbol_buffer.h>
+#include <transducers/compose.h>
+
+#include <vector>
+
+using namespace transducers;
+using namespace transducers::util;
+using namespace symbols;
+
+namespace {
+	std::vector<uint32_t> ordered_input = {
+		0x80000001, // 0
+		0x80000002, // 1
+		0xC0000003, // 2
+		0x40000002, // 3
+		0xC0000004, // 4
+		0x80000005, // 5
+		0x40000005, // 6
+		0x40000001, // 7
+		0x80000006, // 8
+		0x40000006  // 9
+	};
+	std::vector<symbols::match> ordered_output = {
+		match{ 1, 0, 7},
+		match{ 2, 1, 3},
+		match{ 3, 2, 2},
+		match{ 4, 4, 4},
+		match{ 5, 5, 6},
+		match{ 6, 8, 9}
+	};
+}
+
+class ordered_match_adapter_test : public CppUnit::TestFixture {
+public:
+	CPPUNIT_TEST_SUITE(ordered_match_adapter_test);
+	CPPUNIT_TEST(simple_test);
+	CPPUNIT_TEST(fragment_test);
+	CPPUNIT_TEST(stream_test);
+	CPPUNIT_TEST_SUITE_END();
+public:
+	void setUp() {}
+	void tearDown() {}
+	typedef transducers::aggregation::symbol_buffer<symbols::match> match_buffer;
+
+	void simple_test() {
+		match_buffer matches;
+		auto adapter = compose<ordered_match_adapter>(matches);
+		auto f = adapter.initial_result();
+		std::size_t offset = 0;
+		for (const auto& i: ordered_input) {
+			adapter.process_symbol(f, i, offset++);
+			// Nothing is output while the match at 0 is open
+			if (offset == 7) CPPUNIT_ASSERT(adapter.last_stage_result(f).empty());
+		}
+		CPPUNIT_ASSERT(adapter.last_stage_result(f) == ordered_output);
+		CPPUNIT_ASSERT(f.first.held.empty());
+	}
+
+	// Every split into three blocks, merged left first and right first
+	void fragment_test() {
+		match_buffer matches;
+		auto adapter = compose<ordered_match_adapter>(matches);
+		for (std::size_t first = 0; first <= ordered_input.size(); ++first) {
+			for (std::size_t second = first; second <= ordered_input.size(); ++second) {
+				for (bool left_first: { true, false }) {
+					auto f1 = adapter.initial_result();
+					auto f2 = adapter.identity_result();
+					auto f3 = adapter.identity_result();
+					std::size_t offset = 0;
+					for (const auto& i: ordered_input) {
+						adapter.process_symbol(offset < first ? f1 : offset < second ? f2 : f3, i, offset);
+						++offset;
+					}
+					if (left_first) {
+						adapter.merge_results(f1, f2);
+						adapter.merge_results(f1, f3);
+					} else {
+						adapter.merge_results(f2, f3);
+						adapter.merge_results(f1, f2);
+					}
+					CPPUNIT_ASSERT(adapter.last_stage_result(f1) == ordered_output);
+				}
+			}
+		}
+	}
+
+	// Matches reach a streaming sink as soon as their order is known
+	void stream_test() {
+		std::vector<symbols::match> out;
+		transducers::aggregation::stream_sink<symbols::match> sink(
+			[&](const symbols::match& m) { out.push_back(m); });
+		auto adapter = compose<ordered_match_adapter>(sink);
+		auto f1 = adapter.initial_result();
+		auto f2 = adapter.identity_result();
+		for (std::size_t i = 0; i < 8; ++i) adapter.process_symbol(i < 5 ? f1 : f2, ordered_input[i], i);
+		CPPUNIT_ASSERT(out.empty());
+		adapter.merge_results(f1, f2);
+		CPPUNIT_ASSERT(out == std::vector<symbols::match>(ordered_output.begin(), ordered_output.end() - 1));
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ordered_match_adapter_test);